@@ -12,14 +12,26 @@ from load_data import (
     LIFECYCLE_ORDER,
     ROOT,
     load_benchmark_rows,
+    load_block_size_rows,
     load_lifecycle_traces,
+    load_scaling_rows,
+    load_tail_rows,
 )
 
 OUT_PATH = ROOT / "index.html"
 
 
-def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
+def build_html(
+    benchmark_rows: list[dict],
+    traces: dict[str, dict],
+    scaling_rows: list[dict],
+    tail_rows: list[dict],
+    block_size_rows: list[dict],
+) -> str:
     benchmark_payload = json.dumps(benchmark_rows, separators=(",", ":"))
+    scaling_payload = json.dumps(scaling_rows, separators=(",", ":"))
+    tail_payload = json.dumps(tail_rows, separators=(",", ":"))
+    block_size_payload = json.dumps(block_size_rows, separators=(",", ":"))
     trace_payload = json.dumps(traces, separators=(",", ":"))
     benchmark_labels = json.dumps(BENCHMARK_LABELS)
     benchmark_order = json.dumps(BENCHMARK_ORDER)
@@ -598,21 +610,101 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
         </div>
       </div>
 
+      <div class="panel">
+        <h2>Peak memory vs allocation count</h2>
+        <div class="chart-wrap">
+          <canvas id="memory-chart"></canvas>
+        </div>
+        <p class="metric-sub">
+          Mapped: bytes the allocator holds from the OS (malloc via <code>mallinfo2</code>).
+          RSS: growth of the process's resident set during the run. Requested: peak live bytes the workload asked for.
+        </p>
+      </div>
+
       <div class="panel">
         <h2>All scenarios at peak scale</h2>
         <table>
           <thead>
-            <tr>
+            <tr id="summary-head">
               <th>Scenario</th>
               <th>Custom (ms)</th>
               <th>System (ms)</th>
               <th>Ratio</th>
               <th>Winner</th>
+              <th>Custom mapped/live</th>
+              <th>System mapped/live</th>
+              <th>Custom RSS/live</th>
+              <th>System RSS/live</th>
             </tr>
           </thead>
           <tbody id="summary-body"></tbody>
         </table>
       </div>
+
+      <div class="panel">
+        <h2>Thread scaling</h2>
+        <div id="scaling-empty" class="empty-state">
+          <p>No scaling data. Run <code>./allocator_test scale</code>, then regenerate.</p>
+        </div>
+        <div id="scaling-content">
+          <div class="controls">
+            <div>
+              <label for="scaling-select">Workload</label><br />
+              <select id="scaling-select"></select>
+            </div>
+            <div class="metric-sub" id="scaling-note"></div>
+          </div>
+          <div class="chart-wrap">
+            <canvas id="scaling-chart"></canvas>
+          </div>
+        </div>
+      </div>
+
+      <div class="panel">
+        <h2>Tail latency</h2>
+        <div id="tail-empty" class="empty-state">
+          <p>No tail-latency data. Run <code>./allocator_test tail</code>, then regenerate.</p>
+        </div>
+        <div id="tail-content">
+          <div class="controls">
+            <div>
+              <label for="tail-workload-select">Workload</label><br />
+              <select id="tail-workload-select"></select>
+            </div>
+            <div>
+              <label for="tail-op-select">Call</label><br />
+              <select id="tail-op-select"></select>
+            </div>
+            <div class="metric-sub">
+              Solid: response time from the scheduled start. Dashed: the call alone.
+            </div>
+          </div>
+          <div class="chart-wrap">
+            <canvas id="tail-chart"></canvas>
+          </div>
+        </div>
+      </div>
+
+      <div class="panel">
+        <h2>Block-size sweep</h2>
+        <div id="sizes-empty" class="empty-state">
+          <p>No block-size data. Run <code>./allocator_test sizes</code>, then regenerate.</p>
+        </div>
+        <div id="sizes-content">
+          <div class="controls">
+            <div>
+              <label for="sizes-select">Scenario</label><br />
+              <select id="sizes-select"></select>
+            </div>
+            <div class="metric-sub">
+              Solid: throughput. Dashed: requested bytes over the pages (custom) or chunks (malloc) holding them.
+            </div>
+          </div>
+          <div class="chart-wrap">
+            <canvas id="sizes-chart"></canvas>
+          </div>
+        </div>
+      </div>
     </div>
 
     <div id="view-lifecycle" class="view">{lifecycle_body}
@@ -626,6 +718,9 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
   <script>
     const BENCHMARK_DATA = {benchmark_payload};
     const TRACE_DATA = {trace_payload};
+    const SCALING_DATA = {scaling_payload};
+    const TAIL_DATA = {tail_payload};
+    const BLOCK_SIZE_DATA = {block_size_payload};
     const BENCHMARK_LABELS = {benchmark_labels};
     const BENCHMARK_ORDER = {benchmark_order};
     const LIFECYCLE_LABELS = {lifecycle_labels};
@@ -643,6 +738,10 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
       if (name === "benchmark") {{
         document.getElementById("header-subtitle").textContent = DEFAULT_SUBTITLE;
         if (lineChart) lineChart.resize();
+        if (memoryChart) memoryChart.resize();
+        if (scalingChart) scalingChart.resize();
+        if (tailChart) tailChart.resize();
+        if (sizesChart) sizesChart.resize();
       }} else if (name === "lifecycle") {{
         if (HAS_TRACES && !lifecycleInitialized) initLifecycle();
         if (HAS_TRACES) resizeLifecycleCharts();
@@ -659,15 +758,24 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
       return String(n);
     }}
 
+    // Allocator plugins (jemalloc, tcmalloc, ...) that appear in results.csv besides custom/system.
+    const OTHER_ALLOCATORS = [...new Set(BENCHMARK_DATA.map((r) => r.allocator_type))].filter(
+      (name) => name !== "custom" && name !== "system"
+    );
+    const OTHER_COLORS = ["#58a6ff", "#d2a8ff", "#ff7b72", "#e3b341", "#79c0ff"];
+
     function groupByBenchmark(rows) {{
       const map = {{}};
       for (const row of rows) {{
         if (!map[row.benchmark_type]) map[row.benchmark_type] = {{ custom: [], system: [] }};
-        map[row.benchmark_type][row.allocator_type].push(row);
+        const series = map[row.benchmark_type];
+        if (!series[row.allocator_type]) series[row.allocator_type] = [];
+        series[row.allocator_type].push(row);
       }}
       for (const key of Object.keys(map)) {{
-        map[key].custom.sort((a, b) => a.num_allocations - b.num_allocations);
-        map[key].system.sort((a, b) => a.num_allocations - b.num_allocations);
+        for (const name of Object.keys(map[key])) {{
+          map[key][name].sort((a, b) => a.num_allocations - b.num_allocations);
+        }}
       }}
       return map;
     }}
@@ -750,6 +858,17 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
               tension: 0.2,
               pointRadius: 4,
             }},
+            ...OTHER_ALLOCATORS.map((name, i) => ({{
+              label: name,
+              data: series.custom.map((c) => {{
+                const row = (series[name] || []).find((r) => r.num_allocations === c.num_allocations);
+                return row ? row.time_ms : null;
+              }}),
+              borderColor: OTHER_COLORS[i % OTHER_COLORS.length],
+              borderDash: [6, 4],
+              tension: 0.2,
+              pointRadius: 3,
+            }})),
           ],
         }},
         options: {{
@@ -776,6 +895,12 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
     }}
 
     function buildSummaryTable() {{
+      const head = document.getElementById("summary-head");
+      OTHER_ALLOCATORS.forEach((name) => {{
+        const th = document.createElement("th");
+        th.textContent = name + " (ms)";
+        head.appendChild(th);
+      }});
       const tbody = document.getElementById("summary-body");
       tbody.innerHTML = "";
       const maxOps = Math.max(...BENCHMARK_DATA.map((r) => r.num_allocations));
@@ -791,19 +916,368 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
           <td class="num">${{custom.time_ms}}</td>
           <td class="num">${{system.time_ms}}</td>
           <td class="num">${{Number.isFinite(r) ? r.toFixed(2) + "×" : "—"}}</td>
-          <td>${{r < 1 ? '<span class="speedup-win">Custom</span>' : r > 1 ? '<span class="speedup-lose">System</span>' : "Tie"}}</td>`;
+          <td>${{r < 1 ? '<span class="speedup-win">Custom</span>' : r > 1 ? '<span class="speedup-lose">System</span>' : "Tie"}}</td>
+          <td class="num">${{formatRatio(custom.mapped_live_ratio)}}</td>
+          <td class="num">${{formatRatio(system.mapped_live_ratio)}}</td>
+          <td class="num">${{formatRatio(custom.rss_live_ratio)}}</td>
+          <td class="num">${{formatRatio(system.rss_live_ratio)}}</td>`;
+        OTHER_ALLOCATORS.forEach((name) => {{
+          const other = (grouped[key][name] || []).find((row) => row.num_allocations === maxOps);
+          const td = document.createElement("td");
+          td.className = "num";
+          td.textContent = other ? other.time_ms : "—";
+          tr.appendChild(td);
+        }});
         tbody.appendChild(tr);
       }});
     }}
 
+    // Memory ratios are 0 when unknown (no requested-bytes figure, or an allocator without mapped bytes).
+    function formatRatio(value) {{
+      return value > 0 ? value.toFixed(2) + "×" : "—";
+    }}
+
+    function formatMB(bytes) {{
+      return (bytes / (1024 * 1024)).toFixed(bytes >= 10 * 1024 * 1024 ? 0 : 1) + " MB";
+    }}
+
+    let memoryChart = null;
+
+    function buildMemoryChart() {{
+      const series = currentSeries();
+      const labels = series.custom.map((r) => formatOps(r.num_allocations));
+      const mapped = (rows) => rows.map((r) => (r.peak_mapped_bytes > 0 ? r.peak_mapped_bytes : null));
+      if (memoryChart) memoryChart.destroy();
+      memoryChart = new Chart(document.getElementById("memory-chart"), {{
+        type: "line",
+        data: {{
+          labels,
+          datasets: [
+            {{
+              label: "Requested (live)",
+              data: series.custom.map((r) => r.peak_live_bytes || null),
+              borderColor: "#8b949e",
+              borderDash: [2, 3],
+              pointRadius: 2,
+            }},
+            {{
+              label: "Custom mapped",
+              data: mapped(series.custom),
+              borderColor: "#3fb950",
+              tension: 0.2,
+              pointRadius: 4,
+            }},
+            {{
+              label: "System mapped",
+              data: mapped(series.system),
+              borderColor: "#f0883e",
+              tension: 0.2,
+              pointRadius: 4,
+            }},
+            {{
+              label: "Custom RSS growth",
+              data: series.custom.map((r) => r.rss_growth_bytes),
+              borderColor: "#3fb950",
+              borderDash: [6, 4],
+              pointRadius: 2,
+            }},
+            {{
+              label: "System RSS growth",
+              data: series.system.map((r) => r.rss_growth_bytes),
+              borderColor: "#f0883e",
+              borderDash: [6, 4],
+              pointRadius: 2,
+            }},
+          ],
+        }},
+        options: {{
+          responsive: true,
+          maintainAspectRatio: false,
+          plugins: {{
+            legend: {{ labels: {{ color: "#e6edf3" }} }},
+          }},
+          scales: {{
+            x: {{
+              title: {{ display: true, text: "Allocations", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e" }},
+              grid: {{ color: "#2a3544" }},
+            }},
+            y: {{
+              title: {{ display: true, text: "Bytes at peak", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e", callback: (value) => formatMB(value) }},
+              grid: {{ color: "#2a3544" }},
+              beginAtZero: true,
+            }},
+          }},
+        }},
+      }});
+    }}
+
     benchSelect.addEventListener("change", () => {{
       buildLineChart();
+      buildMemoryChart();
       updateCards();
     }});
 
+    // Thread scaling: Mops/s per thread count, one line per allocator and sharing mode.
+    let scalingChart = null;
+    const scalingSelect = document.getElementById("scaling-select");
+    const SCALING_COLORS = {{
+      "custom/shared": "#3fb950",
+      "custom/per_thread": "#a5d6a7",
+      "system/shared": "#f0883e",
+    }};
+
+    function buildScalingChart() {{
+      const rows = SCALING_DATA.filter((r) => r.workload === scalingSelect.value);
+      const threads = [...new Set(rows.map((r) => r.threads))].sort((a, b) => a - b);
+      const series = [...new Set(rows.map((r) => r.allocator + "/" + r.sharing))];
+      if (scalingChart) scalingChart.destroy();
+      scalingChart = new Chart(document.getElementById("scaling-chart"), {{
+        type: "line",
+        data: {{
+          labels: threads.map(String),
+          datasets: series.map((key, i) => {{
+            const [allocator, sharing] = key.split("/");
+            return {{
+              label: allocator + (sharing === "per_thread" ? " (per-thread)" : " (shared)"),
+              data: threads.map((n) => {{
+                const row = rows.find((r) => r.threads === n && r.allocator + "/" + r.sharing === key);
+                return row ? row.mops_per_sec : null;
+              }}),
+              borderColor: SCALING_COLORS[key] || OTHER_COLORS[i % OTHER_COLORS.length],
+              borderDash: SCALING_COLORS[key] ? [] : [6, 4],
+              tension: 0.2,
+              pointRadius: 4,
+            }};
+          }}),
+        }},
+        options: {{
+          responsive: true,
+          maintainAspectRatio: false,
+          plugins: {{
+            legend: {{ labels: {{ color: "#e6edf3" }} }},
+          }},
+          scales: {{
+            x: {{
+              title: {{ display: true, text: "Threads", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e" }},
+              grid: {{ color: "#2a3544" }},
+            }},
+            y: {{
+              title: {{ display: true, text: "Throughput (Mops/s, all threads)", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e" }},
+              grid: {{ color: "#2a3544" }},
+              beginAtZero: true,
+            }},
+          }},
+        }},
+      }});
+    }}
+
+    function initScaling() {{
+      if (SCALING_DATA.length === 0) {{
+        document.getElementById("scaling-content").style.display = "none";
+        return;
+      }}
+      document.getElementById("scaling-empty").style.display = "none";
+      [...new Set(SCALING_DATA.map((r) => r.workload))].forEach((key) => {{
+        const opt = document.createElement("option");
+        opt.value = key;
+        opt.textContent = key.replace(/_/g, " ");
+        scalingSelect.appendChild(opt);
+      }});
+      const maxThreads = Math.max(...SCALING_DATA.map((r) => r.threads));
+      document.getElementById("scaling-note").textContent =
+        "pinning: " + SCALING_DATA[0].pinning + " · last point is " + maxThreads +
+        " threads (2× the cores)";
+      scalingSelect.addEventListener("change", buildScalingChart);
+      buildScalingChart();
+    }}
+
+    // Tail latency: latency at each percentile; x is log10(1 / (1 - q)), so 90%,
+    // 99%, 99.9%, ... are evenly spaced. The max (q = 1) has no place on it.
+    let tailChart = null;
+    const tailWorkloadSelect = document.getElementById("tail-workload-select");
+    const tailOpSelect = document.getElementById("tail-op-select");
+
+    function percentileLabel(value) {{
+      if (!Number.isInteger(value)) return "";
+      return value === 0 ? "0%" : (100 - Math.pow(10, 2 - value)).toFixed(Math.max(value - 2, 0)) + "%";
+    }}
+
+    function buildTailChart() {{
+      const rows = TAIL_DATA.filter(
+        (r) => r.workload === tailWorkloadSelect.value && r.op === tailOpSelect.value && r.quantile < 1
+      );
+      const series = [...new Set(rows.map((r) => r.allocator + "/" + r.kind))];
+      const allocators = [...new Set(rows.map((r) => r.allocator))];
+      if (tailChart) tailChart.destroy();
+      tailChart = new Chart(document.getElementById("tail-chart"), {{
+        type: "line",
+        data: {{
+          datasets: series.map((key) => {{
+            const [allocator, kind] = key.split("/");
+            const color =
+              allocator === "custom" ? "#3fb950"
+              : allocator === "system" ? "#f0883e"
+              : OTHER_COLORS[allocators.indexOf(allocator) % OTHER_COLORS.length];
+            return {{
+              label: allocator + (kind === "response" ? " (response)" : " (service)"),
+              data: rows
+                .filter((r) => r.allocator + "/" + r.kind === key)
+                .map((r) => ({{ x: Math.log10(1 / (1 - r.quantile)), y: Math.max(r.latency_ns, 1) }})),
+              borderColor: color,
+              borderDash: kind === "response" ? [] : [6, 4],
+              pointRadius: 2,
+            }};
+          }}),
+        }},
+        options: {{
+          responsive: true,
+          maintainAspectRatio: false,
+          plugins: {{
+            legend: {{ labels: {{ color: "#e6edf3" }} }},
+          }},
+          scales: {{
+            x: {{
+              type: "linear",
+              min: 0,
+              title: {{ display: true, text: "Percentile", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e", stepSize: 1, callback: percentileLabel }},
+              grid: {{ color: "#2a3544" }},
+            }},
+            y: {{
+              type: "logarithmic",
+              title: {{ display: true, text: "Latency (ns)", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e" }},
+              grid: {{ color: "#2a3544" }},
+            }},
+          }},
+        }},
+      }});
+    }}
+
+    function initTail() {{
+      if (TAIL_DATA.length === 0) {{
+        document.getElementById("tail-content").style.display = "none";
+        return;
+      }}
+      document.getElementById("tail-empty").style.display = "none";
+      [...new Set(TAIL_DATA.map((r) => r.workload))].forEach((key) => {{
+        const opt = document.createElement("option");
+        opt.value = key;
+        opt.textContent = key.replace(/_/g, " ");
+        tailWorkloadSelect.appendChild(opt);
+      }});
+      [...new Set(TAIL_DATA.map((r) => r.op))].forEach((key) => {{
+        const opt = document.createElement("option");
+        opt.value = key;
+        opt.textContent = key === "alloc" ? "allocate" : "deallocate";
+        tailOpSelect.appendChild(opt);
+      }});
+      tailWorkloadSelect.addEventListener("change", buildTailChart);
+      tailOpSelect.addEventListener("change", buildTailChart);
+      buildTailChart();
+    }}
+
+    // Block-size sweep: Mops/s (left axis) and page/chunk utilization (right axis) per block size.
+    let sizesChart = null;
+    const sizesSelect = document.getElementById("sizes-select");
+
+    function buildSizesChart() {{
+      const rows = BLOCK_SIZE_DATA.filter((r) => r.benchmark === sizesSelect.value);
+      const sizes = [...new Set(rows.map((r) => r.block_size))].sort((a, b) => a - b);
+      const allocators = [...new Set(rows.map((r) => r.allocator))];
+      const colorOf = (allocator, i) =>
+        allocator === "custom" ? "#3fb950"
+        : allocator === "system" ? "#f0883e"
+        : OTHER_COLORS[i % OTHER_COLORS.length];
+      const pick = (allocator, size) => rows.find((r) => r.allocator === allocator && r.block_size === size);
+      const datasets = [];
+      allocators.forEach((allocator, i) => {{
+        datasets.push({{
+          label: allocator + " Mops/s",
+          data: sizes.map((size) => {{
+            const row = pick(allocator, size);
+            return row ? row.mops_per_sec : null;
+          }}),
+          borderColor: colorOf(allocator, i),
+          yAxisID: "y",
+          tension: 0.2,
+          pointRadius: 4,
+        }});
+        datasets.push({{
+          label: allocator + " utilization",
+          data: sizes.map((size) => {{
+            const row = pick(allocator, size);
+            return row && row.utilization > 0 ? row.utilization * 100 : null;
+          }}),
+          borderColor: colorOf(allocator, i),
+          borderDash: [6, 4],
+          yAxisID: "y2",
+          pointRadius: 2,
+        }});
+      }});
+      if (sizesChart) sizesChart.destroy();
+      sizesChart = new Chart(document.getElementById("sizes-chart"), {{
+        type: "line",
+        data: {{ labels: sizes.map((size) => size + " B"), datasets }},
+        options: {{
+          responsive: true,
+          maintainAspectRatio: false,
+          plugins: {{
+            legend: {{ labels: {{ color: "#e6edf3" }} }},
+          }},
+          scales: {{
+            x: {{
+              title: {{ display: true, text: "Block size", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e" }},
+              grid: {{ color: "#2a3544" }},
+            }},
+            y: {{
+              position: "left",
+              title: {{ display: true, text: "Throughput (Mops/s)", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e" }},
+              grid: {{ color: "#2a3544" }},
+              beginAtZero: true,
+            }},
+            y2: {{
+              position: "right",
+              min: 0,
+              max: 100,
+              title: {{ display: true, text: "Utilization (%)", color: "#8b949e" }},
+              ticks: {{ color: "#8b949e" }},
+              grid: {{ drawOnChartArea: false }},
+            }},
+          }},
+        }},
+      }});
+    }}
+
+    function initSizes() {{
+      if (BLOCK_SIZE_DATA.length === 0) {{
+        document.getElementById("sizes-content").style.display = "none";
+        return;
+      }}
+      document.getElementById("sizes-empty").style.display = "none";
+      [...new Set(BLOCK_SIZE_DATA.map((r) => r.benchmark))].forEach((key) => {{
+        const opt = document.createElement("option");
+        opt.value = key;
+        opt.textContent = BENCHMARK_LABELS[key] || key;
+        sizesSelect.appendChild(opt);
+      }});
+      sizesSelect.addEventListener("change", buildSizesChart);
+      buildSizesChart();
+    }}
+
     buildSummaryTable();
     buildLineChart();
+    buildMemoryChart();
     updateCards();
+    initScaling();
+    initTail();
+    initSizes();
 {lifecycle_script}
   </script>
 </body>
@@ -814,9 +1288,18 @@ def build_html(benchmark_rows: list[dict], traces: dict[str, dict]) -> str:
 def main() -> None:
     rows = load_benchmark_rows()
     traces = load_lifecycle_traces()
-    OUT_PATH.write_text(build_html(rows, traces), encoding="utf-8")
+    scaling_rows = load_scaling_rows()
+    tail_rows = load_tail_rows()
+    block_size_rows = load_block_size_rows()
+    OUT_PATH.write_text(build_html(rows, traces, scaling_rows, tail_rows, block_size_rows), encoding="utf-8")
 
     parts = [f"{len(rows)} benchmark rows"]
+    if scaling_rows:
+        parts.append(f"{len(scaling_rows)} scaling rows")
+    if tail_rows:
+        parts.append(f"{len(tail_rows)} tail-latency rows")
+    if block_size_rows:
+        parts.append(f"{len(block_size_rows)} block-size rows")
     if traces:
         trace_parts = [
             f"{LIFECYCLE_LABELS[key]} ({len(traces[key]['samples'])} samples)"
@@ -18,6 +18,14 @@ BENCHMARK_ORDER = [
     "multi_interleaved",
     "multi_batch",
     "multi_random_mix",
+    "xthread_producer_consumer",
+    "xthread_pipeline",
+    "xthread_all_to_all",
+    "stress_larson",
+    "stress_cache_thrash",
+    "stress_cache_scratch",
+    "stress_threadtest",
+    "stress_sh6bench",
 ]
 
 BENCHMARK_LABELS = {
@@ -27,6 +35,14 @@ BENCHMARK_LABELS = {
     "multi_interleaved": "Multi-thread · Interleaved",
     "multi_batch": "Multi-thread · Batch",
     "multi_random_mix": "Multi-thread · Random mix",
+    "xthread_producer_consumer": "Cross-thread · Producer/consumer",
+    "xthread_pipeline": "Cross-thread · Pipeline",
+    "xthread_all_to_all": "Cross-thread · All-to-all",
+    "stress_larson": "Stress · Larson",
+    "stress_cache_thrash": "Stress · Cache-thrash",
+    "stress_cache_scratch": "Stress · Cache-scratch",
+    "stress_threadtest": "Stress · Threadtest",
+    "stress_sh6bench": "Stress · sh6bench mix",
 }
 
 LIFECYCLE_ORDER = ["interleaved", "batch"]
@@ -68,6 +84,12 @@ def load_benchmark_rows() -> list[dict]:
                     "benchmark_type": row["benchmark_type"],
                     "num_allocations": int(row["num_allocations"]),
                     "time_ms": int(row["time_ms"]),
+                    # Memory columns are absent from CSVs written before they existed.
+                    "peak_live_bytes": int(row.get("peak_live_bytes") or 0),
+                    "peak_mapped_bytes": int(row.get("peak_mapped_bytes") or 0),
+                    "rss_growth_bytes": max(int(row.get("peak_rss") or 0) - int(row.get("rss_before") or 0), 0),
+                    "mapped_live_ratio": float(row.get("mapped_live_ratio") or 0),
+                    "rss_live_ratio": float(row.get("rss_live_ratio") or 0),
                 }
             )
 
@@ -78,6 +100,71 @@ def load_benchmark_rows() -> list[dict]:
     return rows
 
 
+def load_scaling_rows() -> list[dict]:
+    """Rows of scaling.csv from `allocator_test scale`, or [] if it has not been run."""
+    path = DATA_DIR / "scaling.csv"
+    if not path.exists():
+        return []
+    rows: list[dict] = []
+    with path.open(newline="") as file:
+        for row in csv.DictReader(file):
+            rows.append(
+                {
+                    "allocator": row["allocator"],
+                    "sharing": row["sharing"],
+                    "workload": row["workload"],
+                    "threads": int(row["threads"]),
+                    "pinning": row["pinning"],
+                    "mops_per_sec": float(row["mops_per_sec"]),
+                    "efficiency": float(row["efficiency"]),
+                }
+            )
+    return rows
+
+
+def load_tail_rows() -> list[dict]:
+    """Rows of tail_latency.csv from `allocator_test tail`, or [] if it has not been run."""
+    path = DATA_DIR / "tail_latency.csv"
+    if not path.exists():
+        return []
+    rows: list[dict] = []
+    with path.open(newline="") as file:
+        for row in csv.DictReader(file):
+            rows.append(
+                {
+                    "allocator": row["allocator"],
+                    "workload": row["workload"],
+                    "op": row["op"],
+                    "kind": row["kind"],
+                    "quantile": float(row["quantile"]),
+                    "latency_ns": int(row["latency_ns"]),
+                }
+            )
+    return rows
+
+
+def load_block_size_rows() -> list[dict]:
+    """Rows of block_sizes.csv from `allocator_test sizes`, or [] if it has not been run."""
+    path = DATA_DIR / "block_sizes.csv"
+    if not path.exists():
+        return []
+    rows: list[dict] = []
+    with path.open(newline="") as file:
+        for row in csv.DictReader(file):
+            rows.append(
+                {
+                    "block_size": int(row["block_size"]),
+                    "allocator": row["allocator"],
+                    "benchmark": row["benchmark"],
+                    "mops_per_sec": float(row["mops_per_sec"]),
+                    "blocks_per_page": int(row["blocks_per_page"]),
+                    "utilization": float(row["utilization"]),
+                    "line_split": float(row["line_split"]),
+                }
+            )
+    return rows
+
+
 def _load_trace_file(path: Path) -> dict:
     with path.open(encoding="utf-8") as file:
         data = json.load(file)
@@ -1,15 +1,125 @@
 #pragma once
 
+#include "HeapProfiler.hpp"
+#include "LatencyHistogram.hpp"
+#include "MemoryBudget.hpp"
 #include "PlatformMemory.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Build with -DCMA_SLOW_PATH_STATS=1 to count and time the central-pool slow
+// paths (see slow_path_stats()). Off by default, when every hook compiles away.
+#ifndef CMA_SLOW_PATH_STATS
+#define CMA_SLOW_PATH_STATS 0
+#endif
 
 namespace cma {
 
+// What allocate() does when mapping another page would exceed a byte limit.
+enum class QuotaPolicy {
+    FailFast,  // return nullptr immediately
+    Callback,  // call on_quota_exhausted once (e.g. to shed caches), then retry
+    Block,     // wait up to quota_timeout for pages or blocks to be returned
+};
+
+struct AllocatorOptions {
+    // Maximum bytes this allocator may map (0 = unlimited). Checked per page.
+    size_t byte_limit = 0;
+    // Optional budget shared with other allocators; charged for every page.
+    MemoryBudget* shared_budget = nullptr;
+    QuotaPolicy quota_policy = QuotaPolicy::FailFast;
+    // Invoked without any allocator lock held under QuotaPolicy::Callback.
+    std::function<void()> on_quota_exhausted;
+    std::chrono::milliseconds quota_timeout{100};
+    // Rotate each page's block region by a cache-line multiple (see color_count()).
+    bool cache_coloring = true;
+    // Sort blocks by address whenever they move between a thread cache and the
+    // central pool, so refills hand out each page's blocks in ascending order.
+    bool address_ordered = false;
+    // Carve pages from one reserved region of this many pages, enabling the
+    // 32-bit handle API (0 = map pages individually, no handles).
+    size_t handle_region_pages = 0;
+    // Top bits of each handle spent on a per-block generation (0-8), so stale
+    // handles are caught by resolve_checked() and deallocate_handle().
+    unsigned int handle_generation_bits = 0;
+    // mlock every page the pool maps (best effort; see reserve()).
+    bool lock_pages = false;
+    // Run a maintenance thread that maps pages ahead of demand, so growth
+    // pops a ready page instead of calling mmap under the central lock.
+    // Ignored in handle mode.
+    bool background_growth = false;
+    // Pages the maintenance thread keeps mapped and waiting.
+    size_t ready_pages = 2;
+    // Also commit ready pages' memory, moving first-touch faults off the caller.
+    bool prefault_ready_pages = false;
+    // Unlink empty pages under the central lock but munmap them after it is
+    // dropped, merging adjacent mappings (false: unmap each page under the lock).
+    bool deferred_unmap = true;
+    // Time every Nth allocate() and deallocate() per thread into lock-free
+    // histograms (see latency_stats()); 0 = off. 1024 is cheap enough to leave on.
+    size_t latency_sample_interval = 0;
+    // Optional sampling heap profiler, shared across pools. About one block per
+    // heap_profiler->sample_bytes() allocated has its allocating stack recorded.
+    HeapProfiler* heap_profiler = nullptr;
+};
+
+// Sampled per-operation latency in nanoseconds, merged across threads.
+struct LatencyStats {
+    LatencySummary allocate;
+    LatencySummary deallocate;
+};
+
+// Slow-path counters (all zero unless built with CMA_SLOW_PATH_STATS=1).
+// Times are summed nanoseconds; divide by the matching count for a mean.
+struct SlowPathStats {
+    uint64_t lock_acquisitions = 0;  // central lock taken by refills and flushes
+    uint64_t lock_contended = 0;     // ...of which had to wait for another thread
+    uint64_t lock_wait_ns = 0;
+    uint64_t refills_recycled = 0;   // served from blocks returned to the central pool
+    uint64_t refills_bump = 0;       // carved from the head page's untouched tail
+    uint64_t refills_growth = 0;     // needed a new page first
+    uint64_t flushes = 0;            // thread-cache batches pushed to the central pool
+    uint64_t pages_mapped = 0;
+    uint64_t pages_unmapped = 0;
+    uint64_t mmap_calls = 0;         // includes commits in handle mode and background maps
+    uint64_t mmap_ns = 0;
+    uint64_t munmap_calls = 0;       // after merging adjacent released pages
+    uint64_t munmap_ns = 0;
+    uint64_t cross_thread_frees = 0; // counted when the freeing thread next flushes
+
+    SlowPathStats& operator+=(const SlowPathStats& other) {
+        lock_acquisitions += other.lock_acquisitions;
+        lock_contended += other.lock_contended;
+        lock_wait_ns += other.lock_wait_ns;
+        refills_recycled += other.refills_recycled;
+        refills_bump += other.refills_bump;
+        refills_growth += other.refills_growth;
+        flushes += other.flushes;
+        pages_mapped += other.pages_mapped;
+        pages_unmapped += other.pages_unmapped;
+        mmap_calls += other.mmap_calls;
+        mmap_ns += other.mmap_ns;
+        munmap_calls += other.munmap_calls;
+        munmap_ns += other.munmap_ns;
+        cross_thread_frees += other.cross_thread_frees;
+        return *this;
+    }
+};
+
 template <size_t BlockSize>
 class FixedBlockAllocator {
 public:
@@ -18,6 +128,8 @@ public:
     static constexpr size_t REFILL_BATCH = 512;
     static constexpr size_t HIGH_WATER_MARK = 2048;
     static constexpr size_t FLUSH_BATCH = 512;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr bool SLOW_PATH_STATS_ENABLED = CMA_SLOW_PATH_STATS != 0;
 
     struct Stats {
         size_t active_pages = 0;
@@ -29,19 +141,71 @@ public:
         size_t free_bytes = 0;
     };
 
-    FixedBlockAllocator() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        grow_locked();
+    struct PageOccupancy {
+        const void* page = nullptr;  // page header address (64 KB-aligned)
+        size_t live_blocks = 0;
+        size_t capacity_blocks = 0;
+
+        double occupancy() const {
+            return capacity_blocks == 0 ? 0.0 : static_cast<double>(live_blocks) / capacity_blocks;
+        }
+    };
+
+    struct CompactionResult {
+        size_t pages_evacuated = 0;  // sparse pages whose live blocks were offered for moving
+        size_t blocks_moved = 0;
+        size_t blocks_pinned = 0;    // handler declined, or no destination block was available
+        size_t pages_released = 0;
+        size_t bytes_released = 0;
+    };
+
+    // Page index + slot (+ optional generation) of a block in the handle region.
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = ~Handle{0};
+
+    // Called by compact() after a live block's bytes were copied from `from` to
+    // `to`. Return true once every reference has been redirected to `to` (the
+    // allocator then frees `from`); return false to keep `from` where it is.
+    using RelocationHandler = std::function<bool(void* from, void* to)>;
+
+    FixedBlockAllocator() : FixedBlockAllocator(AllocatorOptions{}) {}
+
+    explicit FixedBlockAllocator(AllocatorOptions options)
+        : m_options(std::move(options)),
+          m_sample_interval(m_options.latency_sample_interval != 0 ? m_options.latency_sample_interval
+                                                                   : NEVER_SAMPLE),
+          m_clock_epoch(Clock::now()),
+          m_clock_epoch_ticks(read_cycle_counter()) {
+        std::vector<Page*> grown;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_options.handle_region_pages != 0) {
+                reserve_handle_region_locked();
+            }
+            grow_locked();
+            grown = take_pages_to_lock_locked();
+            if (m_options.background_growth && m_options.ready_pages != 0 && !handles_enabled()) {
+                m_growth_thread = std::thread(&FixedBlockAllocator::growth_thread_main, this);
+            }
+        }
+        lock_grown_pages(grown);
     }
 
     ~FixedBlockAllocator() {
+        stop_growth_thread();
         flush_all_local_cache_to_central();
         std::lock_guard<std::mutex> lock(m_mutex);
+        for (void* mapping : m_ready_pages) {
+            unmap_page(mapping, READY_MAPPING_SIZE);
+        }
+        unmap_pages(m_pending_unmaps.data(), m_pending_unmaps.size());
         while (m_page_list != nullptr) {
             Page* next = m_page_list->next;
-            unmap_page(m_page_list->mapping_base, m_page_list->mapping_size);
+            unmap_page_locked(m_page_list);
             m_page_list = next;
         }
+        release_region(m_region_mapping, m_region_mapping_size);
+        release_region(m_generations, m_generations_size);
         forget_thread_cache();
     }
 
@@ -54,50 +218,213 @@ public:
 
     void* allocate() {
         ThreadCache& cache = thread_cache();
+        if (--cache.allocate_countdown == 0) {
+            return allocate_sampled(cache);
+        }
+        return allocate_from(cache);
+    }
 
-        Block* block = take_from_thread_cache(cache);
-        if (block == nullptr) {
-            if (!refill_thread_cache(cache)) {
-                return nullptr;
+    void deallocate(void* ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+        if (m_handle_generation_bits != 0) {
+            age_handle_generation(ptr);
+        }
+        free_block(ptr);
+    }
+
+    void flush_local_thread_cache() {
+        flush_all_local_cache_to_central();
+    }
+
+    // -------------------------------------------------------------------------
+    // Sampled latency (AllocatorOptions::latency_sample_interval)
+    // -------------------------------------------------------------------------
+
+    // Merges every thread's histograms (including exited threads'). Ticks are
+    // converted to nanoseconds over the allocator's lifetime so far.
+    LatencyStats latency_stats() const {
+        LatencyHistogram allocations;
+        LatencyHistogram deallocations;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            allocations.merge(m_exited_latency.allocate);
+            deallocations.merge(m_exited_latency.deallocate);
+            for (const std::shared_ptr<ThreadLatency>& thread : m_thread_latencies) {
+                allocations.merge(thread->allocate);
+                deallocations.merge(thread->deallocate);
             }
-            block = take_from_thread_cache(cache);
-            if (block == nullptr) {
-                return nullptr;
+        }
+        const double ns_per_tick = nanoseconds_per_tick();
+        return LatencyStats{allocations.summarize(ns_per_tick), deallocations.summarize(ns_per_tick)};
+    }
+
+    // -------------------------------------------------------------------------
+    // Reservation: trade lazy growth for fault-free allocation
+    // -------------------------------------------------------------------------
+
+    /**
+     * Grows the pool until the central pool alone can supply @p blocks blocks,
+     * then commits the physical memory behind every not-yet-carved block so
+     * its first touch does not page-fault. Reserved pages are kept mapped even
+     * when all their blocks are free, so allocation within the reservation
+     * stays fault-free for the allocator's lifetime. With lock_pages set the
+     * pages are also mlocked. The page-in and mlock run without the central
+     * lock, and pages an earlier call already prepared are skipped.
+     * @return false if a quota, mapping or mlock failed; pages added so far stay reserved.
+     */
+    bool reserve(size_t blocks) {
+        // Pages not yet prepared by an earlier call. Each one's uncarved tail is
+        // hidden (bump_offset moved to the end) and the page is pinned while it
+        // is prefaulted and mlocked without the lock, so no refill can carve
+        // those blocks and no flush can release the page in the meantime.
+        struct Preparation {
+            Page* page;
+            size_t first_block;  // start of the hidden, never-carved tail
+        };
+        std::vector<Preparation> pending;
+        bool ok = true;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t available = m_central_free_count;
+            for (Page* page = m_page_list; page != nullptr; page = page->next) {
+                available += page->total_blocks - page->bump_offset;
+            }
+            while (available < blocks) {
+                if (grow_locked(false) != GrowResult::Ok) {
+                    ok = false;
+                    break;
+                }
+                available += blocks_per_page();
+            }
+            for (Page* page = m_page_list; page != nullptr; page = page->next) {
+                if (page->reserved || page->reserving) {
+                    continue;
+                }
+                page->reserving = true;
+                pending.push_back(Preparation{page, page->bump_offset});
+                page->bump_offset = page->total_blocks;
             }
+            m_reserved_pages += pending.size();
         }
 
-        Page* page = find_page(block);
-        if (page == nullptr) {
-            return nullptr;
+        for (const Preparation& preparation : pending) {
+            // Only the hidden tail: carved blocks may be in use by other threads.
+            Page* page = preparation.page;
+            char* const untouched = page->block_base + preparation.first_block * BlockSize;
+            char* const end = page->block_base + page->total_blocks * BlockSize;
+            if (untouched != end && !prefault_region(untouched, static_cast<size_t>(end - untouched))) {
+                ok = false;
+            }
+            if (m_options.lock_pages && !lock_region(page, PAGE_SIZE)) {
+                ok = false;
+            }
         }
-        page->live_count.fetch_add(1, std::memory_order_relaxed);
-        return static_cast<void*>(block);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const Preparation& preparation : pending) {
+            // The page may no longer be the head, and refills only bump-carve
+            // the head, so the tail goes to the central free list instead.
+            carve_to_free_list_locked(preparation.page, preparation.first_block);
+            preparation.page->reserving = false;
+            preparation.page->reserved = true;
+        }
+        notify_quota_waiters_locked();
+        return ok;
     }
 
-    void deallocate(void* ptr) {
-        if (ptr == nullptr) {
-            return;
+    size_t reserved_pages() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_reserved_pages;
+    }
+
+    // -------------------------------------------------------------------------
+    // 32-bit handles (AllocatorOptions::handle_region_pages must be set)
+    //
+    // Every page lives at a fixed index inside one reserved region, so a block
+    // is named by page index + slot and resolve() is a shift-and-add. Handles
+    // stay valid for the block's lifetime; with generation bits, a handle to a
+    // freed (and possibly reused) block is rejected by the checked calls.
+    // -------------------------------------------------------------------------
+
+    bool handles_enabled() const {
+        return m_region_base != nullptr;
+    }
+
+    Handle allocate_handle() {
+        void* block = allocate();
+        if (block == nullptr) {
+            return INVALID_HANDLE;
         }
+        return handle_of(block);
+    }
 
-        Page* page = find_page(ptr);
-        if (page == nullptr) {
-            return;
+    // Unchecked: the generation bits are ignored.
+    void* resolve(Handle handle) const {
+        const size_t page_index = (handle >> SLOT_BITS) & m_handle_page_mask;
+        return m_region_base + page_index * PAGE_SIZE + region_block_offset(page_index) +
+               static_cast<size_t>(handle & SLOT_MASK) * BlockSize;
+    }
+
+    // Returns nullptr if the handle is malformed or its generation is stale.
+    void* resolve_checked(Handle handle) const {
+        if (!handles_enabled() || handle == INVALID_HANDLE) {
+            return nullptr;
         }
-        page->live_count.fetch_sub(1, std::memory_order_relaxed);
+        const size_t page_index = (handle >> SLOT_BITS) & m_handle_page_mask;
+        const size_t slot = handle & SLOT_MASK;
+        if (page_index >= m_region_page_capacity || slot >= blocks_per_page()) {
+            return nullptr;
+        }
+        if (m_handle_generation_bits != 0 &&
+            handle_generation(handle) != generation_slot(page_index, slot).load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return resolve(handle);
+    }
 
-        ThreadCache& cache = thread_cache();
-        Block* block = static_cast<Block*>(ptr);
-        block->next = cache.head;
-        cache.head = block;
-        ++cache.size;
+    // Frees the block behind a handle and ages its generation. Returns false
+    // (and frees nothing) if the handle does not resolve to a current block.
+    // With generation bits, only one of several racing frees of a handle wins
+    // the generation bump and frees the block; without them a double free is
+    // not detected. deallocate() of a region block ages the generation too.
+    bool deallocate_handle(Handle handle) {
+        void* block = resolve_checked(handle);
+        if (block == nullptr) {
+            return false;
+        }
+        if (m_handle_generation_bits != 0) {
+            const size_t page_index = (handle >> SLOT_BITS) & m_handle_page_mask;
+            std::atomic<uint8_t>& generation = generation_slot(page_index, handle & SLOT_MASK);
+            uint8_t expected = static_cast<uint8_t>(handle_generation(handle));
+            if (!generation.compare_exchange_strong(
+                    expected, next_generation(expected), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return false;
+            }
+        }
+        free_block(block);
+        return true;
+    }
 
-        if (cache.size > HIGH_WATER_MARK) {
-            flush_excess_thread_cache(cache);
+    // Handle of a live block from this allocator's region, or INVALID_HANDLE.
+    Handle handle_of(const void* ptr) const {
+        size_t page_index = 0;
+        size_t slot = 0;
+        if (!region_slot(ptr, page_index, slot)) {
+            return INVALID_HANDLE;
         }
+        Handle handle = static_cast<Handle>((page_index << SLOT_BITS) | slot);
+        if (m_handle_generation_bits != 0) {
+            const Handle generation = generation_slot(page_index, slot).load(std::memory_order_acquire);
+            handle |= generation << (32U - m_handle_generation_bits);
+        }
+        return handle;
     }
 
-    void flush_local_thread_cache() {
-        flush_all_local_cache_to_central();
+    // Pages the handle region can hold (0 when handles are disabled).
+    size_t handle_region_page_capacity() const {
+        return m_region_page_capacity;
     }
 
     // -------------------------------------------------------------------------
@@ -119,11 +446,44 @@ public:
                      free_blocks * BlockSize};
     }
 
+    // Cheap to read (no lock): each counter is a relaxed atomic. A cross-thread
+    // free is a block freed by a thread other than the one whose cache last
+    // refilled from its page.
+    SlowPathStats slow_path_stats() const {
+        SlowPathStats result;
+#if CMA_SLOW_PATH_STATS
+        auto read = [this](SlowPathCounter counter) {
+            return m_slow_path[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+        };
+        result.lock_acquisitions = read(SlowPathCounter::LockAcquisitions);
+        result.lock_contended = read(SlowPathCounter::LockContended);
+        result.lock_wait_ns = read(SlowPathCounter::LockWaitNs);
+        result.refills_recycled = read(SlowPathCounter::RefillsRecycled);
+        result.refills_bump = read(SlowPathCounter::RefillsBump);
+        result.refills_growth = read(SlowPathCounter::RefillsGrowth);
+        result.flushes = read(SlowPathCounter::Flushes);
+        result.pages_mapped = read(SlowPathCounter::PagesMapped);
+        result.pages_unmapped = read(SlowPathCounter::PagesUnmapped);
+        result.mmap_calls = read(SlowPathCounter::MmapCalls);
+        result.mmap_ns = read(SlowPathCounter::MmapNs);
+        result.munmap_calls = read(SlowPathCounter::MunmapCalls);
+        result.munmap_ns = read(SlowPathCounter::MunmapNs);
+        result.cross_thread_frees = read(SlowPathCounter::CrossThreadFrees);
+#endif
+        return result;
+    }
+
     size_t active_page_count() const {
         std::lock_guard<std::mutex> lock(m_mutex);
         return active_page_count_locked();
     }
 
+    // Pages mapped by the background growth thread but not yet in the pool.
+    size_t ready_page_count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_ready_pages.size();
+    }
+
     size_t live_block_count() const {
         std::lock_guard<std::mutex> lock(m_mutex);
         return live_block_count_locked();
@@ -156,7 +516,151 @@ public:
     }
 
     static constexpr size_t blocks_per_page() {
-        return (PAGE_SIZE - sizeof(Page)) / BlockSize;
+        return (PAGE_SIZE - PAGE_HEADER_SIZE) / BlockSize;
+    }
+
+    // Number of distinct cache-line offsets the block region can start at. The
+    // slack left after blocks_per_page() blocks decides it, so block sizes that
+    // divide the page evenly (e.g. 32) get a single color.
+    static constexpr size_t color_count() {
+        return (PAGE_SIZE - PAGE_HEADER_SIZE - blocks_per_page() * BlockSize) / CACHE_LINE_SIZE + 1;
+    }
+
+    const AllocatorOptions& options() const {
+        return m_options;
+    }
+
+    // -------------------------------------------------------------------------
+    // Fragmentation and compaction
+    // -------------------------------------------------------------------------
+
+    // Live/capacity per mapped page. Blocks parked in thread caches count as
+    // free, matching live_block_count().
+    std::vector<PageOccupancy> page_occupancy() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<PageOccupancy> report;
+        report.reserve(m_page_count);
+        for (Page* page = m_page_list; page != nullptr; page = page->next) {
+            report.push_back(PageOccupancy{page,
+                                           page->live_count.load(std::memory_order_relaxed),
+                                           page->total_blocks});
+        }
+        return report;
+    }
+
+    // The @p count least occupied pages that still hold live blocks, sparsest first.
+    std::vector<PageOccupancy> sparsest_pages(size_t count) const {
+        std::vector<PageOccupancy> report = page_occupancy();
+        report.erase(std::remove_if(report.begin(),
+                                    report.end(),
+                                    [](const PageOccupancy& entry) { return entry.live_blocks == 0; }),
+                     report.end());
+        std::sort(report.begin(), report.end(), [](const PageOccupancy& a, const PageOccupancy& b) {
+            return a.live_blocks < b.live_blocks;
+        });
+        if (report.size() > count) {
+            report.resize(count);
+        }
+        return report;
+    }
+
+    // Must be set before compact() runs; compaction is a no-op without it.
+    void set_relocation_handler(RelocationHandler handler) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_relocation_handler = std::move(handler);
+    }
+
+    // Moves live blocks out of pages at or below @p max_occupancy so those
+    // pages can be unmapped. The calling thread's cache is flushed first; a
+    // page is skipped while any other thread's cache still holds one of its
+    // blocks. The handler runs without the central lock, so it may allocate or
+    // free, but it must not race with frees of the blocks being moved. Pages
+    // under evacuation are never released by other threads' frees; compact()
+    // releases them itself once it is done copying out of them.
+    CompactionResult compact(double max_occupancy = 0.25) {
+        CompactionResult result;
+        flush_all_local_cache_to_central();
+
+        struct Evacuation {
+            Page* page;
+            std::vector<Block*> live;
+            std::vector<Block*> vacated;
+        };
+        std::vector<Evacuation> plan;
+        RelocationHandler handler;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_relocation_handler) {
+                return result;
+            }
+            handler = m_relocation_handler;
+            for (Page* page = m_page_list; page != nullptr; page = page->next) {
+                const size_t live = page->live_count.load(std::memory_order_relaxed);
+                const bool carving = page == m_page_list && page->bump_offset < page->total_blocks;
+                // A reserved page is never released, so emptying it gains nothing.
+                const bool pinned = page->reserved || page->reserving;
+                if (live == 0 || carving || pinned || live > max_occupancy * page->total_blocks) {
+                    continue;
+                }
+                std::vector<Block*> live_blocks = collect_live_blocks_locked(page);
+                if (live_blocks.size() != live) {
+                    continue;  // some of its free blocks sit in another thread's cache
+                }
+                page->evacuating = true;
+                plan.push_back(Evacuation{page, std::move(live_blocks), {}});
+            }
+        }
+        result.pages_evacuated = plan.size();
+
+        // Refills skip evacuating pages, so destinations always land elsewhere.
+        for (Evacuation& evacuation : plan) {
+            for (Block* block : evacuation.live) {
+                void* target = allocate();
+                if (target == nullptr) {
+                    ++result.blocks_pinned;
+                    continue;
+                }
+                std::memcpy(target, block, BlockSize);
+                if (handler(block, target)) {
+                    if (m_options.heap_profiler != nullptr) {
+                        m_options.heap_profiler->record_move(block, target);
+                    }
+                    evacuation.vacated.push_back(block);
+                    ++result.blocks_moved;
+                } else {
+                    deallocate(target);
+                    ++result.blocks_pinned;
+                }
+            }
+        }
+
+        std::vector<MappedRange> released_pages;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (Evacuation& evacuation : plan) {
+                Page* page = evacuation.page;
+                page->evacuating = false;
+                bool released = false;
+                for (Block* block : evacuation.vacated) {
+                    page->live_count.fetch_sub(1, std::memory_order_relaxed);
+                    released = push_block_to_page_locked(page, block, true);
+                }
+                // A concurrent free may have emptied the page while it was held back.
+                if (!released && releasable_locked(page, true)) {
+                    release_page_locked(page);
+                    released = true;
+                }
+                if (released) {
+                    ++result.pages_released;
+                }
+            }
+            notify_quota_waiters_locked();
+            released_pages = take_pending_unmaps_locked();
+        }
+        unmap_released_pages(released_pages);
+        result.bytes_released = result.pages_released * PAGE_SIZE;
+        flush_all_local_cache_to_central();
+        return result;
     }
 
 private:
@@ -169,6 +673,45 @@ private:
         Block* next;
     };
 
+    // One thread's sampled latencies, in read_cycle_counter() ticks. Only that
+    // thread records into them; latency_stats() merges them under m_mutex.
+    // The thread's cache and the allocator share ownership, since either may
+    // be destroyed first.
+    struct ThreadLatency {
+        LatencyHistogram allocate;
+        LatencyHistogram deallocate;
+        // Stored (release) when the owning thread's cache is destroyed, after its
+        // last record(); a claim that loads it (acquire) may fold and reuse the slot.
+        std::atomic<bool> released{false};
+    };
+
+    // A thread cache's hold on its ThreadLatency slot. The cache outlives its
+    // allocator when the allocator is destroyed first, so the slot is handed
+    // back through its flag rather than under m_mutex.
+    class LatencySlot {
+    public:
+        LatencySlot() = default;
+        LatencySlot(const LatencySlot&) = delete;
+        LatencySlot& operator=(const LatencySlot&) = delete;
+
+        ~LatencySlot() {
+            if (m_slot != nullptr) {
+                m_slot->released.store(true, std::memory_order_release);
+            }
+        }
+
+        ThreadLatency* get() const {
+            return m_slot.get();
+        }
+
+        void claim(std::shared_ptr<ThreadLatency> slot) {
+            m_slot = std::move(slot);
+        }
+
+    private:
+        std::shared_ptr<ThreadLatency> m_slot;
+    };
+
     // A thread's private cache has two sources of blocks:
     //   * head  - an intrusive list of recycled (previously freed) blocks.
     //   * bump  - an untouched contiguous range carved from a single page. Blocks
@@ -179,6 +722,19 @@ private:
         size_t size = 0;
         char* bump_ptr = nullptr;
         char* bump_end = nullptr;
+        // Calls left until the next sampled one. An allocate() may be sampled
+        // for latency, for the heap profiler or both; allocate_countdown runs
+        // to the nearer of the two and was last reset to allocate_period.
+        size_t allocate_countdown = NEVER_SAMPLE;
+        size_t allocate_period = NEVER_SAMPLE;
+        size_t latency_left = NEVER_SAMPLE;
+        size_t profile_left = NEVER_SAMPLE;
+        size_t deallocate_countdown = NEVER_SAMPLE;
+        uint64_t profile_rng = 0;
+        LatencySlot latency;  // shared with the allocator, claimed on first sample
+#if CMA_SLOW_PATH_STATS
+        uint64_t cross_thread_frees = 0;  // published on the next flush
+#endif
     };
 
     // Blocks are carved out of a page lazily with a bump pointer (bump_offset)
@@ -195,6 +751,13 @@ private:
         char* block_base;       // start of the block region within the page
         void* mapping_base;
         size_t mapping_size;
+        bool evacuating;        // being compacted: no refills from it, and it is never released
+        bool reserving;         // being prefaulted by reserve() without the lock: never released
+        bool reserved;          // already prefaulted (and mlocked) by reserve(): never released
+        bool locking;           // grown with lock_pages, mlock pending without the lock: never released
+#if CMA_SLOW_PATH_STATS
+        std::atomic<const ThreadCache*> refilled_by{nullptr};  // cache that last drew from this page
+#endif
 
         Page()
             : next(nullptr),
@@ -206,7 +769,11 @@ private:
               free_list(nullptr),
               block_base(nullptr),
               mapping_base(nullptr),
-              mapping_size(0) {}
+              mapping_size(0),
+              evacuating(false),
+              reserving(false),
+              reserved(false),
+              locking(false) {}
 
         // A page can be reclaimed once every carved block has come home.
         bool fully_returned() const {
@@ -214,17 +781,113 @@ private:
         }
     };
 
+    // The block region starts on a max_align_t boundary past the header, as
+    // malloc's blocks do, whatever fields the header grows.
+    static constexpr size_t PAGE_HEADER_SIZE =
+        (sizeof(Page) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static constexpr unsigned int bits_for(size_t value) {
+        return value == 0 ? 0 : 1 + bits_for(value >> 1);
+    }
+
+    static constexpr unsigned int SLOT_BITS = bits_for(blocks_per_page() - 1);
+    static constexpr Handle SLOT_MASK = (Handle{1} << SLOT_BITS) - 1;
+    static constexpr unsigned int MAX_GENERATION_BITS = 8;
+
     static_assert(BlockSize >= sizeof(Block), "BlockSize must be large enough to hold Block metadata.");
-    static_assert(PAGE_SIZE > sizeof(Page), "PAGE_SIZE must be larger than the Page metadata struct.");
+    static_assert(PAGE_SIZE > PAGE_HEADER_SIZE, "PAGE_SIZE must be larger than the Page metadata struct.");
+
+    enum class GrowResult {
+        Ok,
+        QuotaExhausted,
+        MapFailed,
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class SlowPathCounter : size_t {
+        LockAcquisitions,
+        LockContended,
+        LockWaitNs,
+        RefillsRecycled,
+        RefillsBump,
+        RefillsGrowth,
+        Flushes,
+        PagesMapped,
+        PagesUnmapped,
+        MmapCalls,
+        MmapNs,
+        MunmapCalls,
+        MunmapNs,
+        CrossThreadFrees,
+        Count,
+    };
+
+    // Ready pages are mapped exactly like synchronous growth, over-sized so a
+    // 64 KB-aligned page fits inside.
+    static constexpr size_t READY_MAPPING_SIZE = PAGE_SIZE + PAGE_ALIGNMENT - 1;
+    static constexpr std::chrono::milliseconds GROWTH_RETRY_DELAY{10};
+
+    // A shared budget can be credited by another allocator without waking our
+    // waiters, so blocked refills re-check it at least this often.
+    static constexpr std::chrono::milliseconds SHARED_BUDGET_POLL{1};
+
+    // Countdown start when sampling is off: never reaches zero in practice.
+    static constexpr size_t NEVER_SAMPLE = SIZE_MAX;
 
     // -------------------------------------------------------------------------
     // Central pool state
     // -------------------------------------------------------------------------
 
+    const AllocatorOptions m_options;
+    const size_t m_sample_interval;
+    const Clock::time_point m_clock_epoch;  // with m_clock_epoch_ticks, calibrates ticks to ns
+    const uint64_t m_clock_epoch_ticks;
     mutable std::mutex m_mutex;
+    std::condition_variable m_quota_cv;
+    size_t m_quota_waiters = 0;
     Page* m_page_list = nullptr;
     size_t m_page_count = 0;
     size_t m_central_free_count = 0;  // blocks parked on any page's free_list
+    size_t m_next_color = 0;
+    size_t m_reserved_pages = 0;  // pages reserve() has pinned
+    RelocationHandler m_relocation_handler;
+
+    // Background growth (AllocatorOptions::background_growth).
+    std::vector<void*> m_ready_pages;  // mappings of READY_MAPPING_SIZE bytes
+    std::condition_variable m_growth_cv;
+    bool m_stop_growth = false;
+    std::thread m_growth_thread;
+
+    // Pages unlinked under m_mutex whose mappings the releasing thread unmaps
+    // once it has dropped the lock (AllocatorOptions::deferred_unmap).
+    std::vector<MappedRange> m_pending_unmaps;
+
+    // Pages grow_locked() mapped with lock_pages set, mlocked by whichever
+    // thread grew them once it has dropped the lock.
+    std::vector<Page*> m_pages_to_lock;
+
+    // Sampled latency histograms, one slot per live sampling thread; exited
+    // threads' samples are folded into m_exited_latency when a slot is reused.
+    std::vector<std::shared_ptr<ThreadLatency>> m_thread_latencies;
+    ThreadLatency m_exited_latency;
+
+#if CMA_SLOW_PATH_STATS
+    std::atomic<uint64_t> m_slow_path[static_cast<size_t>(SlowPathCounter::Count)] = {};
+#endif
+
+    // Handle region (all null/zero unless handle_region_pages is set).
+    char* m_region_base = nullptr;        // 64 KB-aligned start of page index 0
+    void* m_region_mapping = nullptr;
+    size_t m_region_mapping_size = 0;
+    size_t m_region_page_capacity = 0;
+    size_t m_region_next_page = 0;        // never-used page indices start here
+    std::vector<size_t> m_region_free_pages;
+    size_t m_handle_page_mask = 0;
+    unsigned int m_handle_generation_bits = 0;
+    uint8_t m_handle_generation_mask = 0;
+    std::atomic<uint8_t>* m_generations = nullptr;  // one per block slot in the region
+    size_t m_generations_size = 0;
 
     size_t active_page_count_locked() const {
         return m_page_count;
@@ -238,24 +901,133 @@ private:
         return total;
     }
 
+    // -------------------------------------------------------------------------
+    // Slow-path instrumentation (no-ops unless CMA_SLOW_PATH_STATS is set)
+    // -------------------------------------------------------------------------
+
+    static uint64_t slow_path_clock_ns() {
+#if CMA_SLOW_PATH_STATS
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+#else
+        return 0;
+#endif
+    }
+
+    void count_slow_path(SlowPathCounter counter, uint64_t amount = 1) {
+#if CMA_SLOW_PATH_STATS
+        m_slow_path[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+#else
+        (void)counter;
+        (void)amount;
+#endif
+    }
+
+    void count_elapsed_ns(SlowPathCounter counter, uint64_t start_ns) {
+        count_slow_path(counter, slow_path_clock_ns() - start_ns);
+    }
+
+    // Takes the central lock for a refill or flush. Only a failed try_lock is
+    // timed, so uncontended acquisitions never read the clock.
+    std::unique_lock<std::mutex> lock_central() {
+#if CMA_SLOW_PATH_STATS
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            const uint64_t start = slow_path_clock_ns();
+            lock.lock();
+            count_elapsed_ns(SlowPathCounter::LockWaitNs, start);
+            count_slow_path(SlowPathCounter::LockContended);
+        }
+        count_slow_path(SlowPathCounter::LockAcquisitions);
+        return lock;
+#else
+        return std::unique_lock<std::mutex>(m_mutex);
+#endif
+    }
+
+    void publish_cross_thread_frees(ThreadCache& cache) {
+#if CMA_SLOW_PATH_STATS
+        if (cache.cross_thread_frees != 0) {
+            count_slow_path(SlowPathCounter::CrossThreadFrees, cache.cross_thread_frees);
+            cache.cross_thread_frees = 0;
+        }
+#else
+        (void)cache;
+#endif
+    }
+
+    static void note_refilled_by(Page* page, const ThreadCache& cache) {
+#if CMA_SLOW_PATH_STATS
+        page->refilled_by.store(&cache, std::memory_order_relaxed);
+#else
+        (void)page;
+        (void)cache;
+#endif
+    }
+
     // Returns one block to a page's free list. Releases the page back to the OS
     // once every carved block is home, except the final page (kept to avoid
-    // churn) unless allow_release_last_page is set.
-    void push_block_to_page_locked(Page* page, Block* block, bool allow_release_last_page) {
+    // churn) unless allow_release_last_page is set, and except a page that
+    // compact() is still copying out of. Returns true if the page was released
+    // (and must no longer be touched).
+    bool push_block_to_page_locked(Page* page, Block* block, bool allow_release_last_page) {
         block->next = page->free_list;
         page->free_list = block;
         page->cached_on_page++;
         m_central_free_count++;
 
-        if (page->fully_returned()) {
-            if (allow_release_last_page || active_page_count_locked() > 1) {
-                release_page_locked(page);
+        if (releasable_locked(page, allow_release_last_page)) {
+            release_page_locked(page);
+            return true;
+        }
+        return false;
+    }
+
+    // Links blocks [first_block, total_blocks) onto a page's free list, highest
+    // address first so refills hand them out in ascending order.
+    void carve_to_free_list_locked(Page* page, size_t first_block) {
+        const size_t carved = page->total_blocks - first_block;
+        for (size_t index = page->total_blocks; index > first_block; --index) {
+            Block* block = reinterpret_cast<Block*>(page->block_base + (index - 1) * BlockSize);
+            block->next = page->free_list;
+            page->free_list = block;
+        }
+        page->bump_offset = page->total_blocks;
+        page->cached_on_page += carved;
+        m_central_free_count += carved;
+    }
+
+    // An empty page that reserve() has not prepared and that neither compact(),
+    // reserve() nor a post-growth mlock is working on without the lock. Reserved pages stay mapped
+    // (and mlocked) so the faults reserve() took up front are not paid again.
+    bool releasable_locked(const Page* page, bool allow_release_last_page) const {
+        return page->fully_returned() && !page->evacuating && !page->reserving && !page->reserved &&
+               !page->locking && may_release_page_locked(allow_release_last_page);
+    }
+
+    bool may_release_page_locked(bool allow_release_last_page) const {
+        return allow_release_last_page || active_page_count_locked() > 1;
+    }
+
+    // Carved blocks that are not on the page's free list. Blocks sitting in a
+    // thread cache are included, which compact() detects via live_count.
+    std::vector<Block*> collect_live_blocks_locked(Page* page) const {
+        std::vector<bool> is_free(page->bump_offset, false);
+        for (Block* block = page->free_list; block != nullptr; block = block->next) {
+            is_free[(reinterpret_cast<char*>(block) - page->block_base) / BlockSize] = true;
+        }
+        std::vector<Block*> live;
+        for (size_t index = 0; index < page->bump_offset; ++index) {
+            if (!is_free[index]) {
+                live.push_back(reinterpret_cast<Block*>(page->block_base + index * BlockSize));
             }
         }
+        return live;
     }
 
     // Moves up to max_blocks recycled blocks from a page's free list into a
-    // thread cache by splicing the list (O(max_blocks) reads, one write).
+    // thread cache by splicing the list (O(max_blocks) reads, one write). In
+    // address-ordered mode refill_thread_cache() sorts them after unlocking.
     void pull_free_blocks_into_cache_locked(Page* page, ThreadCache& cache, size_t max_blocks) {
         Block* first = page->free_list;
         Block* last = first;
@@ -273,11 +1045,92 @@ private:
         cache.size += count;
     }
 
+    // Detaches up to max_blocks (no more than the arrays hold) blocks from a
+    // list owned by the calling thread and sorts them. Flushes and refills call
+    // this outside lock_central(), so the central lock never covers a sort.
+    static size_t take_sorted_batch(Block*& head, Block** batch, Block** scratch, size_t max_blocks) {
+        size_t count = 0;
+        while (count < max_blocks && head != nullptr) {
+            batch[count++] = head;
+            head = head->next;
+        }
+        sort_blocks_by_address(batch, scratch, count);
+        return count;
+    }
+
+    // Address-ordered refill: the cache was empty, so it now holds at most
+    // REFILL_BATCH blocks in free-list order. Relinks them so the cache pops
+    // them in ascending order.
+    static void sort_refilled_blocks(ThreadCache& cache) {
+        Block* batch[REFILL_BATCH];
+        Block* scratch[REFILL_BATCH];
+        Block* rest = cache.head;
+        const size_t count = take_sorted_batch(rest, batch, scratch, REFILL_BATCH);
+        cache.head = rest;
+        for (size_t i = count; i > 0; --i) {
+            batch[i - 1]->next = cache.head;
+            cache.head = batch[i - 1];
+        }
+    }
+
+    // Address-ordered flush: pushes a sorted batch highest address first so
+    // every page's free list ends up ascending (and each page header is touched
+    // in one run rather than once per scattered block).
+    void push_sorted_batch_locked(Block* const* batch, size_t count, bool allow_release_last_page) {
+        for (size_t i = count; i > 0; --i) {
+            Page* page = find_page(batch[i - 1]);
+            if (page != nullptr) {
+                push_block_to_page_locked(page, batch[i - 1], allow_release_last_page);
+            }
+        }
+    }
+
+    // LSD radix sort of block addresses, one byte per pass. Only bytes that
+    // differ somewhere in the batch get a pass, so a batch from a handful of
+    // nearby pages sorts in two or three passes over page + block index bits.
+    static void sort_blocks_by_address(Block** blocks, Block** scratch, size_t count) {
+        if (count < 2) {
+            return;
+        }
+        const uintptr_t first = reinterpret_cast<uintptr_t>(blocks[0]);
+        uintptr_t varying = 0;
+        for (size_t i = 1; i < count; ++i) {
+            varying |= reinterpret_cast<uintptr_t>(blocks[i]) ^ first;
+        }
+
+        Block** src = blocks;
+        Block** dst = scratch;
+        for (unsigned int shift = 0; shift < sizeof(uintptr_t) * 8; shift += 8) {
+            if (((varying >> shift) & 0xFF) == 0) {
+                continue;
+            }
+            size_t offsets[256] = {};
+            for (size_t i = 0; i < count; ++i) {
+                ++offsets[(reinterpret_cast<uintptr_t>(src[i]) >> shift) & 0xFF];
+            }
+            size_t sum = 0;
+            for (size_t& offset : offsets) {
+                const size_t bucket = offset;
+                offset = sum;
+                sum += bucket;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                dst[offsets[(reinterpret_cast<uintptr_t>(src[i]) >> shift) & 0xFF]++] = src[i];
+            }
+            Block** const swap = src;
+            src = dst;
+            dst = swap;
+        }
+        if (src != blocks) {
+            std::copy(src, src + count, blocks);
+        }
+    }
+
     void release_all_empty_pages_locked() {
         Page* page = m_page_list;
         while (page != nullptr) {
             Page* next = page->next;
-            if (page->fully_returned()) {
+            if (releasable_locked(page, true)) {
                 release_page_locked(page);
             }
             page = next;
@@ -299,25 +1152,120 @@ private:
         }
         --m_page_count;
         m_central_free_count -= page->cached_on_page;
+        count_slow_path(SlowPathCounter::PagesUnmapped);
+
+        // Handle-region indices are recycled right here, so their decommit
+        // cannot wait until after the lock; ordinary mappings can.
+        if (m_options.deferred_unmap && !handles_enabled()) {
+            m_pending_unmaps.push_back(MappedRange{page->mapping_base, page->mapping_size});
+            if (m_options.shared_budget != nullptr) {
+                m_options.shared_budget->credit(PAGE_SIZE);
+            }
+        } else {
+            unmap_page_locked(page);
+        }
+    }
 
-        unmap_page(page->mapping_base, page->mapping_size);
+    std::vector<MappedRange> take_pending_unmaps_locked() {
+        std::vector<MappedRange> pending;
+        pending.swap(m_pending_unmaps);
+        return pending;
     }
 
-    void grow_locked() {
-        const size_t mapping_size = PAGE_SIZE + PAGE_ALIGNMENT - 1;
-        void* const mapping_base = map_page(mapping_size);
-        if (mapping_base == nullptr) {
-            return;
+    // Called without m_mutex: the munmaps (and their TLB shootdowns) no longer
+    // hold up other threads' refills.
+    void unmap_released_pages(std::vector<MappedRange>& pending) {
+        if (!pending.empty()) {
+            const uint64_t start = slow_path_clock_ns();
+            const size_t calls = unmap_pages(pending.data(), pending.size());
+            count_elapsed_ns(SlowPathCounter::MunmapNs, start);
+            count_slow_path(SlowPathCounter::MunmapCalls, calls);
         }
+    }
 
-        const uintptr_t raw_address = reinterpret_cast<uintptr_t>(mapping_base);
-        const uintptr_t aligned_address =
-            (raw_address + PAGE_ALIGNMENT - 1) & ~(static_cast<uintptr_t>(PAGE_ALIGNMENT) - 1);
+    void unmap_page_locked(Page* page) {
+        const uint64_t start = slow_path_clock_ns();
+        if (handles_enabled()) {
+            // Keep the index reserved so handles stay shift-and-add; only the
+            // memory goes back to the OS.
+            m_region_free_pages.push_back(static_cast<size_t>(reinterpret_cast<char*>(page) - m_region_base) /
+                                          PAGE_SIZE);
+            decommit_region(page->mapping_base, page->mapping_size);
+        } else {
+            unmap_page(page->mapping_base, page->mapping_size);
+        }
+        count_elapsed_ns(SlowPathCounter::MunmapNs, start);
+        count_slow_path(SlowPathCounter::MunmapCalls);
+        if (m_options.shared_budget != nullptr) {
+            m_options.shared_budget->credit(PAGE_SIZE);
+        }
+    }
+
+    // Charges one page against byte_limit and the shared budget. This runs only
+    // when a page is about to be mapped, never on the thread-cache fast path.
+    bool charge_page_locked() {
+        if (m_options.byte_limit != 0 && (m_page_count + 1) * PAGE_SIZE > m_options.byte_limit) {
+            return false;
+        }
+        if (m_options.shared_budget != nullptr && !m_options.shared_budget->try_charge(PAGE_SIZE)) {
+            return false;
+        }
+        return true;
+    }
+
+    // With lock_pages, the new page is pinned (locking) and queued for
+    // lock_grown_pages(), which the caller runs once m_mutex is released.
+    // reserve() passes lock_new_page = false and mlocks its pages itself.
+    GrowResult grow_locked(bool lock_new_page = true) {
+        if (!charge_page_locked()) {
+            return GrowResult::QuotaExhausted;
+        }
+
+        void* mapping_base = nullptr;
+        size_t mapping_size = 0;
+        uintptr_t aligned_address = 0;
+        size_t color_offset = 0;
+        if (handles_enabled()) {
+            const size_t page_index = take_region_page_locked();
+            if (page_index != m_region_page_capacity) {
+                mapping_base = m_region_base + page_index * PAGE_SIZE;
+                mapping_size = PAGE_SIZE;
+                const uint64_t start = slow_path_clock_ns();
+                const bool committed = commit_region(mapping_base, mapping_size);
+                count_elapsed_ns(SlowPathCounter::MmapNs, start);
+                count_slow_path(SlowPathCounter::MmapCalls);
+                if (!committed) {
+                    m_region_free_pages.push_back(page_index);
+                    mapping_base = nullptr;
+                }
+                aligned_address = reinterpret_cast<uintptr_t>(mapping_base);
+                color_offset = region_block_offset(page_index) - PAGE_HEADER_SIZE;
+            }
+        } else {
+            mapping_size = READY_MAPPING_SIZE;
+            mapping_base = take_ready_page_locked();
+            if (mapping_base == nullptr) {
+                const uint64_t start = slow_path_clock_ns();
+                mapping_base = map_page(mapping_size);
+                count_elapsed_ns(SlowPathCounter::MmapNs, start);
+                count_slow_path(SlowPathCounter::MmapCalls);
+            }
+            const uintptr_t raw_address = reinterpret_cast<uintptr_t>(mapping_base);
+            aligned_address =
+                (raw_address + PAGE_ALIGNMENT - 1) & ~(static_cast<uintptr_t>(PAGE_ALIGNMENT) - 1);
+            color_offset = next_color_offset_locked();
+        }
+        if (mapping_base == nullptr) {
+            if (m_options.shared_budget != nullptr) {
+                m_options.shared_budget->credit(PAGE_SIZE);
+            }
+            return GrowResult::MapFailed;
+        }
 
         Page* new_page = new (reinterpret_cast<void*>(aligned_address)) Page();
         new_page->mapping_base = mapping_base;
         new_page->mapping_size = mapping_size;
-        new_page->block_base = reinterpret_cast<char*>(new_page) + sizeof(Page);
+        new_page->block_base = reinterpret_cast<char*>(new_page) + PAGE_HEADER_SIZE + color_offset;
         new_page->total_blocks = blocks_per_page();
         new_page->next = m_page_list;
         new_page->prev = nullptr;
@@ -326,6 +1274,251 @@ private:
         }
         m_page_list = new_page;
         ++m_page_count;
+        count_slow_path(SlowPathCounter::PagesMapped);
+        if (m_options.lock_pages && lock_new_page) {
+            new_page->locking = true;
+            m_pages_to_lock.push_back(new_page);
+        }
+        return GrowResult::Ok;
+    }
+
+    std::vector<Page*> take_pages_to_lock_locked() {
+        std::vector<Page*> pages;
+        pages.swap(m_pages_to_lock);
+        return pages;
+    }
+
+    // Called without m_mutex: mlocks pages grow_locked() queued (best effort;
+    // reserve() reports failures), then unpins them.
+    void lock_grown_pages(const std::vector<Page*>& pages) {
+        if (pages.empty()) {
+            return;
+        }
+        for (Page* page : pages) {
+            lock_region(page, PAGE_SIZE);
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Page* page : pages) {
+            page->locking = false;
+        }
+    }
+
+    // Pops a page premapped by the growth thread and asks for a replacement.
+    void* take_ready_page_locked() {
+        if (m_ready_pages.empty()) {
+            return nullptr;
+        }
+        void* mapping = m_ready_pages.back();
+        m_ready_pages.pop_back();
+        m_growth_cv.notify_one();
+        return mapping;
+    }
+
+    // The ready queue counts against byte_limit so premapping never lets the
+    // pool exceed it; the shared budget is charged when a page is adopted.
+    bool ready_queue_short_locked() const {
+        const size_t queued = m_ready_pages.size();
+        if (queued >= m_options.ready_pages) {
+            return false;
+        }
+        return m_options.byte_limit == 0 || (m_page_count + queued + 1) * PAGE_SIZE <= m_options.byte_limit;
+    }
+
+    // Keeps m_ready_pages topped up. The mmap (and optional prefault) run
+    // without m_mutex, so no refill ever waits behind them.
+    void growth_thread_main() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_growth_cv.wait(lock, [this]() { return m_stop_growth || ready_queue_short_locked(); });
+            if (m_stop_growth) {
+                return;
+            }
+            lock.unlock();
+            const uint64_t start = slow_path_clock_ns();
+            void* mapping = map_page(READY_MAPPING_SIZE);
+            count_elapsed_ns(SlowPathCounter::MmapNs, start);
+            count_slow_path(SlowPathCounter::MmapCalls);
+            if (mapping != nullptr && m_options.prefault_ready_pages) {
+                const uintptr_t raw = reinterpret_cast<uintptr_t>(mapping);
+                const uintptr_t aligned = (raw + PAGE_ALIGNMENT - 1) & ~(static_cast<uintptr_t>(PAGE_ALIGNMENT) - 1);
+                prefault_region(reinterpret_cast<void*>(aligned), PAGE_SIZE);
+            }
+            lock.lock();
+            if (mapping == nullptr) {
+                m_growth_cv.wait_for(lock, GROWTH_RETRY_DELAY, [this]() { return m_stop_growth; });
+                continue;
+            }
+            m_ready_pages.push_back(mapping);
+        }
+    }
+
+    void stop_growth_thread() {
+        if (!m_growth_thread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop_growth = true;
+        }
+        m_growth_cv.notify_all();
+        m_growth_thread.join();
+    }
+
+    // Pages are 64 KB-aligned, so without coloring the Nth block of every page
+    // lands in the same cache sets. Successive pages shift their block region
+    // by one more cache line, wrapping within the page's slack.
+    size_t next_color_offset_locked() {
+        if (!m_options.cache_coloring || color_count() == 1) {
+            return 0;
+        }
+        const size_t color = m_next_color;
+        m_next_color = (m_next_color + 1) % color_count();
+        return color * CACHE_LINE_SIZE;
+    }
+
+    // In the handle region a page's color follows from its index, so resolve()
+    // can recompute the block offset without reading the page header.
+    size_t region_block_offset(size_t page_index) const {
+        if (!m_options.cache_coloring || color_count() == 1) {
+            return PAGE_HEADER_SIZE;
+        }
+        return PAGE_HEADER_SIZE + (page_index % color_count()) * CACHE_LINE_SIZE;
+    }
+
+    // Reserves the handle region (and the generation table) up front. Falls
+    // back to ordinary page mapping, with handles disabled, if that fails.
+    void reserve_handle_region_locked() {
+        const unsigned int generation_bits = m_options.handle_generation_bits < MAX_GENERATION_BITS
+                                                 ? m_options.handle_generation_bits
+                                                 : MAX_GENERATION_BITS;
+        const unsigned int page_bits = 32U - SLOT_BITS - generation_bits;
+        // Index 2^page_bits - 1 is left out so no handle can equal INVALID_HANDLE.
+        const size_t addressable_pages = (size_t{1} << page_bits) - 1;
+        const size_t pages = m_options.handle_region_pages < addressable_pages ? m_options.handle_region_pages
+                                                                               : addressable_pages;
+
+        const size_t mapping_size = pages * PAGE_SIZE + PAGE_ALIGNMENT;
+        void* const mapping = reserve_region(mapping_size);
+        if (mapping == nullptr) {
+            return;
+        }
+        std::atomic<uint8_t>* generations = nullptr;
+        const size_t generations_size = pages * blocks_per_page();
+        if (generation_bits != 0) {
+            // Zero-filled on first touch, which is a valid all-zero generation.
+            void* table = reserve_region(generations_size);
+            if (table == nullptr || !commit_region(table, generations_size)) {
+                release_region(table, generations_size);
+                release_region(mapping, mapping_size);
+                return;
+            }
+            generations = static_cast<std::atomic<uint8_t>*>(table);
+        }
+
+        const uintptr_t raw_address = reinterpret_cast<uintptr_t>(mapping);
+        m_region_base = reinterpret_cast<char*>((raw_address + PAGE_ALIGNMENT - 1) &
+                                                ~(static_cast<uintptr_t>(PAGE_ALIGNMENT) - 1));
+        m_region_mapping = mapping;
+        m_region_mapping_size = mapping_size;
+        m_region_page_capacity = pages;
+        m_handle_page_mask = (size_t{1} << page_bits) - 1;
+        m_handle_generation_bits = generation_bits;
+        m_handle_generation_mask = static_cast<uint8_t>((1U << generation_bits) - 1);
+        m_generations = generations;
+        m_generations_size = generation_bits != 0 ? generations_size : 0;
+    }
+
+    // A recycled index if there is one, else the next never-used one. Returns
+    // m_region_page_capacity when the region is full.
+    size_t take_region_page_locked() {
+        if (!m_region_free_pages.empty()) {
+            const size_t page_index = m_region_free_pages.back();
+            m_region_free_pages.pop_back();
+            return page_index;
+        }
+        if (m_region_next_page < m_region_page_capacity) {
+            return m_region_next_page++;
+        }
+        return m_region_page_capacity;
+    }
+
+    std::atomic<uint8_t>& generation_slot(size_t page_index, size_t slot) const {
+        return m_generations[page_index * blocks_per_page() + slot];
+    }
+
+    Handle handle_generation(Handle handle) const {
+        return handle >> (32U - m_handle_generation_bits);
+    }
+
+    uint8_t next_generation(uint8_t generation) const {
+        return static_cast<uint8_t>((generation + 1U) & m_handle_generation_mask);
+    }
+
+    // Page index and slot of a block inside the handle region; false for
+    // pointers outside it, into a page's unused tail, or into a block's middle.
+    bool region_slot(const void* ptr, size_t& page_index, size_t& slot) const {
+        const char* address = static_cast<const char*>(ptr);
+        if (!handles_enabled() || address < m_region_base ||
+            address >= m_region_base + m_region_page_capacity * PAGE_SIZE) {
+            return false;
+        }
+        page_index = static_cast<size_t>(address - m_region_base) / PAGE_SIZE;
+        const char* block_base = m_region_base + page_index * PAGE_SIZE + region_block_offset(page_index);
+        if (address < block_base) {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(address - block_base);
+        slot = offset / BlockSize;
+        return slot < blocks_per_page() && offset % BlockSize == 0;
+    }
+
+    // A block freed through deallocate() rather than deallocate_handle() still
+    // invalidates the handles taken to it.
+    void age_handle_generation(const void* ptr) {
+        size_t page_index = 0;
+        size_t slot = 0;
+        if (!region_slot(ptr, page_index, slot)) {
+            return;
+        }
+        std::atomic<uint8_t>& generation = generation_slot(page_index, slot);
+        uint8_t current = generation.load(std::memory_order_relaxed);
+        while (!generation.compare_exchange_weak(
+            current, next_generation(current), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        }
+    }
+
+    // deallocate() minus the generation bookkeeping.
+    void free_block(void* ptr) {
+        ThreadCache& cache = thread_cache();
+        if (--cache.deallocate_countdown == 0) {
+            deallocate_sampled(cache, ptr);
+            return;
+        }
+        deallocate_to(cache, ptr);
+    }
+
+    // Wakes refills blocked on the quota after blocks or pages came home.
+    void notify_quota_waiters_locked() {
+        if (m_quota_waiters > 0) {
+            m_quota_cv.notify_all();
+        }
+    }
+
+    // Sleeps until something is returned to the central pool or the deadline
+    // passes. Returns false once the deadline has already expired.
+    bool wait_for_quota_locked(std::unique_lock<std::mutex>& lock, Clock::time_point deadline) {
+        const Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        Clock::time_point wake = deadline;
+        if (m_options.shared_budget != nullptr && now + SHARED_BUDGET_POLL < deadline) {
+            wake = now + SHARED_BUDGET_POLL;
+        }
+        ++m_quota_waiters;
+        m_quota_cv.wait_until(lock, wake);
+        --m_quota_waiters;
+        return true;
     }
 
     // -------------------------------------------------------------------------
@@ -336,7 +1529,8 @@ private:
         const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
         auto* page = reinterpret_cast<Page*>(address & ~(static_cast<uintptr_t>(PAGE_ALIGNMENT) - 1));
 
-        const uintptr_t block_start = reinterpret_cast<uintptr_t>(page) + sizeof(Page);
+        // Colored pages start their blocks later, never earlier, than this.
+        const uintptr_t block_start = reinterpret_cast<uintptr_t>(page) + PAGE_HEADER_SIZE;
         const uintptr_t page_end = reinterpret_cast<uintptr_t>(page) + PAGE_SIZE;
         if (address < block_start || address >= page_end) {
             return nullptr;
@@ -359,7 +1553,18 @@ private:
         if (s_fast_owner == this) {
             return *s_fast_cache;
         }
-        ThreadCache& cache = thread_cache_map()[this];
+        auto [entry, inserted] = thread_cache_map().try_emplace(this);
+        ThreadCache& cache = entry->second;
+        if (inserted) {
+            cache.latency_left = m_sample_interval;
+            cache.deallocate_countdown = m_sample_interval;
+            if (m_options.heap_profiler != nullptr) {
+                cache.profile_rng = reinterpret_cast<uintptr_t>(&cache) ^ m_clock_epoch_ticks;
+                cache.profile_left = next_profile_interval(cache);
+            }
+            cache.allocate_period = std::min(cache.latency_left, cache.profile_left);
+            cache.allocate_countdown = cache.allocate_period;
+        }
         s_fast_owner = this;
         s_fast_cache = &cache;
         return cache;
@@ -378,13 +1583,47 @@ private:
         return caches;
     }
 
+    ThreadLatency& thread_latency(ThreadCache& cache) {
+        if (cache.latency.get() == nullptr) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            cache.latency.claim(claim_thread_latency_locked());
+        }
+        return *cache.latency.get();
+    }
+
+    // Reuses the slot of a thread whose cache released it, after folding its
+    // samples into m_exited_latency, so thread churn does not grow the list.
+    std::shared_ptr<ThreadLatency> claim_thread_latency_locked() {
+        for (const std::shared_ptr<ThreadLatency>& slot : m_thread_latencies) {
+            if (slot->released.load(std::memory_order_acquire)) {
+                m_exited_latency.allocate.merge(slot->allocate);
+                m_exited_latency.deallocate.merge(slot->deallocate);
+                slot->allocate.clear();
+                slot->deallocate.clear();
+                slot->released.store(false, std::memory_order_relaxed);
+                return slot;
+            }
+        }
+        m_thread_latencies.push_back(std::make_shared<ThreadLatency>());
+        return m_thread_latencies.back();
+    }
+
+    double nanoseconds_per_tick() const {
+        const uint64_t ticks = read_cycle_counter() - m_clock_epoch_ticks;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_clock_epoch);
+        return ticks == 0 ? 1.0 : static_cast<double>(elapsed.count()) / static_cast<double>(ticks);
+    }
+
     // Hands out one block from the cache: recycled blocks first, then the
     // untouched bump range. Returns nullptr only when both are exhausted.
+    // The next recycled block is prefetched so its link is warm for the next
+    // pop (prefetching nullptr at the end of the list is harmless).
     static Block* take_from_thread_cache(ThreadCache& cache) {
         if (cache.head != nullptr) {
             Block* block = cache.head;
             cache.head = block->next;
             cache.size--;
+            prefetch_block(cache.head);
             return block;
         }
         if (cache.bump_ptr != cache.bump_end) {
@@ -395,18 +1634,178 @@ private:
         return nullptr;
     }
 
-    // Refills a thread cache from the central pool. Recycled central blocks are
-    // reused first (bounds memory use); otherwise a fresh contiguous range is
-    // carved (O(1), no block memory touched), growing by a page if needed.
-    // Returns false only on OOM.
+    static void prefetch_block(const Block* block) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(block, 1, 3);
+#else
+        (void)block;
+#endif
+    }
+
+    // allocate() and deallocate() proper; the public entry points only add
+    // the sampling countdown in front.
+    void* allocate_from(ThreadCache& cache) {
+        Block* block = take_from_thread_cache(cache);
+        if (block == nullptr) {
+            if (!refill_thread_cache(cache)) {
+                return nullptr;
+            }
+            block = take_from_thread_cache(cache);
+            if (block == nullptr) {
+                return nullptr;
+            }
+        }
+
+        Page* page = find_page(block);
+        if (page == nullptr) {
+            return nullptr;
+        }
+        page->live_count.fetch_add(1, std::memory_order_relaxed);
+        return static_cast<void*>(block);
+    }
+
+    void deallocate_to(ThreadCache& cache, void* ptr) {
+        Page* page = find_page(ptr);
+        if (page == nullptr) {
+            return;
+        }
+        page->live_count.fetch_sub(1, std::memory_order_relaxed);
+        if (m_options.heap_profiler != nullptr && m_options.heap_profiler->maybe_sampled(ptr)) {
+            m_options.heap_profiler->record_free(ptr);
+        }
+
+#if CMA_SLOW_PATH_STATS
+        if (page->refilled_by.load(std::memory_order_relaxed) != &cache) {
+            ++cache.cross_thread_frees;
+        }
+#endif
+        Block* block = static_cast<Block*>(ptr);
+        block->next = cache.head;
+        cache.head = block;
+        ++cache.size;
+
+        if (cache.size > HIGH_WATER_MARK) {
+            flush_excess_thread_cache(cache);
+        }
+    }
+
+    // The clock reads are the only work added to a timed call; the histogram
+    // update (and any stack capture) happens after the second read.
+    void* allocate_sampled(ThreadCache& cache) {
+        cache.latency_left -= cache.allocate_period;
+        cache.profile_left -= cache.allocate_period;
+        void* block = nullptr;
+        if (cache.latency_left == 0) {
+            const uint64_t start = read_cycle_counter();
+            block = allocate_from(cache);
+            const uint64_t end = read_cycle_counter();
+            thread_latency(cache).allocate.record(end - start);
+            cache.latency_left = m_sample_interval;
+        } else {
+            block = allocate_from(cache);
+        }
+        if (cache.profile_left == 0) {
+            if (block != nullptr) {
+                m_options.heap_profiler->record_allocation(block, profile_weight_bytes());
+            }
+            cache.profile_left = next_profile_interval(cache);
+        }
+        cache.allocate_period = std::min(cache.latency_left, cache.profile_left);
+        cache.allocate_countdown = cache.allocate_period;
+        return block;
+    }
+
+    // Mean blocks between heap-profile samples.
+    size_t profile_mean_blocks() const {
+        const size_t blocks = m_options.heap_profiler->sample_bytes() / BlockSize;
+        return blocks == 0 ? 1 : blocks;
+    }
+
+    // Bytes of allocation one sample stands for.
+    size_t profile_weight_bytes() const {
+        return profile_mean_blocks() * BlockSize;
+    }
+
+    // Exponentially distributed gaps (mean profile_mean_blocks()) keep the
+    // sampler from locking onto periodic allocation patterns.
+    size_t next_profile_interval(ThreadCache& cache) const {
+        const size_t mean = profile_mean_blocks();
+        if (mean == 1) {
+            return 1;
+        }
+        uint64_t x = cache.profile_rng;  // xorshift64
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        cache.profile_rng = x;
+        const double uniform = (static_cast<double>(x >> 11) + 1.0) * (1.0 / 9007199254740992.0);  // (0, 1]
+        const double gap = std::ceil(-std::log(uniform) * static_cast<double>(mean));
+        return gap < 1.0 ? 1 : static_cast<size_t>(gap);
+    }
+
+    void deallocate_sampled(ThreadCache& cache, void* ptr) {
+        const uint64_t start = read_cycle_counter();
+        deallocate_to(cache, ptr);
+        const uint64_t end = read_cycle_counter();
+        thread_latency(cache).deallocate.record(end - start);
+        cache.deallocate_countdown = m_sample_interval;
+    }
+
+    // Refills a thread cache from the central pool, applying the quota policy
+    // when the pool would have to grow past its limit. Returns false on OOM or
+    // when the policy gives up.
     bool refill_thread_cache(ThreadCache& cache) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unique_lock<std::mutex> lock = lock_central();
+        const Clock::time_point deadline = Clock::now() + m_options.quota_timeout;
+        bool callback_invoked = false;
+
+        for (;;) {
+            const GrowResult result = refill_thread_cache_locked(cache);
+            if (result == GrowResult::Ok) {
+                const std::vector<Page*> grown = take_pages_to_lock_locked();
+                lock.unlock();
+                if (m_options.address_ordered) {
+                    sort_refilled_blocks(cache);
+                }
+                lock_grown_pages(grown);
+                return true;
+            }
+            if (result == GrowResult::MapFailed) {
+                return false;
+            }
 
+            switch (m_options.quota_policy) {
+            case QuotaPolicy::FailFast:
+                return false;
+            case QuotaPolicy::Callback:
+                if (callback_invoked || !m_options.on_quota_exhausted) {
+                    return false;
+                }
+                callback_invoked = true;
+                lock.unlock();
+                m_options.on_quota_exhausted();
+                lock.lock();
+                break;
+            case QuotaPolicy::Block:
+                if (!wait_for_quota_locked(lock, deadline)) {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+
+    // Recycled central blocks are reused first (bounds memory use); otherwise a
+    // fresh contiguous range is carved (O(1), no block memory touched), growing
+    // by a page if needed.
+    GrowResult refill_thread_cache_locked(ThreadCache& cache) {
         if (m_central_free_count > 0) {
             for (Page* page = m_page_list; page != nullptr; page = page->next) {
-                if (page->free_list != nullptr) {
+                if (page->free_list != nullptr && !page->evacuating) {
                     pull_free_blocks_into_cache_locked(page, cache, REFILL_BATCH);
-                    return true;
+                    note_refilled_by(page, cache);
+                    count_slow_path(SlowPathCounter::RefillsRecycled);
+                    return GrowResult::Ok;
                 }
             }
         }
@@ -414,12 +1813,14 @@ private:
         // Only the head page can still have un-carved capacity (we always grow
         // and carve at the head), so a single check suffices.
         Page* page = m_page_list;
+        SlowPathCounter source = SlowPathCounter::RefillsBump;
         if (page == nullptr || page->bump_offset >= page->total_blocks) {
-            grow_locked();
-            page = m_page_list;
-            if (page == nullptr || page->bump_offset >= page->total_blocks) {
-                return false;
+            const GrowResult grown = grow_locked();
+            if (grown != GrowResult::Ok) {
+                return grown;
             }
+            page = m_page_list;
+            source = SlowPathCounter::RefillsGrowth;
         }
 
         const size_t avail = page->total_blocks - page->bump_offset;
@@ -427,34 +1828,69 @@ private:
         cache.bump_ptr = page->block_base + page->bump_offset * BlockSize;
         cache.bump_end = cache.bump_ptr + take * BlockSize;
         page->bump_offset += take;
-        return true;
+        note_refilled_by(page, cache);
+        count_slow_path(source);
+        return GrowResult::Ok;
     }
 
     void flush_excess_thread_cache(ThreadCache& cache) {
+        publish_cross_thread_frees(cache);
         while (cache.size > HIGH_WATER_MARK) {
             const size_t to_flush = (cache.size > HIGH_WATER_MARK + FLUSH_BATCH)
                                         ? FLUSH_BATCH
                                         : cache.size - HIGH_WATER_MARK;
 
-            std::lock_guard<std::mutex> lock(m_mutex);
-            for (size_t i = 0; i < to_flush; ++i) {
-                Block* block = cache.head;
-                cache.head = block->next;
-                cache.size--;
-                Page* page = find_page(block);
-                if (page != nullptr) {
-                    push_block_to_page_locked(page, block, false);
+            if (m_options.address_ordered) {
+                flush_sorted_batch(cache, to_flush);
+                continue;
+            }
+
+            std::vector<MappedRange> released_pages;
+            {
+                const std::unique_lock<std::mutex> lock = lock_central();
+                count_slow_path(SlowPathCounter::Flushes);
+                for (size_t i = 0; i < to_flush; ++i) {
+                    Block* block = cache.head;
+                    cache.head = block->next;
+                    cache.size--;
+                    Page* page = find_page(block);
+                    if (page != nullptr) {
+                        push_block_to_page_locked(page, block, false);
+                    }
                 }
+                notify_quota_waiters_locked();
+                released_pages = take_pending_unmaps_locked();
             }
+            unmap_released_pages(released_pages);
+        }
+    }
+
+    // Address-ordered flush of to_flush blocks, sorted before lock_central().
+    // Kept apart so the default flush loop carries no batch arrays.
+    void flush_sorted_batch(ThreadCache& cache, size_t to_flush) {
+        Block* batch[FLUSH_BATCH];
+        Block* scratch[FLUSH_BATCH];
+        const size_t count = take_sorted_batch(cache.head, batch, scratch, to_flush);
+        cache.size -= count;
+
+        std::vector<MappedRange> released_pages;
+        {
+            const std::unique_lock<std::mutex> lock = lock_central();
+            count_slow_path(SlowPathCounter::Flushes);
+            push_sorted_batch_locked(batch, count, false);
+            notify_quota_waiters_locked();
+            released_pages = take_pending_unmaps_locked();
         }
+        unmap_released_pages(released_pages);
     }
 
     void flush_all_local_cache_to_central() {
         ThreadCache& cache = thread_cache();
+        publish_cross_thread_frees(cache);
 
         Block* head = cache.head;
         char* bump_ptr = cache.bump_ptr;
-        char* const bump_end = cache.bump_end;
+        char* bump_end = cache.bump_end;
         cache.head = nullptr;
         cache.size = 0;
         cache.bump_ptr = nullptr;
@@ -464,24 +1900,54 @@ private:
             return;
         }
 
-        std::lock_guard<std::mutex> lock(m_mutex);
-        while (head != nullptr) {
-            Block* block = head;
-            head = block->next;
-            Page* page = find_page(block);
-            if (page != nullptr) {
-                push_block_to_page_locked(page, block, true);
+        // Address-ordered: the cache can hold several batches, so each one is
+        // sorted unlocked and pushed under its own short hold of the lock.
+        if (m_options.address_ordered) {
+            Block* batch[FLUSH_BATCH];
+            Block* scratch[FLUSH_BATCH];
+            while (head != nullptr) {
+                const size_t count = take_sorted_batch(head, batch, scratch, FLUSH_BATCH);
+                const std::unique_lock<std::mutex> lock = lock_central();
+                push_sorted_batch_locked(batch, count, true);
             }
         }
-        // Return the never-used tail of the bump range so its page can be freed.
-        for (; bump_ptr != bump_end; bump_ptr += BlockSize) {
-            Block* block = reinterpret_cast<Block*>(bump_ptr);
-            Page* page = find_page(block);
-            if (page != nullptr) {
-                push_block_to_page_locked(page, block, true);
+
+        std::vector<MappedRange> released_pages;
+        {
+            const std::unique_lock<std::mutex> lock = lock_central();
+            count_slow_path(SlowPathCounter::Flushes);
+            while (head != nullptr) {
+                Block* block = head;
+                head = block->next;
+                Page* page = find_page(block);
+                if (page != nullptr) {
+                    push_block_to_page_locked(page, block, true);
+                }
+            }
+            // Return the never-used tail of the bump range so its page can be freed
+            // (highest first in address-ordered mode, keeping the free list ascending).
+            if (m_options.address_ordered) {
+                while (bump_end != bump_ptr) {
+                    bump_end -= BlockSize;
+                    Block* block = reinterpret_cast<Block*>(bump_end);
+                    Page* page = find_page(block);
+                    if (page != nullptr) {
+                        push_block_to_page_locked(page, block, true);
+                    }
+                }
+            }
+            for (; bump_ptr != bump_end; bump_ptr += BlockSize) {
+                Block* block = reinterpret_cast<Block*>(bump_ptr);
+                Page* page = find_page(block);
+                if (page != nullptr) {
+                    push_block_to_page_locked(page, block, true);
+                }
             }
+            release_all_empty_pages_locked();
+            notify_quota_waiters_locked();
+            released_pages = take_pending_unmaps_locked();
         }
-        release_all_empty_pages_locked();
+        unmap_released_pages(released_pages);
     }
 };
 
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "PlatformMemory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cma {
+
+/**
+ * A sampling heap profiler that several allocators can share (see
+ * AllocatorOptions::heap_profiler). Allocators pick roughly one block per
+ * sample_bytes() allocated, and the profiler records the allocating stack
+ * for that block. The sample is dropped when the block is freed, so the
+ * table only ever holds live samples. Each sample stands for about
+ * sample_bytes() of live memory, which is how live bytes per call site are
+ * estimated.
+ *
+ * Frees check a lock-free counting filter first. Only a filter hit takes the
+ * profiler's mutex, so unsampled frees stay off the lock.
+ */
+class HeapProfiler {
+public:
+    static constexpr size_t MAX_FRAMES = 32;
+
+    // One distinct allocating stack and the estimates attributed to it.
+    struct Site {
+        std::vector<void*> frames;  // innermost first
+        size_t live_samples = 0;
+        size_t live_bytes = 0;      // estimated: sum of live samples' weights
+        size_t total_samples = 0;   // including freed
+        size_t total_bytes = 0;
+    };
+
+    explicit HeapProfiler(size_t sample_bytes) : m_sample_bytes(sample_bytes == 0 ? 1 : sample_bytes) {}
+
+    HeapProfiler(const HeapProfiler&) = delete;
+    HeapProfiler& operator=(const HeapProfiler&) = delete;
+
+    size_t sample_bytes() const {
+        return m_sample_bytes;
+    }
+
+    // Captures the calling stack for @p block, which stands for @p weight_bytes
+    // of allocation.
+    void record_allocation(const void* block, size_t weight_bytes) {
+        StackKey key;
+        key.depth = capture_stack(key.frames, MAX_FRAMES, 1);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [entry, inserted] = m_site_index.try_emplace(key, m_sites.size());
+        if (inserted) {
+            m_sites.push_back(Site{std::vector<void*>(key.frames, key.frames + key.depth), 0, 0, 0, 0});
+        }
+        Site& site = m_sites[entry->second];
+        ++site.live_samples;
+        site.live_bytes += weight_bytes;
+        ++site.total_samples;
+        site.total_bytes += weight_bytes;
+
+        auto [live, fresh] = m_live.try_emplace(block, LiveSample{entry->second, weight_bytes});
+        if (fresh) {
+            filter_slot(block).fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // The block's earlier life was never reported freed; forget it.
+            Site& stale = m_sites[live->second.site];
+            --stale.live_samples;
+            stale.live_bytes -= live->second.weight_bytes;
+            live->second = LiveSample{entry->second, weight_bytes};
+        }
+    }
+
+    // False means @p block is certainly not sampled; true means it may be.
+    bool maybe_sampled(const void* block) const {
+        return filter_slot(block).load(std::memory_order_relaxed) != 0;
+    }
+
+    // Drops @p block's sample, if it has one.
+    void record_free(const void* block) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_live.find(block);
+        if (it == m_live.end()) {
+            return;
+        }
+        Site& site = m_sites[it->second.site];
+        --site.live_samples;
+        site.live_bytes -= it->second.weight_bytes;
+        m_live.erase(it);
+        filter_slot(block).fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Keeps a sample attached to its data when compaction relocates a block.
+    void record_move(const void* from, const void* to) {
+        if (!maybe_sampled(from)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_live.find(from);
+        if (it == m_live.end()) {
+            return;
+        }
+        const LiveSample sample = it->second;
+        m_live.erase(it);
+        filter_slot(from).fetch_sub(1, std::memory_order_relaxed);
+        if (m_live.emplace(to, sample).second) {
+            filter_slot(to).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    size_t live_samples() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_live.size();
+    }
+
+    size_t live_bytes() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t total = 0;
+        for (const Site& site : m_sites) {
+            total += site.live_bytes;
+        }
+        return total;
+    }
+
+    // Sites that still hold live samples, most live bytes first.
+    std::vector<Site> live_sites() const {
+        std::vector<Site> sites;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const Site& site : m_sites) {
+                if (site.live_samples != 0) {
+                    sites.push_back(site);
+                }
+            }
+        }
+        std::sort(sites.begin(), sites.end(), [](const Site& a, const Site& b) {
+            return a.live_bytes > b.live_bytes;
+        });
+        return sites;
+    }
+
+    /**
+     * Writes live bytes by call site in the collapsed-stack format that
+     * flamegraph.pl and speedscope read. Each line lists the frames from
+     * outermost to innermost, separated by ';', then a space and the
+     * estimated live bytes.
+     */
+    void write_collapsed(std::ostream& out) const {
+        for (const Site& site : live_sites()) {
+            for (size_t i = site.frames.size(); i > 0; --i) {
+                std::string name = describe_frame(site.frames[i - 1]);
+                std::replace(name.begin(), name.end(), ';', ':');
+                out << name << (i > 1 ? ";" : "");
+            }
+            if (site.frames.empty()) {
+                out << "[unknown]";
+            }
+            out << ' ' << site.live_bytes << '\n';
+        }
+    }
+
+    /**
+     * Writes the legacy gperftools heap-profile text format, which `pprof`
+     * can symbolize against the binary. Object columns are sample counts and
+     * byte columns are already-scaled estimates, hence the plain
+     * "heapprofile" tag (pprof must not unsample again).
+     */
+    void write_pprof(std::ostream& out) const {
+        const std::vector<Site> sites = live_sites();
+        size_t live_samples = 0;
+        size_t live_bytes = 0;
+        size_t total_samples = 0;
+        size_t total_bytes = 0;
+        for (const Site& site : sites) {
+            live_samples += site.live_samples;
+            live_bytes += site.live_bytes;
+            total_samples += site.total_samples;
+            total_bytes += site.total_bytes;
+        }
+        out << "heap profile: " << live_samples << ": " << live_bytes << " [" << total_samples << ": "
+            << total_bytes << "] @ heapprofile\n";
+        for (const Site& site : sites) {
+            out << site.live_samples << ": " << site.live_bytes << " [" << site.total_samples << ": "
+                << site.total_bytes << "] @";
+            for (void* frame : site.frames) {
+                out << " 0x" << std::hex << reinterpret_cast<uintptr_t>(frame) << std::dec;
+            }
+            out << '\n';
+        }
+        out << "\nMAPPED_LIBRARIES:\n" << read_memory_map();
+    }
+
+private:
+    static constexpr size_t FILTER_BITS = 14;
+
+    struct StackKey {
+        void* frames[MAX_FRAMES] = {};
+        size_t depth = 0;
+
+        bool operator==(const StackKey& other) const {
+            return depth == other.depth && std::memcmp(frames, other.frames, depth * sizeof(void*)) == 0;
+        }
+    };
+
+    struct StackKeyHash {
+        size_t operator()(const StackKey& key) const {
+            uint64_t hash = 1469598103934665603ULL;  // FNV-1a over the return addresses
+            for (size_t i = 0; i < key.depth; ++i) {
+                hash = (hash ^ reinterpret_cast<uintptr_t>(key.frames[i])) * 1099511628211ULL;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct LiveSample {
+        size_t site;
+        size_t weight_bytes;
+    };
+
+    std::atomic<uint32_t>& filter_slot(const void* block) const {
+        const uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(block) >> 3) * 0x9E3779B97F4A7C15ULL;
+        return m_filter[hash >> (64 - FILTER_BITS)];
+    }
+
+    const size_t m_sample_bytes;
+    mutable std::mutex m_mutex;
+    std::vector<Site> m_sites;
+    std::unordered_map<StackKey, size_t, StackKeyHash> m_site_index;
+    std::unordered_map<const void*, LiveSample> m_live;
+    // Live samples per hash slot; a zero slot proves a block was never sampled.
+    mutable std::atomic<uint32_t> m_filter[size_t{1} << FILTER_BITS] = {};
+};
+
+} // namespace cma
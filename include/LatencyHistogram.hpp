@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CMA_HAS_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define CMA_HAS_RDTSC 1
+#else
+#define CMA_HAS_RDTSC 0
+#endif
+
+namespace cma {
+
+/**
+ * A cheap monotonic tick: the TSC on x86 (assumed invariant, as on any CPU
+ * from the last decade), steady_clock nanoseconds elsewhere. Callers convert
+ * ticks to nanoseconds against a steady_clock interval of their own.
+ */
+inline uint64_t read_cycle_counter() {
+#if CMA_HAS_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+// Percentiles of one histogram, already scaled to the caller's unit.
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+};
+
+/**
+ * Log-linear histogram (HDR style): values below SUB_BUCKETS get exact buckets,
+ * and every power of two above that is split into SUB_BUCKETS linear steps, so a
+ * recorded value is off by at most 1/SUB_BUCKETS. Covers the full uint64_t range
+ * in a fixed 8 KB table.
+ *
+ * record() is meant for a single writer (relaxed load + store, no lock prefix);
+ * merge() and the readers may run concurrently with it and see a slightly
+ * stale but never torn count.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned int SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram& other) {
+        merge(other);
+    }
+
+    LatencyHistogram& operator=(const LatencyHistogram& other) {
+        if (this != &other) {
+            clear();
+            merge(other);
+        }
+        return *this;
+    }
+
+    void record(uint64_t value) {
+        std::atomic<uint64_t>& bucket = m_buckets[bucket_index(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > m_max.load(std::memory_order_relaxed)) {
+            m_max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds @p other's samples into this histogram. Safe while @p other is being
+    // recorded into; this histogram must not have a concurrent writer.
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            const uint64_t samples = other.m_buckets[i].load(std::memory_order_relaxed);
+            if (samples != 0) {
+                m_buckets[i].store(m_buckets[i].load(std::memory_order_relaxed) + samples,
+                                   std::memory_order_relaxed);
+            }
+        }
+        m_count.store(m_count.load(std::memory_order_relaxed) + other.count(), std::memory_order_relaxed);
+        if (other.max() > max()) {
+            m_max.store(other.max(), std::memory_order_relaxed);
+        }
+    }
+
+    void clear() {
+        for (std::atomic<uint64_t>& bucket : m_buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t max() const {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    // Smallest bucket upper bound covering @p quantile (0..1) of the samples,
+    // capped at the recorded maximum. 0 when empty.
+    uint64_t value_at_quantile(double quantile) const {
+        uint64_t total = 0;
+        for (const std::atomic<uint64_t>& bucket : m_buckets) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total) + 0.5);
+        rank = rank == 0 ? 1 : (rank > total ? total : rank);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                const uint64_t upper = bucket_upper_bound(i);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    // Percentiles multiplied by @p scale (e.g. nanoseconds per tick).
+    LatencySummary summarize(double scale = 1.0) const {
+        auto scaled = [scale](uint64_t value) {
+            return static_cast<uint64_t>(static_cast<double>(value) * scale + 0.5);
+        };
+        LatencySummary summary;
+        summary.count = count();
+        summary.p50 = scaled(value_at_quantile(0.50));
+        summary.p90 = scaled(value_at_quantile(0.90));
+        summary.p99 = scaled(value_at_quantile(0.99));
+        summary.p999 = scaled(value_at_quantile(0.999));
+        summary.max = scaled(max());
+        return summary;
+    }
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned int shift = highest_bit(value) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Largest value that lands in bucket @p index.
+    static uint64_t bucket_upper_bound(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        const unsigned int shift = static_cast<unsigned int>(index / SUB_BUCKETS - 1);
+        const uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + ((uint64_t{1} << shift) - 1);
+    }
+
+private:
+    static unsigned int highest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63U - static_cast<unsigned int>(__builtin_clzll(value));
+#else
+        unsigned int bit = 0;
+        while (value >>= 1) {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    std::atomic<uint64_t> m_buckets[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+} // namespace cma
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace cma {
+
+/**
+ * A byte budget that several allocators can draw pages from. Allocators charge
+ * the budget when they map a page and credit it when the page is unmapped, so
+ * the limit is enforced at page granularity and never on the per-block path.
+ */
+class MemoryBudget {
+public:
+    explicit MemoryBudget(size_t limit_bytes) : m_limit(limit_bytes) {}
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    /**
+     * Reserves @p bytes if they fit under the limit.
+     * @return false (and charges nothing) when the budget is exhausted.
+     */
+    bool try_charge(size_t bytes) {
+        size_t used = m_used.load(std::memory_order_relaxed);
+        do {
+            if (bytes > m_limit || used > m_limit - bytes) {
+                return false;
+            }
+        } while (!m_used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * Returns bytes previously taken with try_charge().
+     */
+    void credit(size_t bytes) {
+        m_used.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    size_t limit() const {
+        return m_limit;
+    }
+
+    size_t used() const {
+        return m_used.load(std::memory_order_relaxed);
+    }
+
+    size_t available() const {
+        const size_t used_now = used();
+        return used_now >= m_limit ? 0 : m_limit - used_now;
+    }
+
+private:
+    const size_t m_limit;
+    std::atomic<size_t> m_used{0};
+};
+
+} // namespace cma
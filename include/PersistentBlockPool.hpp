@@ -0,0 +1,366 @@
+#pragma once
+
+#include "PlatformMemory.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace cma {
+
+/**
+ * A fixed-block pool whose pages live in a memory-mapped file, so a restarted
+ * process can re-attach to the blocks (and the data in them) instead of
+ * rebuilding them.
+ *
+ * The file is one 64 KB header page followed by up to max_pages 64 KB pages.
+ * Every page keeps its own allocation state in a small header: a free list
+ * linked by slot index, its length, and how many slots have ever been carved.
+ * Nothing stored in the file is a pointer, so the file may be mapped at any
+ * address. Reopening therefore only reads one header per page:
+ *
+ * - Clean restart: the file header carries a clean-shutdown marker, set by the
+ *   destructor after a flush. Recovery trusts each page's counters.
+ * - Validating restart: if the marker is missing (crash, kill), each page's
+ *   free list is walked with bounds and cycle checks, a broken list is cut at
+ *   the first bad link, and the counters are recomputed. Blocks lost from a cut
+ *   list are leaked rather than handed out twice.
+ *
+ * Stores reach the file through the page cache, so a process crash loses
+ * nothing; call flush() for durability against power loss.
+ */
+template <size_t BlockSize>
+class PersistentBlockPool {
+public:
+    static_assert(BlockSize >= sizeof(uint32_t), "BlockSize must fit a free-list link");
+    static_assert(BlockSize % alignof(uint32_t) == 0, "BlockSize must keep free-list links aligned");
+
+    static constexpr size_t PAGE_SIZE = 64 * 1024;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr uint64_t MAGIC = 0x434d4150455253ULL;  // "CMAPERS"
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr uint64_t INVALID_OFFSET = ~uint64_t{0};
+    static constexpr size_t ROOT_SLOTS = 8;
+
+    enum class RecoveryMode {
+        Created,       // new file
+        CleanRestart,  // clean-shutdown marker found; counters trusted
+        Validated,     // marker missing; every free list was checked
+    };
+
+    struct RecoveryInfo {
+        RecoveryMode mode = RecoveryMode::Created;
+        size_t pages_scanned = 0;
+        size_t free_blocks = 0;
+        size_t live_blocks = 0;
+        size_t repaired_pages = 0;  // pages whose free list or counters had to be fixed
+    };
+
+    static constexpr size_t blocks_per_page() {
+        return (PAGE_SIZE - block_region_offset()) / BlockSize;
+    }
+
+    PersistentBlockPool(const PersistentBlockPool&) = delete;
+    PersistentBlockPool& operator=(const PersistentBlockPool&) = delete;
+
+    /**
+     * Creates (or truncates) @p path with room for @p max_pages pages. The file
+     * is sized up front but sparse; pages are initialized as the pool grows.
+     * @return nullptr if the file cannot be created or mapped.
+     */
+    static std::unique_ptr<PersistentBlockPool> create(const std::string& path, size_t max_pages) {
+        if (max_pages == 0 || max_pages >= EMPTY_SLOT) {
+            return nullptr;
+        }
+        const SharedRegion region = create_file_region(path.c_str(), (max_pages + 1) * PAGE_SIZE);
+        if (region.base == nullptr) {
+            return nullptr;
+        }
+        FileHeader* header = new (region.base) FileHeader();
+        header->magic = MAGIC;
+        header->version = FORMAT_VERSION;
+        header->block_size = BlockSize;
+        header->page_size = PAGE_SIZE;
+        header->max_pages = max_pages;
+        header->page_count = 0;
+        return std::unique_ptr<PersistentBlockPool>(new PersistentBlockPool(region, RecoveryMode::Created));
+    }
+
+    /**
+     * Re-attaches to a file written by a previous PersistentBlockPool and
+     * recovers its free lists in O(pages).
+     * @return nullptr if the file is missing or was built with another layout.
+     */
+    static std::unique_ptr<PersistentBlockPool> open(const std::string& path) {
+        const SharedRegion region = open_file_region(path.c_str());
+        if (region.base == nullptr) {
+            return nullptr;
+        }
+        const FileHeader* header = static_cast<const FileHeader*>(region.base);
+        if (region.size < PAGE_SIZE || header->magic != MAGIC || header->version != FORMAT_VERSION ||
+            header->block_size != BlockSize || header->page_size != PAGE_SIZE ||
+            region.size < (header->max_pages + 1) * PAGE_SIZE) {
+            close_shared_region(region);
+            return nullptr;
+        }
+        const RecoveryMode mode = header->clean_shutdown != 0 ? RecoveryMode::CleanRestart : RecoveryMode::Validated;
+        return std::unique_ptr<PersistentBlockPool>(new PersistentBlockPool(region, mode));
+    }
+
+    /**
+     * Flushes the file and sets the clean-shutdown marker.
+     */
+    ~PersistentBlockPool() {
+        flush_region(m_region.base, m_region.size);
+        m_header->clean_shutdown = 1;
+        flush_region(m_region.base, PAGE_SIZE);
+        close_shared_region(m_region);
+    }
+
+    /**
+     * @return A block, or nullptr once all max_pages pages are full.
+     */
+    void* allocate() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (!m_available_pages.empty()) {
+            const uint32_t page_index = m_available_pages.back();
+            PageHeader* page = page_at(page_index);
+            if (page->free_head != EMPTY_SLOT) {
+                const uint32_t slot = page->free_head;
+                page->free_head = link_of(page_index, slot);
+                --page->free_count;
+                ++m_live_blocks;
+                return block_at(page_index, slot);
+            }
+            if (page->carved < blocks_per_page()) {
+                ++m_live_blocks;
+                return block_at(page_index, page->carved++);
+            }
+            m_available_pages.pop_back();
+            m_page_available[page_index] = false;
+        }
+
+        if (m_header->page_count >= m_header->max_pages) {
+            return nullptr;
+        }
+        const uint32_t page_index = static_cast<uint32_t>(m_header->page_count);
+        PageHeader* page = new (page_at(page_index)) PageHeader();
+        page->carved = 1;
+        ++m_header->page_count;
+        m_page_available.push_back(true);
+        m_available_pages.push_back(page_index);
+        ++m_live_blocks;
+        return block_at(page_index, 0);
+    }
+
+    /**
+     * Returns a block to its page's persistent free list. Null or foreign
+     * pointers are ignored.
+     */
+    void deallocate(void* ptr) {
+        const uint64_t offset = to_offset(ptr);
+        if (offset == INVALID_OFFSET) {
+            return;
+        }
+        const uint32_t page_index = static_cast<uint32_t>(offset / PAGE_SIZE);
+        const uint32_t slot = static_cast<uint32_t>((offset % PAGE_SIZE - block_region_offset()) / BlockSize);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PageHeader* page = page_at(page_index);
+        // Link first, then publish: a crash in between leaves the old list intact.
+        link_of(page_index, slot) = page->free_head;
+        page->free_head = slot;
+        ++page->free_count;
+        --m_live_blocks;
+        if (!m_page_available[page_index]) {
+            m_page_available[page_index] = true;
+            m_available_pages.push_back(page_index);
+        }
+    }
+
+    /**
+     * File-relative name for @p ptr that stays valid across restarts.
+     */
+    uint64_t to_offset(const void* ptr) const {
+        const char* p = static_cast<const char*>(ptr);
+        const char* pages = m_pages;
+        if (ptr == nullptr || p < pages || p >= pages + m_header->page_count * PAGE_SIZE) {
+            return INVALID_OFFSET;
+        }
+        const uint64_t offset = static_cast<uint64_t>(p - pages);
+        const size_t in_page = offset % PAGE_SIZE;
+        if (in_page < block_region_offset() || (in_page - block_region_offset()) % BlockSize != 0 ||
+            (in_page - block_region_offset()) / BlockSize >= blocks_per_page()) {
+            return INVALID_OFFSET;
+        }
+        return offset;
+    }
+
+    void* from_offset(uint64_t offset) const {
+        if (offset == INVALID_OFFSET || offset >= m_header->page_count * PAGE_SIZE) {
+            return nullptr;
+        }
+        return m_pages + offset;
+    }
+
+    /**
+     * Persistent slots for offsets the application needs to find its data
+     * again after a restart (e.g. the head of an index). Not synchronized.
+     */
+    uint64_t& root(size_t slot) {
+        return m_header->roots[slot % ROOT_SLOTS];
+    }
+
+    /**
+     * Writes dirty pages to storage without ending the session.
+     */
+    bool flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return flush_region(m_region.base, m_region.size);
+    }
+
+    const RecoveryInfo& recovery() const {
+        return m_recovery;
+    }
+
+    size_t page_count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<size_t>(m_header->page_count);
+    }
+
+    size_t max_pages() const {
+        return static_cast<size_t>(m_header->max_pages);
+    }
+
+    size_t live_blocks() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_live_blocks;
+    }
+
+private:
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFU;
+
+    struct FileHeader {
+        uint64_t magic = 0;
+        uint32_t version = 0;
+        uint32_t clean_shutdown = 0;
+        uint64_t block_size = 0;
+        uint64_t page_size = 0;
+        uint64_t max_pages = 0;
+        uint64_t page_count = 0;  // pages initialized so far
+        uint64_t roots[ROOT_SLOTS] = {};
+    };
+
+    struct PageHeader {
+        uint32_t free_head = EMPTY_SLOT;  // slot index, linked through the first word of each free block
+        uint32_t free_count = 0;
+        uint32_t carved = 0;  // slots [0, carved) have been handed out at least once
+    };
+
+    static_assert(sizeof(FileHeader) <= PAGE_SIZE, "file header must fit its page");
+
+    static constexpr size_t block_region_offset() {
+        return (sizeof(PageHeader) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    }
+
+    PersistentBlockPool(SharedRegion region, RecoveryMode mode)
+        : m_region(region),
+          m_header(static_cast<FileHeader*>(region.base)),
+          m_pages(static_cast<char*>(region.base) + PAGE_SIZE) {
+        m_recovery.mode = mode;
+        if (mode != RecoveryMode::Created) {
+            recover(mode == RecoveryMode::Validated);
+        }
+        // Anything after this point is unclean until the destructor runs.
+        m_header->clean_shutdown = 0;
+        flush_region(m_region.base, PAGE_SIZE);
+    }
+
+    // Rebuilds the in-memory page index from the page headers.
+    void recover(bool validate) {
+        if (m_header->page_count > m_header->max_pages) {
+            m_header->page_count = m_header->max_pages;
+        }
+        const size_t pages = static_cast<size_t>(m_header->page_count);
+        m_page_available.assign(pages, false);
+        std::vector<bool> visited;
+
+        for (size_t index = 0; index < pages; ++index) {
+            const uint32_t page_index = static_cast<uint32_t>(index);
+            PageHeader* page = page_at(page_index);
+            if (validate && validate_page(page_index, visited)) {
+                ++m_recovery.repaired_pages;
+            }
+            const size_t live = page->carved - page->free_count;
+            m_live_blocks += live;
+            m_recovery.free_blocks += blocks_per_page() - live;
+            if (live < blocks_per_page()) {
+                m_page_available[page_index] = true;
+                m_available_pages.push_back(page_index);
+            }
+        }
+        m_recovery.pages_scanned = pages;
+        m_recovery.live_blocks = m_live_blocks;
+    }
+
+    // Walks one free list, cutting it at the first out-of-range or repeated
+    // slot and recounting it. @return true if anything had to be fixed.
+    bool validate_page(uint32_t page_index, std::vector<bool>& visited) {
+        PageHeader* page = page_at(page_index);
+        bool repaired = false;
+        if (page->carved > blocks_per_page()) {
+            page->carved = static_cast<uint32_t>(blocks_per_page());
+            repaired = true;
+        }
+        visited.assign(page->carved, false);
+
+        uint32_t count = 0;
+        uint32_t* link = &page->free_head;
+        while (*link != EMPTY_SLOT) {
+            const uint32_t slot = *link;
+            if (slot >= page->carved || visited[slot]) {
+                *link = EMPTY_SLOT;
+                repaired = true;
+                break;
+            }
+            visited[slot] = true;
+            ++count;
+            link = &link_of(page_index, slot);
+        }
+        if (page->free_count != count) {
+            page->free_count = count;
+            repaired = true;
+        }
+        return repaired;
+    }
+
+    PageHeader* page_at(uint32_t page_index) const {
+        return reinterpret_cast<PageHeader*>(m_pages + static_cast<size_t>(page_index) * PAGE_SIZE);
+    }
+
+    void* block_at(uint32_t page_index, uint32_t slot) const {
+        return m_pages + static_cast<size_t>(page_index) * PAGE_SIZE + block_region_offset() +
+               static_cast<size_t>(slot) * BlockSize;
+    }
+
+    uint32_t& link_of(uint32_t page_index, uint32_t slot) const {
+        return *static_cast<uint32_t*>(block_at(page_index, slot));
+    }
+
+    SharedRegion m_region;
+    FileHeader* m_header;
+    char* m_pages;
+
+    mutable std::mutex m_mutex;
+    // Pages with a free or never-carved slot; m_page_available mirrors membership.
+    std::vector<uint32_t> m_available_pages;
+    std::vector<bool> m_page_available;
+    size_t m_live_blocks = 0;
+    RecoveryInfo m_recovery;
+};
+
+} // namespace cma
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <string>
 
 namespace cma {
 
@@ -15,4 +16,162 @@ void* map_page(size_t size);
  */
 void unmap_page(void* ptr, size_t size);
 
+/**
+ * One mapping returned by map_page(), queued for unmap_pages().
+ */
+struct MappedRange {
+    void* base = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * Unmaps several map_page() mappings. On POSIX the ranges are sorted and
+ * address-adjacent ones merged, so each contiguous run costs one munmap (and
+ * one round of TLB shootdowns). Reorders @p ranges.
+ * @return The number of unmap calls issued.
+ */
+size_t unmap_pages(MappedRange* ranges, size_t count);
+
+/**
+ * Reserves address space without backing it with memory. Pages must be
+ * committed with commit_region() before they are touched.
+ * @return The starting address, or nullptr on failure.
+ */
+void* reserve_region(size_t size);
+
+/**
+ * Makes part of a reserved region readable and writable.
+ * @return false if the OS refused to commit the range.
+ */
+bool commit_region(void* ptr, size_t size);
+
+/**
+ * Returns the physical memory behind a committed range to the OS while
+ * keeping the address range reserved. No-op when @p ptr is nullptr.
+ */
+void decommit_region(void* ptr, size_t size);
+
+/**
+ * Releases a whole region obtained from reserve_region(). No-op when @p ptr is nullptr.
+ */
+void release_region(void* ptr, size_t size);
+
+/**
+ * Commits physical memory for [ptr, ptr + size) now instead of on first touch
+ * (MADV_POPULATE_WRITE where available). Falls back to writing back one byte
+ * per OS page, so the range must not be in concurrent use by other threads.
+ * @return false if the range could not be populated.
+ */
+bool prefault_region(void* ptr, size_t size);
+
+/**
+ * Locks [ptr, ptr + size) in RAM (mlock / VirtualLock). Usually limited by
+ * RLIMIT_MEMLOCK; the lock ends when the memory is unmapped or decommitted.
+ * @return false if the OS refused.
+ */
+bool lock_region(void* ptr, size_t size);
+
+/**
+ * A named shared-memory object mapped read/write into this process. Each
+ * process that opens the same name may see it at a different address.
+ */
+struct SharedRegion {
+    void* base = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * Creates a new zero-filled shared-memory object (shm_open / CreateFileMapping)
+ * and maps it. Fails if @p name already exists.
+ * @return A region with base == nullptr on failure.
+ */
+SharedRegion create_shared_region(const char* name, size_t size);
+
+/**
+ * Maps an existing shared-memory object created by create_shared_region().
+ * @return A region with base == nullptr on failure.
+ */
+SharedRegion open_shared_region(const char* name);
+
+/**
+ * Unmaps a shared region from this process. The object itself persists until
+ * remove_shared_region() (and every mapping is closed).
+ */
+void close_shared_region(SharedRegion region);
+
+/**
+ * Creates (or truncates) the file at @p path, sizes it to @p size bytes
+ * (sparse where the filesystem allows) and maps it shared, so stores reach
+ * the file and survive the process.
+ * @return A region with base == nullptr on failure.
+ */
+SharedRegion create_file_region(const char* path, size_t size);
+
+/**
+ * Maps an existing file in full, shared and read/write.
+ * @return A region with base == nullptr on failure.
+ */
+SharedRegion open_file_region(const char* path);
+
+/**
+ * Writes dirty pages of a file-backed region to storage (msync / FlushViewOfFile)
+ * and waits for completion. Unmap with close_shared_region().
+ */
+bool flush_region(void* ptr, size_t size);
+
+/**
+ * Removes the name of a shared-memory object. No-op on Windows, where the
+ * object disappears with its last handle.
+ */
+void remove_shared_region(const char* name);
+
+/**
+ * Fills @p frames with up to @p max_frames return addresses of the calling
+ * thread, innermost first, leaving out the caller's own innermost @p skip
+ * frames (backtrace / CaptureStackBackTrace).
+ * @return The number of frames stored; 0 where unsupported.
+ */
+size_t capture_stack(void** frames, size_t max_frames, size_t skip);
+
+/**
+ * A printable name for a code address: the demangled symbol when one is
+ * exported, else "module+0xoffset", else the raw address in hex.
+ */
+std::string describe_frame(void* address);
+
+/**
+ * The process's memory map (/proc/self/maps text), for tools that symbolize
+ * raw addresses offline. Empty where unavailable.
+ */
+std::string read_memory_map();
+
+/**
+ * Resident set size of the calling process in bytes (VmRSS / resident_size /
+ * WorkingSetSize). 0 where unsupported.
+ */
+size_t resident_bytes();
+
+/**
+ * High-water mark of resident_bytes() (VmHWM / resident_size_max /
+ * PeakWorkingSetSize). 0 where unsupported.
+ */
+size_t peak_resident_bytes();
+
+/**
+ * Restarts the peak_resident_bytes() high-water mark from the current RSS
+ * (Linux /proc/self/clear_refs). Returns false where the peak cannot be reset.
+ */
+bool reset_peak_resident();
+
+struct ProcessMemory {
+    size_t resident_bytes = 0;
+    size_t virtual_bytes = 0;  // address space (VmSize); committed private bytes on Windows
+};
+
+/**
+ * Current resident and virtual size in one cheap read (/proc/self/statm on
+ * Linux), suitable for sampling every millisecond. Zeros where unsupported.
+ */
+ProcessMemory process_memory();
+
 } // namespace cma
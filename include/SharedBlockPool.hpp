@@ -0,0 +1,225 @@
+#pragma once
+
+#include "PlatformMemory.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace cma {
+
+/**
+ * A fixed-block pool living in a named shared-memory object so several
+ * processes can allocate and free the same blocks.
+ *
+ * Processes map the region at different addresses, so nothing inside it holds
+ * a raw pointer: free-list links are block indices and blocks are exchanged as
+ * offsets (to_offset() / from_offset()). The free list is a lock-free stack
+ * whose head packs a block index with an ABA tag into one 64-bit atomic, and
+ * never-used blocks are carved from a shared bump index. Both are lock-free
+ * std::atomic words, which are address-free and therefore safe across
+ * processes. A process that dies mid-operation can leak a block but never
+ * leaves the pool locked.
+ *
+ * Capacity is fixed when the pool is created; the region does not grow.
+ */
+template <size_t BlockSize>
+class SharedBlockPool {
+public:
+    static_assert(BlockSize >= sizeof(uint32_t), "BlockSize must fit a free-list link");
+    static_assert(BlockSize % alignof(uint32_t) == 0, "BlockSize must keep free-list links aligned");
+
+    static constexpr uint64_t MAGIC = 0x434d41534850304cULL;  // "CMASHP0L"
+    static constexpr uint64_t INVALID_OFFSET = ~uint64_t{0};
+    static constexpr size_t ROOT_SLOTS = 8;
+
+    SharedBlockPool(const SharedBlockPool&) = delete;
+    SharedBlockPool& operator=(const SharedBlockPool&) = delete;
+
+    /**
+     * Creates the shared object @p name sized for @p capacity_blocks blocks.
+     * @return nullptr if the name already exists or the mapping fails.
+     */
+    static std::unique_ptr<SharedBlockPool> create(const std::string& name, size_t capacity_blocks) {
+        if (capacity_blocks == 0 || capacity_blocks >= INDEX_MASK) {
+            return nullptr;
+        }
+        const size_t size = blocks_offset() + capacity_blocks * BlockSize;
+        const SharedRegion region = create_shared_region(name.c_str(), size);
+        if (region.base == nullptr) {
+            return nullptr;
+        }
+        Header* header = new (region.base) Header();
+        header->block_size = BlockSize;
+        header->capacity_blocks = capacity_blocks;
+        header->magic.store(MAGIC, std::memory_order_release);
+        return std::unique_ptr<SharedBlockPool>(new SharedBlockPool(region));
+    }
+
+    /**
+     * Attaches to a pool created (possibly by another process) with create().
+     * @return nullptr if the object is missing or was built for another BlockSize.
+     */
+    static std::unique_ptr<SharedBlockPool> open(const std::string& name) {
+        const SharedRegion region = open_shared_region(name.c_str());
+        if (region.base == nullptr) {
+            return nullptr;
+        }
+        const Header* header = static_cast<const Header*>(region.base);
+        if (region.size < blocks_offset() || header->magic.load(std::memory_order_acquire) != MAGIC ||
+            header->block_size != BlockSize ||
+            region.size < blocks_offset() + header->capacity_blocks * BlockSize) {
+            close_shared_region(region);
+            return nullptr;
+        }
+        return std::unique_ptr<SharedBlockPool>(new SharedBlockPool(region));
+    }
+
+    /**
+     * Removes the name; mappings already open in any process stay valid.
+     */
+    static void remove(const std::string& name) {
+        remove_shared_region(name.c_str());
+    }
+
+    ~SharedBlockPool() {
+        close_shared_region(m_region);
+    }
+
+    /**
+     * @return A block, or nullptr when every block in the region is in use.
+     */
+    void* allocate() {
+        uint64_t head = m_header->free_head.load(std::memory_order_acquire);
+        while ((head & INDEX_MASK) != EMPTY_INDEX) {
+            const uint32_t index = static_cast<uint32_t>(head & INDEX_MASK);
+            // May read a block another process just took; the tag makes the CAS fail then.
+            const uint32_t next = link_of(index).load(std::memory_order_relaxed);
+            const uint64_t replacement = next_tag(head) | next;
+            if (m_header->free_head.compare_exchange_weak(head, replacement, std::memory_order_acquire,
+                                                          std::memory_order_acquire)) {
+                m_header->live_blocks.fetch_add(1, std::memory_order_relaxed);
+                return block_at(index);
+            }
+        }
+
+        uint64_t index = m_header->bump_index.load(std::memory_order_relaxed);
+        do {
+            if (index >= m_header->capacity_blocks) {
+                return nullptr;
+            }
+        } while (!m_header->bump_index.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+        m_header->live_blocks.fetch_add(1, std::memory_order_relaxed);
+        return block_at(static_cast<uint32_t>(index));
+    }
+
+    /**
+     * Returns a block obtained from allocate() in this or any other process.
+     * Null or foreign pointers are ignored.
+     */
+    void deallocate(void* ptr) {
+        if (!owns(ptr)) {
+            return;
+        }
+        const uint32_t index = static_cast<uint32_t>(to_offset(ptr) / BlockSize);
+        uint64_t head = m_header->free_head.load(std::memory_order_relaxed);
+        do {
+            link_of(index).store(static_cast<uint32_t>(head & INDEX_MASK), std::memory_order_relaxed);
+        } while (!m_header->free_head.compare_exchange_weak(head, next_tag(head) | index, std::memory_order_release,
+                                                            std::memory_order_relaxed));
+        m_header->live_blocks.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Position-independent name for @p ptr, valid in every process attached to the pool.
+     */
+    uint64_t to_offset(const void* ptr) const {
+        if (!owns(ptr)) {
+            return INVALID_OFFSET;
+        }
+        return static_cast<uint64_t>(static_cast<const char*>(ptr) - m_blocks);
+    }
+
+    void* from_offset(uint64_t offset) const {
+        if (offset == INVALID_OFFSET || offset >= m_header->capacity_blocks * BlockSize) {
+            return nullptr;
+        }
+        return m_blocks + offset;
+    }
+
+    bool owns(const void* ptr) const {
+        const char* p = static_cast<const char*>(ptr);
+        return ptr != nullptr && p >= m_blocks && p < m_blocks + m_header->capacity_blocks * BlockSize &&
+               static_cast<size_t>(p - m_blocks) % BlockSize == 0;
+    }
+
+    /**
+     * Shared slots for publishing well-known offsets (e.g. a queue head) so a
+     * process that only knows the pool name can find them.
+     */
+    std::atomic<uint64_t>& root(size_t slot) {
+        return m_header->roots[slot % ROOT_SLOTS];
+    }
+
+    size_t capacity_blocks() const {
+        return static_cast<size_t>(m_header->capacity_blocks);
+    }
+
+    size_t live_blocks() const {
+        return static_cast<size_t>(m_header->live_blocks.load(std::memory_order_relaxed));
+    }
+
+    size_t mapped_bytes() const {
+        return m_region.size;
+    }
+
+private:
+    // Low 32 bits of free_head: block index (EMPTY_INDEX = empty list); high 32: ABA tag.
+    static constexpr uint64_t INDEX_MASK = 0xFFFFFFFFULL;
+    static constexpr uint32_t EMPTY_INDEX = 0xFFFFFFFFU;
+    static constexpr size_t HEADER_ALIGNMENT = 64;
+
+    struct Header {
+        std::atomic<uint64_t> magic{0};
+        uint64_t block_size = 0;
+        uint64_t capacity_blocks = 0;
+        alignas(HEADER_ALIGNMENT) std::atomic<uint64_t> free_head{EMPTY_INDEX};
+        alignas(HEADER_ALIGNMENT) std::atomic<uint64_t> bump_index{0};
+        std::atomic<uint64_t> live_blocks{0};
+        alignas(HEADER_ALIGNMENT) std::atomic<uint64_t> roots[ROOT_SLOTS] = {};
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared pool needs lock-free 64-bit atomics");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared pool needs lock-free 32-bit atomics");
+
+    explicit SharedBlockPool(SharedRegion region)
+        : m_region(region),
+          m_header(static_cast<Header*>(region.base)),
+          m_blocks(static_cast<char*>(region.base) + blocks_offset()) {}
+
+    static constexpr size_t blocks_offset() {
+        return (sizeof(Header) + HEADER_ALIGNMENT - 1) & ~(HEADER_ALIGNMENT - 1);
+    }
+
+    static uint64_t next_tag(uint64_t head) {
+        return ((head >> 32) + 1) << 32;
+    }
+
+    void* block_at(uint32_t index) const {
+        return m_blocks + static_cast<size_t>(index) * BlockSize;
+    }
+
+    // The link lives in the first word of a free block.
+    std::atomic<uint32_t>& link_of(uint32_t index) const {
+        return *reinterpret_cast<std::atomic<uint32_t>*>(block_at(index));
+    }
+
+    SharedRegion m_region;
+    Header* m_header;
+    char* m_blocks;
+};
+
+} // namespace cma
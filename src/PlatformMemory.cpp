@@ -1,9 +1,30 @@
 #include "PlatformMemory.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
 #if defined(_WIN32)
 #include <windows.h>
+#include <psapi.h>
 #else
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define CMA_HAS_EXECINFO 1
+#endif
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
 #endif
 
 namespace cma {
@@ -29,4 +50,446 @@ void unmap_page(void* ptr, size_t size) {
 #endif
 }
 
+size_t unmap_pages(MappedRange* ranges, size_t count) {
+#if defined(_WIN32)
+    // VirtualFree releases one allocation per call; there is nothing to merge.
+    for (size_t i = 0; i < count; ++i) {
+        unmap_page(ranges[i].base, ranges[i].size);
+    }
+    return count;
+#else
+    std::sort(ranges, ranges + count,
+              [](const MappedRange& a, const MappedRange& b) { return a.base < b.base; });
+    const uintptr_t os_page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    auto rounded_end = [os_page](const MappedRange& range) {
+        return (reinterpret_cast<uintptr_t>(range.base) + range.size + os_page - 1) & ~(os_page - 1);
+    };
+
+    size_t calls = 0;
+    size_t i = 0;
+    while (i < count) {
+        const uintptr_t start = reinterpret_cast<uintptr_t>(ranges[i].base);
+        uintptr_t end = rounded_end(ranges[i]);
+        for (++i; i < count && reinterpret_cast<uintptr_t>(ranges[i].base) == end; ++i) {
+            end = rounded_end(ranges[i]);
+        }
+        munmap(reinterpret_cast<void*>(start), end - start);
+        ++calls;
+    }
+    return calls;
+#endif
+}
+
+void* reserve_region(size_t size) {
+#if defined(_WIN32)
+    return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+    flags |= MAP_NORESERVE;
+#endif
+    void* ptr = mmap(nullptr, size, PROT_NONE, flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+#endif
+}
+
+bool commit_region(void* ptr, size_t size) {
+#if defined(_WIN32)
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void decommit_region(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return;
+    }
+#if defined(_WIN32)
+    VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+    // Replacing the range with a fresh PROT_NONE mapping drops its pages on
+    // every POSIX system (MADV_DONTNEED does not free memory on macOS).
+    mmap(ptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+#endif
+}
+
+void release_region(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return;
+    }
+#if defined(_WIN32)
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+bool prefault_region(void* ptr, size_t size) {
+    if (ptr == nullptr || size == 0) {
+        return false;
+    }
+#if defined(MADV_POPULATE_WRITE)
+    const uintptr_t os_page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t first = reinterpret_cast<uintptr_t>(ptr) & ~(os_page - 1);
+    const uintptr_t last = reinterpret_cast<uintptr_t>(ptr) + size;
+    if (madvise(reinterpret_cast<void*>(first), last - first, MADV_POPULATE_WRITE) == 0) {
+        return true;
+    }
+    // Kernels before 5.14 reject the advice; fault the pages in by hand.
+#endif
+    constexpr uintptr_t touch_stride = 4096;
+    volatile char* const begin = static_cast<volatile char*>(ptr);
+    volatile char* const end = begin + size;
+    for (volatile char* p = begin; p < end;) {
+        *p = *p;
+        p += touch_stride - (reinterpret_cast<uintptr_t>(p) & (touch_stride - 1));
+    }
+    return true;
+}
+
+bool lock_region(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return false;
+    }
+#if defined(_WIN32)
+    return VirtualLock(ptr, size) != 0;
+#else
+    return mlock(ptr, size) == 0;
+#endif
+}
+
+SharedRegion create_shared_region(const char* name, size_t size) {
+#if defined(_WIN32)
+    const DWORD high = static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32);
+    const DWORD low = static_cast<DWORD>(size & 0xFFFFFFFFULL);
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, high, low, name);
+    if (mapping == nullptr || GetLastError() == ERROR_ALREADY_EXISTS) {
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        return SharedRegion{};
+    }
+    // A mapped view keeps the object alive, so the handle can go right away.
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(mapping);
+    return base == nullptr ? SharedRegion{} : SharedRegion{base, size};
+#else
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return SharedRegion{};
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return SharedRegion{};
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name);
+        return SharedRegion{};
+    }
+    return SharedRegion{base, size};
+#endif
+}
+
+SharedRegion open_shared_region(const char* name) {
+#if defined(_WIN32)
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    if (mapping == nullptr) {
+        return SharedRegion{};
+    }
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    CloseHandle(mapping);
+    if (base == nullptr) {
+        return SharedRegion{};
+    }
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(base, &info, sizeof(info));
+    return SharedRegion{base, info.RegionSize};
+#else
+    const int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0) {
+        return SharedRegion{};
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return SharedRegion{};
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return base == MAP_FAILED ? SharedRegion{} : SharedRegion{base, size};
+#endif
+}
+
+void close_shared_region(SharedRegion region) {
+    if (region.base == nullptr) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(region.base);
+#else
+    munmap(region.base, region.size);
+#endif
+}
+
+#if defined(_WIN32)
+namespace {
+
+SharedRegion map_file_handle(HANDLE file, size_t size) {
+    const DWORD high = static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32);
+    const DWORD low = static_cast<DWORD>(size & 0xFFFFFFFFULL);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, high, low, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return SharedRegion{};
+    }
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(mapping);
+    return base == nullptr ? SharedRegion{} : SharedRegion{base, size};
+}
+
+} // namespace
+#endif
+
+SharedRegion create_file_region(const char* path, size_t size) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return SharedRegion{};
+    }
+    return map_file_handle(file, size);
+#else
+    const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return SharedRegion{};
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        return SharedRegion{};
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return base == MAP_FAILED ? SharedRegion{} : SharedRegion{base, size};
+#endif
+}
+
+SharedRegion open_file_region(const char* path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return SharedRegion{};
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        return SharedRegion{};
+    }
+    return map_file_handle(file, static_cast<size_t>(size.QuadPart));
+#else
+    const int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return SharedRegion{};
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return SharedRegion{};
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return base == MAP_FAILED ? SharedRegion{} : SharedRegion{base, size};
+#endif
+}
+
+bool flush_region(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return false;
+    }
+#if defined(_WIN32)
+    return FlushViewOfFile(ptr, size) != 0;
+#else
+    return msync(ptr, size, MS_SYNC) == 0;
+#endif
+}
+
+void remove_shared_region(const char* name) {
+#if defined(_WIN32)
+    (void)name;
+#else
+    shm_unlink(name);
+#endif
+}
+
+size_t capture_stack(void** frames, size_t max_frames, size_t skip) {
+#if defined(_WIN32)
+    return CaptureStackBackTrace(static_cast<DWORD>(skip + 1), static_cast<DWORD>(max_frames), frames, nullptr);
+#elif defined(CMA_HAS_EXECINFO)
+    // backtrace() wants room for the skipped frames and this one as well.
+    void* buffer[128];
+    const size_t wanted = std::min(max_frames + skip + 1, sizeof(buffer) / sizeof(buffer[0]));
+    const int depth = backtrace(buffer, static_cast<int>(wanted));
+    if (depth <= static_cast<int>(skip + 1)) {
+        return 0;
+    }
+    const size_t count = static_cast<size_t>(depth) - (skip + 1);
+    std::copy(buffer + skip + 1, buffer + skip + 1 + count, frames);
+    return count;
+#else
+    (void)frames;
+    (void)max_frames;
+    (void)skip;
+    return 0;
+#endif
+}
+
+std::string describe_frame(void* address) {
+    char hex[2 + 2 * sizeof(void*) + 1];
+    std::snprintf(hex, sizeof(hex), "0x%llx",
+                  static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address)));
+#if !defined(_WIN32)
+    Dl_info info;
+    if (dladdr(address, &info) != 0) {
+        if (info.dli_sname != nullptr) {
+            int status = -1;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+        if (info.dli_fname != nullptr) {
+            const std::string module = info.dli_fname;
+            std::ostringstream out;
+            out << module.substr(module.find_last_of('/') + 1) << "+0x" << std::hex
+                << reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+            return out.str();
+        }
+    }
+#endif
+    return hex;
+}
+
+std::string read_memory_map() {
+#if defined(_WIN32)
+    return std::string();
+#else
+    std::ifstream maps("/proc/self/maps");
+    if (!maps) {
+        return std::string();
+    }
+    std::ostringstream out;
+    out << maps.rdbuf();
+    return out.str();
+#endif
+}
+
+#if defined(__linux__)
+namespace {
+
+// A "Key:   123 kB" line of /proc/self/status, in bytes (0 if absent).
+size_t proc_status_bytes(const char* key) {
+    std::ifstream status("/proc/self/status");
+    const size_t key_length = std::strlen(key);
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, key_length, key) == 0 && line.size() > key_length && line[key_length] == ':') {
+            return static_cast<size_t>(std::strtoull(line.c_str() + key_length + 1, nullptr, 10)) * 1024;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+#endif
+
+size_t resident_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+#elif defined(__linux__)
+    return proc_status_bytes("VmRSS");
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    return task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+                   KERN_SUCCESS
+               ? static_cast<size_t>(info.resident_size)
+               : 0;
+#else
+    return 0;
+#endif
+}
+
+size_t peak_resident_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize
+                                                                                  : 0;
+#elif defined(__linux__)
+    return proc_status_bytes("VmHWM");
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    return task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+                   KERN_SUCCESS
+               ? static_cast<size_t>(info.resident_size_max)
+               : 0;
+#else
+    return 0;
+#endif
+}
+
+ProcessMemory process_memory() {
+    ProcessMemory memory;
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS_EX counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+                             sizeof(counters))) {
+        memory.resident_bytes = counters.WorkingSetSize;
+        memory.virtual_bytes = counters.PrivateUsage;
+    }
+#elif defined(__linux__)
+    // "size resident shared text lib data dt", in pages.
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm != nullptr) {
+        unsigned long long size_pages = 0;
+        unsigned long long resident_pages = 0;
+        if (std::fscanf(statm, "%llu %llu", &size_pages, &resident_pages) == 2) {
+            const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            memory.resident_bytes = static_cast<size_t>(resident_pages) * page;
+            memory.virtual_bytes = static_cast<size_t>(size_pages) * page;
+        }
+        std::fclose(statm);
+    }
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+        KERN_SUCCESS) {
+        memory.resident_bytes = static_cast<size_t>(info.resident_size);
+        memory.virtual_bytes = static_cast<size_t>(info.virtual_size);
+    }
+#endif
+    return memory;
+}
+
+bool reset_peak_resident() {
+#if defined(__linux__)
+    // "5" resets VmHWM to the current RSS (Linux 4.0+).
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return static_cast<bool>(clear_refs);
+#else
+    return false;
+#endif
+}
+
 } // namespace cma
@@ -0,0 +1,212 @@
+#include "alloc_trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+
+namespace alloc_trace {
+namespace {
+
+bool decode_varint(const std::vector<unsigned char>& data, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (unsigned int shift = 0; shift < 64 && offset < data.size(); shift += 7) {
+        const unsigned char byte = data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_binary(const std::vector<unsigned char>& data, std::vector<Event>& events, std::string& error) {
+    size_t offset = sizeof(kMagic);
+    uint64_t version = 0;
+    if (!decode_varint(data, offset, version) || version != kVersion) {
+        error = "unsupported binary trace version";
+        return false;
+    }
+    uint64_t previous_ns = 0;
+    while (offset < data.size()) {
+        Event event;
+        const unsigned char op = data[offset++];
+        if (op > static_cast<unsigned char>(Op::Free)) {
+            error = "bad op byte at offset " + std::to_string(offset - 1);
+            return false;
+        }
+        event.op = static_cast<Op>(op);
+        uint64_t delta = 0;
+        uint64_t thread = 0;
+        bool ok = decode_varint(data, offset, delta) && decode_varint(data, offset, thread) &&
+                  decode_varint(data, offset, event.object);
+        if (ok && event.op == Op::Alloc) {
+            ok = decode_varint(data, offset, event.size);
+        }
+        if (!ok) {
+            error = "truncated record at event " + std::to_string(events.size());
+            return false;
+        }
+        previous_ns += static_cast<uint64_t>(unzigzag(delta));
+        event.timestamp_ns = previous_ns;
+        event.thread = static_cast<uint32_t>(thread);
+        events.push_back(event);
+    }
+    return true;
+}
+
+bool parse_text(const std::string& text, std::vector<Event>& events, std::string& error) {
+    std::istringstream input(text);
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        Event event;
+        std::string op;
+        if (!(fields >> event.timestamp_ns >> event.thread >> op >> event.object)) {
+            error = "line " + std::to_string(line_number) + ": expected 'timestamp thread op object [size]'";
+            return false;
+        }
+        if (op == "a" || op == "alloc") {
+            event.op = Op::Alloc;
+            if (!(fields >> event.size)) {
+                error = "line " + std::to_string(line_number) + ": alloc without a size";
+                return false;
+            }
+        } else if (op == "f" || op == "free") {
+            event.op = Op::Free;
+        } else {
+            error = "line " + std::to_string(line_number) + ": unknown op '" + op + "'";
+            return false;
+        }
+        events.push_back(event);
+    }
+    return true;
+}
+
+} // namespace
+
+bool read_trace(const std::string& path, std::vector<Event>& events, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    const std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    events.clear();
+    const bool binary = data.size() >= sizeof(kMagic) && std::memcmp(data.data(), kMagic, sizeof(kMagic)) == 0;
+    const bool ok = binary ? parse_binary(data, events, error)
+                           : parse_text(std::string(data.begin(), data.end()), events, error);
+    if (!ok) {
+        return false;
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+    return true;
+}
+
+bool write_binary_trace(const std::string& path, const std::vector<Event>& events, std::string& error) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "cannot create " + path;
+        return false;
+    }
+    unsigned char record[kMaxRecordBytes];
+    file.write(kMagic, sizeof(kMagic));
+    file.write(reinterpret_cast<const char*>(record),
+               static_cast<std::streamsize>(encode_varint(kVersion, record)));
+    uint64_t previous_ns = 0;
+    for (const Event& event : events) {
+        const size_t length = encode_event(event, previous_ns, record);
+        file.write(reinterpret_cast<const char*>(record), static_cast<std::streamsize>(length));
+    }
+    if (!file) {
+        error = "write to " + path + " failed";
+        return false;
+    }
+    return true;
+}
+
+bool write_text_trace(const std::string& path, const std::vector<Event>& events, std::string& error) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        error = "cannot create " + path;
+        return false;
+    }
+    file << "# timestamp_ns thread op object [size]\n";
+    for (const Event& event : events) {
+        file << event.timestamp_ns << ' ' << event.thread << ' ' << (event.op == Op::Alloc ? "a" : "f") << ' '
+             << event.object;
+        if (event.op == Op::Alloc) {
+            file << ' ' << event.size;
+        }
+        file << '\n';
+    }
+    if (!file) {
+        error = "write to " + path + " failed";
+        return false;
+    }
+    return true;
+}
+
+ReplayPlan build_replay_plan(const std::vector<Event>& events) {
+    struct LiveObject {
+        uint32_t index;
+        size_t thread;
+    };
+
+    ReplayPlan plan;
+    std::unordered_map<uint32_t, size_t> thread_slots;
+    std::unordered_map<uint64_t, LiveObject> live;
+    uint64_t live_bytes = 0;
+
+    for (const Event& event : events) {
+        auto [slot, inserted] = thread_slots.try_emplace(event.thread, plan.threads.size());
+        if (inserted) {
+            plan.thread_ids.push_back(event.thread);
+            plan.threads.emplace_back();
+        }
+        const size_t thread = slot->second;
+
+        if (event.op == Op::Alloc) {
+            const uint32_t index = static_cast<uint32_t>(plan.sizes.size());
+            auto [entry, fresh] = live.try_emplace(event.object, LiveObject{index, thread});
+            if (!fresh) {
+                // Allocated twice without a free in between: the first copy leaks.
+                ++plan.leaked;
+                entry->second = LiveObject{index, thread};
+            }
+            plan.sizes.push_back(event.size);
+            plan.threads[thread].push_back(ReplayOp{index, false});
+            ++plan.allocations;
+            live_bytes += event.size;
+            plan.peak_live_bytes = std::max(plan.peak_live_bytes, live_bytes);
+            continue;
+        }
+
+        auto entry = live.find(event.object);
+        if (entry == live.end()) {
+            ++plan.dropped_frees;
+            continue;
+        }
+        plan.threads[thread].push_back(ReplayOp{entry->second.index, true});
+        ++plan.frees;
+        if (entry->second.thread != thread) {
+            ++plan.cross_thread_frees;
+        }
+        live_bytes -= plan.sizes[entry->second.index];
+        live.erase(entry);
+    }
+    plan.leaked += live.size();
+    return plan;
+}
+
+} // namespace alloc_trace
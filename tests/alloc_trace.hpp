@@ -0,0 +1,111 @@
+#pragma once
+
+// Allocation traces: timestamped alloc/free events with thread and object IDs,
+// read by `allocator_test replay`.
+//
+// Binary format: the 8-byte magic "CMATRACE", a varint version (1), then one
+// record per event:
+//   u8      op (0 = alloc, 1 = free)
+//   varint  zigzag(timestamp_ns - previous record's timestamp_ns)
+//   varint  thread
+//   varint  object
+//   varint  size            (alloc records only)
+// Records need not be in timestamp order (per-thread buffers may be written
+// out interleaved); readers sort them.
+//
+// Text format: one event per line, "timestamp_ns thread op object [size]",
+// where op is "a"/"alloc" or "f"/"free". Blank lines and lines starting with
+// '#' are ignored.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alloc_trace {
+
+constexpr char kMagic[8] = {'C', 'M', 'A', 'T', 'R', 'A', 'C', 'E'};
+constexpr uint64_t kVersion = 1;
+constexpr size_t kMaxRecordBytes = 1 + 4 * 10;  // op + four 64-bit varints
+
+enum class Op : uint8_t {
+    Alloc = 0,
+    Free = 1,
+};
+
+struct Event {
+    uint64_t timestamp_ns = 0;
+    uint32_t thread = 0;
+    Op op = Op::Alloc;
+    uint64_t object = 0;
+    uint64_t size = 0;  // alloc only
+};
+
+inline size_t encode_varint(uint64_t value, unsigned char* out) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = static_cast<unsigned char>(value);
+    return length;
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Appends one record to @p out (at least kMaxRecordBytes long) and advances
+// @p previous_ns. Header-only so the recording shim can use it without
+// allocating.
+inline size_t encode_event(const Event& event, uint64_t& previous_ns, unsigned char* out) {
+    size_t length = 0;
+    out[length++] = static_cast<unsigned char>(event.op);
+    length += encode_varint(zigzag(static_cast<int64_t>(event.timestamp_ns - previous_ns)), out + length);
+    length += encode_varint(event.thread, out + length);
+    length += encode_varint(event.object, out + length);
+    if (event.op == Op::Alloc) {
+        length += encode_varint(event.size, out + length);
+    }
+    previous_ns = event.timestamp_ns;
+    return length;
+}
+
+// Reads a binary or text trace (detected from the magic), sorted by timestamp
+// with file order breaking ties. On failure returns false and sets @p error.
+bool read_trace(const std::string& path, std::vector<Event>& events, std::string& error);
+
+bool write_binary_trace(const std::string& path, const std::vector<Event>& events, std::string& error);
+bool write_text_trace(const std::string& path, const std::vector<Event>& events, std::string& error);
+
+// One operation of one replay thread.
+struct ReplayOp {
+    uint32_t object;  // dense index into ReplayPlan::sizes
+    bool free;
+};
+
+/**
+ * A trace rearranged for replay: per-thread operation lists over dense object
+ * indices. Every index is allocated exactly once, so an object ID the trace
+ * reuses after freeing it gets a fresh index. Frees of IDs that are not live
+ * (allocated before the trace started) are dropped.
+ */
+struct ReplayPlan {
+    std::vector<uint32_t> thread_ids;           // original ID of each replay thread
+    std::vector<std::vector<ReplayOp>> threads;
+    std::vector<uint64_t> sizes;                // per object index
+    size_t allocations = 0;
+    size_t frees = 0;
+    size_t cross_thread_frees = 0;              // freed on a different thread than allocated
+    size_t dropped_frees = 0;
+    size_t leaked = 0;                          // still live at the end of the trace
+    uint64_t peak_live_bytes = 0;               // requested bytes, in timestamp order
+};
+
+ReplayPlan build_replay_plan(const std::vector<Event>& events);
+
+} // namespace alloc_trace
@@ -0,0 +1,108 @@
+#include "alloc_trace.hpp"
+#include "test_runner.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using alloc_trace::Event;
+using alloc_trace::Op;
+using alloc_trace::ReplayPlan;
+
+namespace {
+
+std::string temp_trace_path(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::vector<Event> sample_events() {
+    // Deliberately out of timestamp order, as per-thread buffers are written.
+    return {
+        Event{100, 0, Op::Alloc, 1, 32},
+        Event{300, 1, Op::Free, 1, 0},
+        Event{200, 1, Op::Alloc, 2, 4096},
+        Event{400, 7, Op::Alloc, uint64_t{1} << 40, 100000},
+        Event{500, 7, Op::Free, 2, 0},
+    };
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// File formats
+// ---------------------------------------------------------------------------
+
+TEST(AllocTrace_BinaryAndTextRoundTripSorted) {
+    const std::vector<Event> events = sample_events();
+    for (const bool binary : {true, false}) {
+        const std::string path = temp_trace_path(binary ? "cma_trace_test.bin" : "cma_trace_test.txt");
+        std::string error;
+        EXPECT_TRUE(binary ? alloc_trace::write_binary_trace(path, events, error)
+                           : alloc_trace::write_text_trace(path, events, error));
+        std::vector<Event> loaded;
+        EXPECT_TRUE(alloc_trace::read_trace(path, loaded, error));
+        EXPECT_EQ(loaded.size(), events.size());
+        const uint64_t expected_ts[] = {100, 200, 300, 400, 500};
+        for (size_t i = 0; i < loaded.size() && i < 5; ++i) {
+            EXPECT_EQ(loaded[i].timestamp_ns, expected_ts[i]);
+        }
+        EXPECT_EQ(loaded[1].size, 4096U);
+        EXPECT_EQ(loaded[3].object, uint64_t{1} << 40);
+        EXPECT_EQ(loaded[3].thread, 7U);
+        EXPECT_TRUE(loaded[4].op == Op::Free);
+        std::remove(path.c_str());
+    }
+}
+
+TEST(AllocTrace_TextParsesLongOpNamesAndRejectsGarbage) {
+    const std::string path = temp_trace_path("cma_trace_text_test.txt");
+    {
+        std::ofstream file(path);
+        file << "# comment\n\n10 3 alloc 5 64\n20 3 free 5\n";
+    }
+    std::vector<Event> events;
+    std::string error;
+    EXPECT_TRUE(alloc_trace::read_trace(path, events, error));
+    EXPECT_EQ(events.size(), 2U);
+    EXPECT_EQ(events[0].size, 64U);
+    {
+        std::ofstream file(path);
+        file << "10 3 realloc 5 64\n";
+    }
+    EXPECT_FALSE(alloc_trace::read_trace(path, events, error));
+    EXPECT_FALSE(error.empty());
+    std::remove(path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Replay plan
+// ---------------------------------------------------------------------------
+
+TEST(AllocTrace_PlanRemapsReusedIdsAndDropsUnmatchedFrees) {
+    const std::vector<Event> events = {
+        Event{1, 10, Op::Free, 99, 0},      // allocated before the trace started
+        Event{2, 10, Op::Alloc, 5, 100},
+        Event{3, 20, Op::Free, 5, 0},       // cross-thread
+        Event{4, 20, Op::Alloc, 5, 300},    // ID reused
+        Event{5, 10, Op::Alloc, 6, 50},     // never freed
+    };
+    const ReplayPlan plan = alloc_trace::build_replay_plan(events);
+    EXPECT_EQ(plan.threads.size(), 2U);
+    EXPECT_EQ(plan.thread_ids[0], 10U);
+    EXPECT_EQ(plan.allocations, 3U);
+    EXPECT_EQ(plan.frees, 1U);
+    EXPECT_EQ(plan.cross_thread_frees, 1U);
+    EXPECT_EQ(plan.dropped_frees, 1U);
+    EXPECT_EQ(plan.leaked, 2U);
+    EXPECT_EQ(plan.sizes.size(), 3U);
+    EXPECT_EQ(plan.peak_live_bytes, 350U);
+    // Thread 20 frees the first incarnation (index 0) and allocates a new one.
+    EXPECT_EQ(plan.threads[1].size(), 2U);
+    EXPECT_EQ(plan.threads[1][0].object, 0U);
+    EXPECT_TRUE(plan.threads[1][0].free);
+    EXPECT_EQ(plan.threads[1][1].object, 1U);
+    EXPECT_FALSE(plan.threads[1][1].free);
+}
@@ -1,4 +1,7 @@
+#include "ipc_benchmark.hpp"
 #include "lifecycle_trace.hpp"
+#include "persist_benchmark.hpp"
+#include "trace_replay.hpp"
 
 #include <iostream>
 #include <string>
@@ -10,5 +13,14 @@ int main(int argc, char* argv[]) {
     if (argc >= 2 && std::string(argv[1]) == "trace") {
         return run_lifecycle_trace(argc, argv);
     }
+    if (argc >= 2 && std::string(argv[1]) == "ipc") {
+        return run_ipc_benchmark(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "persist") {
+        return run_persist_benchmark(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "replay") {
+        return run_trace_replay(argc, argv);
+    }
     return run_benchmark_cli(argc, argv);
 }
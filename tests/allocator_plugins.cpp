@@ -0,0 +1,196 @@
+#include "allocator_plugins.hpp"
+
+#include <cstdlib>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define CMA_HAS_MALLINFO2 1
+#else
+#define CMA_HAS_MALLINFO2 0
+#endif
+
+namespace bench {
+namespace {
+
+struct SymbolPair {
+    std::string malloc_name;
+    std::string free_name;
+};
+
+// Library file names to try in order, and the symbol pairs the allocator may
+// export. Prefixed entry points come first: they are the allocator's own even
+// in builds that do not override malloc.
+struct PluginSpec {
+    std::string name;
+    std::vector<std::string> libraries;
+    std::vector<SymbolPair> symbols;
+};
+
+std::vector<PluginSpec> known_plugins() {
+    return {
+        {"jemalloc",
+         {"libjemalloc.so.2", "libjemalloc.so", "libjemalloc.2.dylib", "libjemalloc.dylib", "jemalloc.dll"},
+         {{"je_malloc", "je_free"}, {"malloc", "free"}}},
+        {"tcmalloc",
+         {"libtcmalloc_minimal.so.4", "libtcmalloc.so.4", "libtcmalloc_minimal.so", "libtcmalloc.so",
+          "libtcmalloc_minimal.dylib", "libtcmalloc.dylib"},
+         {{"tc_malloc", "tc_free"}, {"malloc", "free"}}},
+        {"mimalloc",
+         {"libmimalloc.so.2", "libmimalloc.so", "libmimalloc.dylib", "mimalloc.dll"},
+         {{"mi_malloc", "mi_free"}, {"malloc", "free"}}},
+    };
+}
+
+// CMA_BENCH_PLUGINS=name=path[,name=path...]
+std::vector<PluginSpec> plugins_from_environment(std::vector<std::string>& skipped) {
+    std::vector<PluginSpec> specs;
+    const char* value = std::getenv("CMA_BENCH_PLUGINS");
+    if (value == nullptr) {
+        return specs;
+    }
+    const std::string list = value;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        const std::string entry = list.substr(start, end - start);
+        const size_t equals = entry.find('=');
+        if (equals == 0 || equals == std::string::npos || equals + 1 == entry.size()) {
+            if (!entry.empty()) {
+                skipped.push_back("CMA_BENCH_PLUGINS: expected name=path, got '" + entry + "'");
+            }
+        } else {
+            specs.push_back(PluginSpec{entry.substr(0, equals), {entry.substr(equals + 1)}, {{"malloc", "free"}}});
+        }
+        start = end + 1;
+    }
+    return specs;
+}
+
+void* open_library(const std::string& path) {
+#if defined(_WIN32)
+    return reinterpret_cast<void*>(LoadLibraryA(path.c_str()));
+#else
+    return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+void* find_symbol(void* library, const std::string& name) {
+#if defined(_WIN32)
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(library), name.c_str()));
+#else
+    return dlsym(library, name.c_str());
+#endif
+}
+
+// A plain "malloc" lookup falls through to the C library when the plugin does
+// not define one, so a result equal to the process allocator is rejected.
+bool resolve_symbols(void* library, const std::vector<SymbolPair>& symbols, MallocApi& api) {
+    for (const SymbolPair& pair : symbols) {
+        void* malloc_sym = find_symbol(library, pair.malloc_name);
+        void* free_sym = find_symbol(library, pair.free_name);
+        if (malloc_sym == nullptr || free_sym == nullptr ||
+            malloc_sym == reinterpret_cast<void*>(system_malloc().malloc_fn)) {
+            continue;
+        }
+        api.malloc_fn = reinterpret_cast<void* (*)(size_t)>(malloc_sym);
+        api.free_fn = reinterpret_cast<void (*)(void*)>(free_sym);
+        return true;
+    }
+    return false;
+}
+
+void load_plugin(const PluginSpec& spec, std::vector<MallocApi>& plugins, std::vector<std::string>& skipped) {
+    for (const MallocApi& loaded : plugins) {
+        if (loaded.name == spec.name) {
+            skipped.push_back(spec.name + ": name already used by " + loaded.library);
+            return;
+        }
+    }
+    for (const std::string& library : spec.libraries) {
+        void* handle = open_library(library);
+        if (handle == nullptr) {
+            continue;
+        }
+        MallocApi api;
+        api.name = spec.name;
+        api.library = library;
+        if (resolve_symbols(handle, spec.symbols, api)) {
+            plugins.push_back(std::move(api));
+        } else {
+            skipped.push_back(spec.name + ": " + library + " does not export its own malloc/free");
+        }
+        return;
+    }
+    skipped.push_back(spec.name + ": not found");
+}
+
+} // namespace
+
+const MallocApi& system_malloc() {
+    static const MallocApi api{"system", "", &std::malloc, &std::free};
+    return api;
+}
+
+bool mapped_bytes_known(const MallocApi& api) {
+    return CMA_HAS_MALLINFO2 && api.library.empty();
+}
+
+size_t mapped_bytes(const MallocApi& api) {
+#if CMA_HAS_MALLINFO2
+    if (mapped_bytes_known(api)) {
+        const struct mallinfo2 info = mallinfo2();
+        return info.arena + info.hblkhd;
+    }
+#else
+    (void)api;
+#endif
+    return 0;
+}
+
+size_t allocated_bytes(const MallocApi& api) {
+#if CMA_HAS_MALLINFO2
+    if (mapped_bytes_known(api)) {
+        const struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+    }
+#else
+    (void)api;
+#endif
+    return 0;
+}
+
+void trim_system_malloc() {
+#if CMA_HAS_MALLINFO2
+    malloc_trim(0);
+#endif
+}
+
+const std::vector<MallocApi>& allocator_plugins(std::vector<std::string>* skipped) {
+    static std::vector<std::string> skipped_plugins;
+    static const std::vector<MallocApi> plugins = [] {
+        std::vector<MallocApi> loaded;
+        for (const PluginSpec& spec : known_plugins()) {
+            load_plugin(spec, loaded, skipped_plugins);
+        }
+        for (const PluginSpec& spec : plugins_from_environment(skipped_plugins)) {
+            load_plugin(spec, loaded, skipped_plugins);
+        }
+        return loaded;
+    }();
+    if (skipped != nullptr) {
+        *skipped = skipped_plugins;
+    }
+    return plugins;
+}
+
+} // namespace bench
@@ -0,0 +1,50 @@
+#pragma once
+
+// Other general-purpose allocators (jemalloc, tcmalloc, mimalloc, ...) loaded
+// at run time, so the benchmarks can compare against whichever are installed
+// without linking them into the binary.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// A malloc/free pair under test.
+struct MallocApi {
+    std::string name;     // CSV allocator_type, e.g. "system" or "jemalloc"
+    std::string library;  // path the pair came from; empty for the process allocator
+    void* (*malloc_fn)(size_t) = nullptr;
+    void (*free_fn)(void*) = nullptr;
+};
+
+// std::malloc / std::free, reported as "system".
+const MallocApi& system_malloc();
+
+// Bytes @p api holds from the OS, from glibc's mallinfo2() (arenas plus
+// mmapped chunks). Only the system allocator on glibc 2.33+ has this view;
+// mapped_bytes_known() says whether mapped_bytes() means anything.
+bool mapped_bytes_known(const MallocApi& api);
+size_t mapped_bytes(const MallocApi& api);
+
+// Bytes in chunks @p api has handed out, headers and rounding included
+// (mallinfo2 in-use plus mmapped chunks). Known exactly when mapped bytes are.
+size_t allocated_bytes(const MallocApi& api);
+
+// Returns free memory the system allocator still holds to the OS
+// (malloc_trim on glibc), so one run's leftovers do not hide the next run's
+// growth. A no-op elsewhere.
+void trim_system_malloc();
+
+/**
+ * Loads the known allocators that are installed, plus any listed in the
+ * CMA_BENCH_PLUGINS environment variable as comma-separated name=path entries
+ * (those must export malloc and free). Each library is opened RTLD_LOCAL, so
+ * it does not replace the process allocator, and is never closed. Libraries
+ * that are missing, or whose malloc resolves to the process allocator, are
+ * skipped; when @p skipped is given, it receives one line per skipped entry.
+ * Loading happens once per process, and later calls return the same list.
+ */
+const std::vector<MallocApi>& allocator_plugins(std::vector<std::string>* skipped = nullptr);
+
+} // namespace bench
@@ -0,0 +1,942 @@
+#include "bench_harness.hpp"
+
+#include "PlatformMemory.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+namespace {
+
+// First line of a small sysfs/procfs file, or "" if it does not exist.
+std::string read_first_line(const char* path) {
+    std::ifstream file(path);
+    std::string line;
+    if (file) {
+        std::getline(file, line);
+    }
+    return line;
+}
+
+double read_khz_as_mhz(const char* path) {
+    const std::string text = read_first_line(path);
+    return text.empty() ? 0.0 : std::strtod(text.c_str(), nullptr) / 1000.0;
+}
+
+// Value of the first "key : value" line in /proc/cpuinfo starting with @p key.
+std::string cpuinfo_field(const std::string& key) {
+    std::ifstream file("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, key.size(), key) == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                const size_t start = line.find_first_not_of(' ', colon + 1);
+                return start == std::string::npos ? std::string() : line.substr(start);
+            }
+        }
+    }
+    return std::string();
+}
+
+// What the compiler was told, as far as predefined macros reveal it. GCC and
+// Clang do not expose the -O level, only whether optimization is on.
+std::string detect_build_flags() {
+    std::string flags;
+    const auto add = [&flags](const char* flag) {
+        flags += flags.empty() ? "" : " ";
+        flags += flag;
+    };
+#if defined(__OPTIMIZE__)
+    add("-O");
+#elif defined(__GNUC__)
+    add("-O0");
+#endif
+#if defined(NDEBUG)
+    add("-DNDEBUG");
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+    add("-fsanitize=address");
+#endif
+#if defined(__SANITIZE_THREAD__) || defined(CMA_TSAN_BUILD)
+    add("-fsanitize=thread");
+#endif
+#if defined(CMA_SLOW_PATH_STATS) && CMA_SLOW_PATH_STATS
+    add("-DCMA_SLOW_PATH_STATS=1");
+#endif
+#if defined(__FAST_MATH__)
+    add("-ffast-math");
+#endif
+#if defined(__AVX512F__)
+    add("-mavx512f");
+#elif defined(__AVX2__)
+    add("-mavx2");
+#endif
+    return flags;
+}
+
+// Recursive-descent JSON reader. Numbers go through strtod, \u escapes
+// become UTF-8, and nesting is capped so hostile input cannot blow the stack.
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_text(text) {}
+
+    bool parse(JsonValue& value, std::string* error) {
+        bool ok = parse_value(value, 0);
+        if (ok) {
+            skip_whitespace();
+            ok = m_pos == m_text.size() || fail("unexpected trailing characters");
+        }
+        if (!ok && error != nullptr) {
+            *error = m_error + " at offset " + std::to_string(m_pos);
+        }
+        return ok;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 64;
+
+    bool fail(const char* what) {
+        m_error = what;
+        return false;
+    }
+
+    void skip_whitespace() {
+        while (m_pos < m_text.size() &&
+               (m_text[m_pos] == ' ' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r' || m_text[m_pos] == '\t')) {
+            ++m_pos;
+        }
+    }
+
+    bool consume(char expected) {
+        skip_whitespace();
+        if (m_pos < m_text.size() && m_text[m_pos] == expected) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool parse_value(JsonValue& value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        skip_whitespace();
+        if (m_pos >= m_text.size()) {
+            return fail("unexpected end of input");
+        }
+        switch (m_text[m_pos]) {
+        case '{':
+            return parse_object(value, depth);
+        case '[':
+            return parse_array(value, depth);
+        case '"':
+            value.type = JsonValue::Type::String;
+            return parse_string(value.string);
+        case 't':
+            value.type = JsonValue::Type::Bool;
+            value.boolean = true;
+            return parse_literal("true");
+        case 'f':
+            value.type = JsonValue::Type::Bool;
+            value.boolean = false;
+            return parse_literal("false");
+        case 'n':
+            value.type = JsonValue::Type::Null;
+            return parse_literal("null");
+        default:
+            value.type = JsonValue::Type::Number;
+            return parse_number(value.number);
+        }
+    }
+
+    bool parse_object(JsonValue& value, int depth) {
+        value.type = JsonValue::Type::Object;
+        ++m_pos;
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            skip_whitespace();
+            std::pair<std::string, JsonValue> member;
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"') {
+                return fail("expected a member name");
+            }
+            if (!parse_string(member.first)) {
+                return false;
+            }
+            if (!consume(':')) {
+                return fail("expected ':'");
+            }
+            if (!parse_value(member.second, depth + 1)) {
+                return false;
+            }
+            value.object.push_back(std::move(member));
+        } while (consume(','));
+        return consume('}') || fail("expected ',' or '}'");
+    }
+
+    bool parse_array(JsonValue& value, int depth) {
+        value.type = JsonValue::Type::Array;
+        ++m_pos;
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            value.array.emplace_back();
+            if (!parse_value(value.array.back(), depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']') || fail("expected ',' or ']'");
+    }
+
+    bool parse_literal(const char* word) {
+        const size_t length = std::strlen(word);
+        if (m_text.compare(m_pos, length, word) != 0) {
+            return fail("invalid literal");
+        }
+        m_pos += length;
+        return true;
+    }
+
+    bool parse_number(double& number) {
+        const size_t start = m_pos;
+        while (m_pos < m_text.size() && std::strchr("+-0123456789.eE", m_text[m_pos]) != nullptr) {
+            ++m_pos;
+        }
+        if (m_pos == start) {
+            return fail("unexpected character");
+        }
+        const std::string digits = m_text.substr(start, m_pos - start);
+        char* end = nullptr;
+        number = std::strtod(digits.c_str(), &end);
+        return end == digits.c_str() + digits.size() || fail("invalid number");
+    }
+
+    bool parse_hex4(unsigned int& code) {
+        if (m_pos + 4 > m_text.size()) {
+            return fail("truncated \\u escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = m_text[m_pos++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<unsigned int>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<unsigned int>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<unsigned int>(c - 'A' + 10);
+            } else {
+                return fail("invalid \\u escape");
+            }
+        }
+        return true;
+    }
+
+    static void append_utf8(std::string& out, unsigned int code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parse_string(std::string& out) {
+        ++m_pos;  // opening quote
+        while (m_pos < m_text.size()) {
+            const char c = m_text[m_pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (m_pos >= m_text.size()) {
+                break;
+            }
+            const char escape = m_text[m_pos++];
+            switch (escape) {
+            case '"':
+            case '\\':
+            case '/':
+                out += escape;
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u': {
+                unsigned int code = 0;
+                if (!parse_hex4(code)) {
+                    return false;
+                }
+                // A high surrogate followed by a low one encodes a code point above U+FFFF.
+                // Either half on its own is not a character.
+                if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return fail("invalid surrogate pair");
+                }
+                if (code >= 0xD800 && code < 0xDC00) {
+                    if (m_text.compare(m_pos, 2, "\\u") != 0) {
+                        return fail("invalid surrogate pair");
+                    }
+                    m_pos += 2;
+                    unsigned int low = 0;
+                    if (!parse_hex4(low)) {
+                        return false;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return fail("invalid surrogate pair");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    const std::string& m_text;
+    size_t m_pos = 0;
+    std::string m_error;
+};
+
+double median_of_sorted(const std::vector<double>& sorted) {
+    const size_t n = sorted.size();
+    if (n == 0) {
+        return 0.0;
+    }
+    return n % 2 == 1 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+} // namespace
+
+HostInfo detect_host() {
+    HostInfo host;
+    host.logical_cpus = std::thread::hardware_concurrency();
+    host.cpu_model = cpuinfo_field("model name");
+    if (host.cpu_model.empty()) {
+        host.cpu_model = cpuinfo_field("Hardware");
+    }
+    host.governor = read_first_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    host.current_mhz = read_khz_as_mhz("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+    host.max_mhz = read_khz_as_mhz("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    if (host.current_mhz == 0.0) {
+        const std::string mhz = cpuinfo_field("cpu MHz");
+        host.current_mhz = mhz.empty() ? 0.0 : std::strtod(mhz.c_str(), nullptr);
+    }
+    const std::string no_turbo = read_first_line("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    const std::string boost = read_first_line("/sys/devices/system/cpu/cpufreq/boost");
+    if (!no_turbo.empty()) {
+        host.turbo = no_turbo == "0" ? 1 : 0;
+    } else if (!boost.empty()) {
+        host.turbo = boost == "1" ? 1 : 0;
+    }
+#if !defined(_WIN32)
+    utsname name{};
+    if (uname(&name) == 0) {
+        host.kernel = std::string(name.sysname) + " " + name.release;
+    }
+#endif
+#if defined(__clang__)
+    host.compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    host.compiler = std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    host.compiler = "msvc " + std::to_string(_MSC_VER);
+#endif
+    host.build_flags = detect_build_flags();
+    return host;
+}
+
+std::vector<std::string> host_differences(const HostInfo& baseline, const HostInfo& current) {
+    std::vector<std::string> differences;
+    const auto compare = [&differences](const char* field, const std::string& before, const std::string& after) {
+        if (before != after) {
+            differences.push_back(std::string(field) + ": " + (before.empty() ? "(unknown)" : before) + " -> " +
+                                  (after.empty() ? "(unknown)" : after));
+        }
+    };
+    compare("cpu", baseline.cpu_model, current.cpu_model);
+    compare("logical cpus", std::to_string(baseline.logical_cpus), std::to_string(current.logical_cpus));
+    compare("kernel", baseline.kernel, current.kernel);
+    compare("compiler", baseline.compiler, current.compiler);
+    compare("build flags", baseline.build_flags, current.build_flags);
+    compare("governor", baseline.governor, current.governor);
+    return differences;
+}
+
+std::vector<std::string> host_warnings(const HostInfo& host) {
+    std::vector<std::string> warnings;
+    if (!host.governor.empty() && host.governor != "performance") {
+        warnings.push_back("cpufreq governor is '" + host.governor +
+                           "'; use 'performance' for stable numbers");
+    }
+    if (host.turbo == 1) {
+        warnings.push_back("turbo/boost is enabled; clocks may vary with temperature and load");
+    }
+    if (host.governor.empty()) {
+        warnings.push_back("CPU frequency scaling is not visible (VM or container?); clocks are unknown");
+    }
+    return warnings;
+}
+
+Summary summarize(std::vector<double> samples) {
+    Summary summary;
+    summary.count = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    summary.median = median_of_sorted(samples);
+    summary.min = samples.front();
+    summary.max = samples.back();
+
+    double sum = 0.0;
+    for (const double value : samples) {
+        sum += value;
+    }
+    summary.mean = sum / static_cast<double>(n);
+    double squares = 0.0;
+    std::vector<double> deviations;
+    deviations.reserve(n);
+    for (const double value : samples) {
+        squares += (value - summary.mean) * (value - summary.mean);
+        deviations.push_back(std::fabs(value - summary.median));
+    }
+    summary.stddev = n > 1 ? std::sqrt(squares / static_cast<double>(n - 1)) : 0.0;
+    std::sort(deviations.begin(), deviations.end());
+    summary.mad = median_of_sorted(deviations);
+
+    // Ranks j..k (1-based) bracket the median with ~95% probability:
+    // n/2 -+ 1.96 * sqrt(n)/2 under the binomial(n, 1/2) approximation.
+    const double half_width = 1.96 * std::sqrt(static_cast<double>(n)) / 2.0;
+    const double low_rank = std::floor(static_cast<double>(n) / 2.0 - half_width);
+    const double high_rank = std::ceil(1.0 + static_cast<double>(n) / 2.0 + half_width);
+    const size_t low = low_rank < 1.0 ? 0 : static_cast<size_t>(low_rank) - 1;
+    const size_t high = high_rank > static_cast<double>(n) ? n - 1 : static_cast<size_t>(high_rank) - 1;
+    summary.ci_low = samples[low];
+    summary.ci_high = samples[high];
+    return summary;
+}
+
+Measurement measure(const std::function<double(size_t ops)>& run, const HarnessConfig& config) {
+    const double target_ns = config.target_rep_ms * 1e6;
+    size_t ops = config.fixed_ops > 0 ? config.fixed_ops : config.min_ops;
+    while (config.fixed_ops == 0) {
+        const double elapsed = run(ops);
+        if (elapsed >= target_ns || ops >= config.max_ops) {
+            break;
+        }
+        // Aim slightly past the target; at least double so tiny timings converge fast.
+        const double scale = elapsed > 0.0 ? 1.2 * target_ns / elapsed : 10.0;
+        const double next = static_cast<double>(ops) * std::max(2.0, std::min(scale, 100.0));
+        ops = next >= static_cast<double>(config.max_ops) ? config.max_ops : static_cast<size_t>(next);
+    }
+
+    for (size_t i = 0; i < config.warmup_runs; ++i) {
+        run(ops);
+    }
+
+    Measurement measurement;
+    measurement.ops_per_rep = ops;
+    measurement.ns_per_op.reserve(config.repetitions);
+    for (size_t i = 0; i < config.repetitions; ++i) {
+        measurement.ns_per_op.push_back(run(ops) / static_cast<double>(ops));
+    }
+    measurement.summary = summarize(measurement.ns_per_op);
+    return measurement;
+}
+
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b) {
+    const size_t n1 = a.size();
+    const size_t n2 = b.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0;
+    }
+    // (value, from a) sorted, then ranked with ties sharing their average rank.
+    std::vector<std::pair<double, bool>> all;
+    all.reserve(n1 + n2);
+    for (const double value : a) {
+        all.emplace_back(value, true);
+    }
+    for (const double value : b) {
+        all.emplace_back(value, false);
+    }
+    std::sort(all.begin(), all.end());
+    const double n = static_cast<double>(n1 + n2);
+    double rank_sum_a = 0.0;
+    double tie_term = 0.0;  // sum of t^3 - t over tie groups
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+        const double ties = static_cast<double>(j - i);
+        const double rank = static_cast<double>(i + j + 1) / 2.0;  // ranks are 1-based
+        for (size_t k = i; k < j; ++k) {
+            rank_sum_a += all[k].second ? rank : 0.0;
+        }
+        tie_term += ties * ties * ties - ties;
+        i = j;
+    }
+    const double u = rank_sum_a - static_cast<double>(n1) * static_cast<double>(n1 + 1) / 2.0;
+    const double mean = static_cast<double>(n1) * static_cast<double>(n2) / 2.0;
+    const double variance = static_cast<double>(n1) * static_cast<double>(n2) / 12.0 *
+                            ((n + 1.0) - tie_term / (n * (n - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;  // every sample equal
+    }
+    const double z = std::max(std::abs(u - mean) - 0.5, 0.0) / std::sqrt(variance);  // continuity-corrected
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+std::vector<double> hdr_quantile_ticks(uint64_t count, unsigned int ticks_per_half) {
+    std::vector<double> ticks;
+    const unsigned int per_half = std::max(ticks_per_half, 1U);
+    // remaining: the tail still to be split, 1 - (start of the current half).
+    for (double remaining = 1.0;; remaining /= 2.0) {
+        const double start = 1.0 - remaining;
+        for (unsigned int i = 0; i < per_half; ++i) {
+            ticks.push_back(start + remaining / 2.0 * static_cast<double>(i) / static_cast<double>(per_half));
+        }
+        if (remaining / 2.0 * static_cast<double>(count) < 1.0 || remaining < 1e-12) {
+            break;
+        }
+    }
+    ticks.push_back(1.0);
+    return ticks;
+}
+
+namespace {
+
+#if !defined(_WIN32)
+// Page faults and context switches of the whole process so far.
+void rusage_counts(long& faults, long& switches) {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    faults = usage.ru_minflt + usage.ru_majflt;
+    switches = usage.ru_nvcsw + usage.ru_nivcsw;
+}
+#endif
+
+#if defined(__linux__)
+// perf_event_attr type and config of each PerfEvent, in enum order.
+struct PerfEventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cache_miss_config(uint64_t cache) {
+    return cache | (uint64_t{PERF_COUNT_HW_CACHE_OP_READ} << 8) | (uint64_t{PERF_COUNT_HW_CACHE_RESULT_MISS} << 16);
+}
+
+constexpr PerfEventConfig kPerfEventConfigs[kPerfEventCount] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+int open_perf_event(const PerfEventConfig& event, bool user_only) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = user_only ? 1 : 0;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+#endif
+
+} // namespace
+
+const char* perf_event_name(PerfEvent event) {
+    switch (event) {
+    case PerfEvent::Cycles:
+        return "cycles";
+    case PerfEvent::Instructions:
+        return "instructions";
+    case PerfEvent::L1dMisses:
+        return "l1d_misses";
+    case PerfEvent::LlcMisses:
+        return "llc_misses";
+    case PerfEvent::DtlbMisses:
+        return "dtlb_misses";
+    case PerfEvent::PageFaults:
+        return "page_faults";
+    case PerfEvent::ContextSwitches:
+        return "context_switches";
+    }
+    return "unknown";
+}
+
+PerfCounters::PerfCounters() {
+    m_fds.fill(-1);
+#if defined(__linux__)
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        int fd = open_perf_event(kPerfEventConfigs[i], m_user_only);
+        if (fd < 0 && (errno == EACCES || errno == EPERM) && !m_user_only) {
+            // perf_event_paranoid >= 2 forbids kernel counting without CAP_PERFMON.
+            m_user_only = true;
+            fd = open_perf_event(kPerfEventConfigs[i], m_user_only);
+        }
+        if (fd < 0) {
+            m_unavailable.push_back(std::string(perf_event_name(static_cast<PerfEvent>(i))) + ": " +
+                                    std::strerror(errno));
+        }
+        m_fds[i] = fd;
+    }
+#else
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        m_unavailable.push_back(std::string(perf_event_name(static_cast<PerfEvent>(i))) +
+                                ": perf_event_open is Linux only");
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    for (const int fd : m_fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+void PerfCounters::start() {
+#if !defined(_WIN32)
+    rusage_counts(m_faults_before, m_switches_before);
+#endif
+#if defined(__linux__)
+    for (const int fd : m_fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfReading PerfCounters::stop() {
+    PerfReading reading;
+#if defined(__linux__)
+    for (const int fd : m_fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        // value, time enabled, time running
+        uint64_t data[3] = {};
+        if (m_fds[i] < 0 || read(m_fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) ||
+            data[2] == 0) {
+            continue;
+        }
+        reading.values[i] = static_cast<double>(data[0]);
+        if (data[2] < data[1]) {
+            reading.values[i] *= static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        }
+        reading.available[i] = true;
+    }
+#endif
+#if !defined(_WIN32)
+    long faults = 0;
+    long switches = 0;
+    rusage_counts(faults, switches);
+    const size_t page_faults = static_cast<size_t>(PerfEvent::PageFaults);
+    const size_t context_switches = static_cast<size_t>(PerfEvent::ContextSwitches);
+    if (!reading.available[page_faults]) {
+        reading.values[page_faults] = static_cast<double>(faults - m_faults_before);
+        reading.available[page_faults] = true;
+    }
+    if (!reading.available[context_switches]) {
+        reading.values[context_switches] = static_cast<double>(switches - m_switches_before);
+        reading.available[context_switches] = true;
+    }
+#endif
+    return reading;
+}
+
+MemorySampler::MemorySampler(std::function<size_t()> mapped_bytes, std::chrono::microseconds interval)
+    : m_mapped_bytes(std::move(mapped_bytes)), m_interval(interval) {
+    m_footprint.mapped_known = static_cast<bool>(m_mapped_bytes);
+    m_mapped_before = m_mapped_bytes ? m_mapped_bytes() : 0;
+    m_footprint.rss_before = cma::process_memory().resident_bytes;
+    m_footprint.peak_rss_reset = cma::reset_peak_resident();
+    sample();
+    m_thread = std::thread([this]() {
+        while (!m_done.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(m_interval);
+            sample();
+        }
+    });
+}
+
+MemorySampler::~MemorySampler() {
+    stop();
+}
+
+void MemorySampler::sample() {
+    const cma::ProcessMemory memory = cma::process_memory();
+    m_footprint.peak_rss = std::max(m_footprint.peak_rss, memory.resident_bytes);
+    m_footprint.peak_virtual_bytes = std::max(m_footprint.peak_virtual_bytes, memory.virtual_bytes);
+    if (m_mapped_bytes) {
+        const size_t mapped = m_mapped_bytes();
+        m_footprint.peak_mapped_bytes =
+            std::max(m_footprint.peak_mapped_bytes, mapped > m_mapped_before ? mapped - m_mapped_before : 0);
+    }
+}
+
+MemoryFootprint MemorySampler::stop() {
+    if (m_thread.joinable()) {
+        m_done.store(true, std::memory_order_release);
+        m_thread.join();
+        sample();
+        const size_t mapped = m_mapped_bytes ? m_mapped_bytes() : 0;
+        m_footprint.final_mapped_bytes = mapped > m_mapped_before ? mapped - m_mapped_before : 0;
+        m_footprint.final_rss = cma::process_memory().resident_bytes;
+        if (m_footprint.peak_rss_reset) {
+            m_footprint.peak_rss = std::max(m_footprint.peak_rss, cma::peak_resident_bytes());
+        }
+    }
+    return m_footprint;
+}
+
+bool parse_pinning(const std::string& text, Pinning& pinning) {
+    if (text == "none") {
+        pinning = Pinning::None;
+    } else if (text == "cores") {
+        pinning = Pinning::Cores;
+    } else if (text == "socket") {
+        pinning = Pinning::Socket;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* pinning_name(Pinning pinning) {
+    switch (pinning) {
+    case Pinning::None:
+        return "none";
+    case Pinning::Cores:
+        return "cores";
+    case Pinning::Socket:
+        return "socket";
+    }
+    return "unknown";
+}
+
+CpuTopology detect_cpu_topology() {
+    CpuTopology topology;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return topology;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &set)) {
+            continue;
+        }
+        const std::string path =
+            "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/physical_package_id";
+        const std::string socket = read_first_line(path.c_str());
+        topology.cpus.push_back(cpu);
+        topology.sockets.push_back(socket.empty() ? -1 : std::atoi(socket.c_str()));
+    }
+#endif
+    return topology;
+}
+
+std::vector<int> usable_cpus(const CpuTopology& topology, Pinning pinning) {
+    if (pinning != Pinning::Socket || topology.cpus.empty()) {
+        return topology.cpus;
+    }
+    std::vector<int> cpus;
+    for (size_t i = 0; i < topology.cpus.size(); ++i) {
+        if (topology.sockets[i] == topology.sockets.front()) {
+            cpus.push_back(topology.cpus[i]);
+        }
+    }
+    return cpus;
+}
+
+std::vector<std::vector<int>> plan_pinning(Pinning pinning, unsigned int threads, const std::vector<int>& cpus) {
+    std::vector<std::vector<int>> plan(threads);
+    if (pinning == Pinning::None || cpus.empty()) {
+        return plan;
+    }
+    for (unsigned int t = 0; t < threads; ++t) {
+        plan[t] = pinning == Pinning::Cores ? std::vector<int>{cpus[t % cpus.size()]} : cpus;
+    }
+    return plan;
+}
+
+bool pin_current_thread(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+std::vector<unsigned int> scaling_thread_counts(unsigned int cores) {
+    cores = std::max(cores, 1U);
+    std::vector<unsigned int> counts;
+    for (unsigned int threads = 1; threads < cores; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(cores);
+    counts.push_back(cores * 2);
+    return counts;
+}
+
+std::string json_string(const std::string& value) {
+    std::string out = "\"";
+    for (const char c : value) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+void write_host_json(std::ostream& out, const HostInfo& host) {
+    out << "{\"cpu_model\":" << json_string(host.cpu_model) << ",\"logical_cpus\":" << host.logical_cpus
+        << ",\"governor\":" << json_string(host.governor) << ",\"current_mhz\":" << host.current_mhz
+        << ",\"max_mhz\":" << host.max_mhz << ",\"turbo\":" << host.turbo
+        << ",\"kernel\":" << json_string(host.kernel) << ",\"compiler\":" << json_string(host.compiler)
+        << ",\"build_flags\":" << json_string(host.build_flags) << "}";
+}
+
+void write_summary_json(std::ostream& out, const Summary& summary) {
+    out << "{\"count\":" << summary.count << ",\"median\":" << summary.median << ",\"mad\":" << summary.mad
+        << ",\"mean\":" << summary.mean << ",\"stddev\":" << summary.stddev << ",\"min\":" << summary.min
+        << ",\"max\":" << summary.max << ",\"ci95_low\":" << summary.ci_low << ",\"ci95_high\":" << summary.ci_high
+        << "}";
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    for (const auto& member : object) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+std::string JsonValue::string_or(const std::string& key, const std::string& fallback) const {
+    const JsonValue* member = find(key);
+    return member != nullptr && member->type == Type::String ? member->string : fallback;
+}
+
+double JsonValue::number_or(const std::string& key, double fallback) const {
+    const JsonValue* member = find(key);
+    return member != nullptr && member->type == Type::Number ? member->number : fallback;
+}
+
+bool parse_json(const std::string& text, JsonValue& value, std::string* error) {
+    value = JsonValue();
+    return JsonParser(text).parse(value, error);
+}
+
+HostInfo host_from_json(const JsonValue& json) {
+    HostInfo host;
+    host.cpu_model = json.string_or("cpu_model");
+    host.logical_cpus = static_cast<unsigned int>(json.number_or("logical_cpus"));
+    host.governor = json.string_or("governor");
+    host.current_mhz = json.number_or("current_mhz");
+    host.max_mhz = json.number_or("max_mhz");
+    host.turbo = static_cast<int>(json.number_or("turbo", -1.0));
+    host.kernel = json.string_or("kernel");
+    host.compiler = json.string_or("compiler");
+    host.build_flags = json.string_or("build_flags");
+    return host;
+}
+
+} // namespace bench
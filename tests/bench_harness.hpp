@@ -0,0 +1,279 @@
+#pragma once
+
+// Shared pieces for nanosecond benchmarks: iteration-count calibration,
+// repetition statistics, host detection, memory sampling and JSON helpers.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// What the machine was doing when the numbers were taken. Empty strings and
+// zeros mean "not exposed on this platform".
+struct HostInfo {
+    std::string cpu_model;
+    unsigned int logical_cpus = 0;
+    std::string governor;      // cpufreq scaling governor of cpu0
+    double current_mhz = 0.0;
+    double max_mhz = 0.0;
+    int turbo = -1;            // 1 enabled, 0 disabled, -1 unknown
+    std::string kernel;
+    std::string compiler;
+    std::string build_flags;   // optimization, NDEBUG, sanitizers, CMA_* options, ISA extensions
+};
+
+HostInfo detect_host();
+
+// Fields of @p current that differ from @p baseline in ways that move
+// timings (CPU, core count, kernel, compiler, build flags, governor), one
+// line each, e.g. "compiler: gcc 12.2.0 -> gcc 13.1.0".
+std::vector<std::string> host_differences(const HostInfo& baseline, const HostInfo& current);
+
+// Conditions that make timings drift between runs (e.g. a powersave governor).
+std::vector<std::string> host_warnings(const HostInfo& host);
+
+// Robust statistics of one benchmark's per-repetition samples. The 95%
+// confidence interval is for the median and comes from order statistics,
+// so it assumes nothing about the distribution.
+struct Summary {
+    size_t count = 0;
+    double median = 0.0;
+    double mad = 0.0;  // median absolute deviation (unscaled)
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double ci_low = 0.0;
+    double ci_high = 0.0;
+};
+
+Summary summarize(std::vector<double> samples);
+
+struct HarnessConfig {
+    size_t warmup_runs = 2;
+    size_t repetitions = 11;
+    double target_rep_ms = 20.0;  // calibrate ops so one repetition takes about this long
+    size_t min_ops = 1000;
+    size_t max_ops = size_t{1} << 28;
+    size_t fixed_ops = 0;  // nonzero: skip calibration and run this many ops per repetition
+};
+
+struct Measurement {
+    size_t ops_per_rep = 0;
+    std::vector<double> ns_per_op;  // one entry per repetition
+    Summary summary;
+};
+
+// Runs @p run (which performs the given number of operations and returns the
+// nanoseconds they took) until the op count fills target_rep_ms, then warms
+// up and takes the configured repetitions.
+Measurement measure(const std::function<double(size_t ops)>& run, const HarnessConfig& config);
+
+// Two-sided p-value of the Mann-Whitney U test that @p a and @p b come from
+// the same distribution (normal approximation with tie correction, fine from
+// about 8 samples each). 1.0 when either side is empty.
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b);
+
+// Quantiles at which to report a latency distribution of @p count samples, in
+// the style of HdrHistogram's percentile output: @p ticks_per_half evenly
+// spaced points in each halving of the remaining tail (0, 0.5, 0.75, 0.875,
+// ...), stopping once the tail holds less than one sample, then 1.0 (the max).
+std::vector<double> hdr_quantile_ticks(uint64_t count, unsigned int ticks_per_half = 2);
+
+// Memory use over one run. RSS and virtual size are process-wide; mapped
+// bytes are the allocator's own count, relative to the start of the run.
+struct MemoryFootprint {
+    size_t rss_before = 0;
+    size_t peak_rss = 0;
+    size_t final_rss = 0;
+    size_t peak_virtual_bytes = 0;
+    size_t peak_mapped_bytes = 0;
+    size_t final_mapped_bytes = 0;
+    bool mapped_known = false;
+    // False when the kernel high-water mark could not be reset, so peak_rss
+    // is only the sampled maximum.
+    bool peak_rss_reset = false;
+
+    size_t rss_growth() const {
+        return peak_rss > rss_before ? peak_rss - rss_before : 0;
+    }
+};
+
+/**
+ * Samples process memory and an allocator's mapped bytes on a background
+ * thread from construction until stop(). Peak RSS is the larger of the
+ * samples and the kernel high-water mark (reset at start where possible), so
+ * spikes shorter than the interval still count.
+ */
+class MemorySampler {
+public:
+    // @p mapped_bytes may be empty when the allocator does not expose it.
+    explicit MemorySampler(std::function<size_t()> mapped_bytes,
+                           std::chrono::microseconds interval = std::chrono::milliseconds(1));
+    ~MemorySampler();
+
+    MemorySampler(const MemorySampler&) = delete;
+    MemorySampler& operator=(const MemorySampler&) = delete;
+
+    // Joins the sampler (idempotent) and takes a final sample.
+    MemoryFootprint stop();
+
+private:
+    void sample();
+
+    std::function<size_t()> m_mapped_bytes;
+    std::chrono::microseconds m_interval;
+    size_t m_mapped_before = 0;
+    MemoryFootprint m_footprint;
+    std::atomic<bool> m_done{false};
+    std::thread m_thread;
+};
+
+// Counters PerfCounters tries to open.
+enum class PerfEvent {
+    Cycles,
+    Instructions,
+    L1dMisses,   // L1 data cache read misses
+    LlcMisses,   // last-level cache read misses
+    DtlbMisses,  // data TLB read misses
+    PageFaults,
+    ContextSwitches,
+};
+
+constexpr size_t kPerfEventCount = 7;
+
+// Short snake_case name for output, e.g. "l1d_misses".
+const char* perf_event_name(PerfEvent event);
+
+struct PerfReading {
+    std::array<double, kPerfEventCount> values{};
+    std::array<bool, kPerfEventCount> available{};
+
+    double value(PerfEvent event) const {
+        return values[static_cast<size_t>(event)];
+    }
+
+    bool has(PerfEvent event) const {
+        return available[static_cast<size_t>(event)];
+    }
+};
+
+/**
+ * Hardware and software counters for the calling thread, via
+ * perf_event_open. Counters are inherited, so threads the caller starts while
+ * counting are included once they have been joined. Events the kernel does
+ * not allow (perf_event_paranoid, or no PMU as in most VMs) stay unavailable.
+ * Page faults and context switches then fall back to getrusage(), which counts
+ * the whole process. Elsewhere only that fallback exists. Counts are scaled up
+ * when the kernel had to multiplex the counters.
+ */
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Zeroes and enables the counters.
+    void start();
+
+    // Disables the counters and reads them.
+    PerfReading stop();
+
+    // One line per event perf_event_open refused, e.g. "cycles: No such file or directory".
+    const std::vector<std::string>& unavailable() const {
+        return m_unavailable;
+    }
+
+    // The kernel only allowed user-space counting, so kernel time (page fault
+    // handling, mmap) is not in the cycle counts.
+    bool user_only() const {
+        return m_user_only;
+    }
+
+private:
+    std::array<int, kPerfEventCount> m_fds;
+    std::vector<std::string> m_unavailable;
+    bool m_user_only = false;
+    long m_faults_before = 0;
+    long m_switches_before = 0;
+};
+
+// Thread placement for scaling runs.
+enum class Pinning {
+    None,    // let the scheduler place threads
+    Cores,   // thread t on one CPU, round-robin over the usable CPUs
+    Socket,  // every thread may use any CPU of the first socket, none elsewhere
+};
+
+bool parse_pinning(const std::string& text, Pinning& pinning);
+const char* pinning_name(Pinning pinning);
+
+// CPUs this process may run on, ascending, with the socket (physical package)
+// of each, or -1 where unknown. Empty where affinity is not supported.
+struct CpuTopology {
+    std::vector<int> cpus;
+    std::vector<int> sockets;
+};
+
+CpuTopology detect_cpu_topology();
+
+// The CPUs a pinned run spreads over: all of them, or those of the first
+// CPU's socket for Pinning::Socket.
+std::vector<int> usable_cpus(const CpuTopology& topology, Pinning pinning);
+
+// Per-thread CPU sets for @p threads threads over @p cpus. Pinning::None
+// gives every thread an empty set (no pinning); more threads than CPUs wrap.
+std::vector<std::vector<int>> plan_pinning(Pinning pinning, unsigned int threads, const std::vector<int>& cpus);
+
+// Restricts the calling thread to @p cpus. False if that is not supported or
+// was refused; an empty set is a successful no-op.
+bool pin_current_thread(const std::vector<int>& cpus);
+
+// Thread counts of a scaling sweep on @p cores CPUs: powers of two below the
+// core count, the core count itself, and 2x oversubscription.
+std::vector<unsigned int> scaling_thread_counts(unsigned int cores);
+
+// JSON output: a quoted, escaped string literal.
+std::string json_string(const std::string& value);
+
+void write_host_json(std::ostream& out, const HostInfo& host);
+
+// A parsed JSON document, enough to read back what this harness writes.
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;  // in document order
+
+    // Member @p key of an object, or nullptr.
+    const JsonValue* find(const std::string& key) const;
+
+    // Member @p key as a string/number, or @p fallback when missing or of another type.
+    std::string string_or(const std::string& key, const std::string& fallback = std::string()) const;
+    double number_or(const std::string& key, double fallback = 0.0) const;
+};
+
+// Parses @p text into @p value. On failure returns false and, when @p error is
+// given, describes the problem and its offset.
+bool parse_json(const std::string& text, JsonValue& value, std::string* error = nullptr);
+
+// The HostInfo written by write_host_json(); missing fields stay empty.
+HostInfo host_from_json(const JsonValue& json);
+void write_summary_json(std::ostream& out, const Summary& summary);
+
+} // namespace bench
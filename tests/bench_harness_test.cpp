@@ -0,0 +1,253 @@
+#include "bench_harness.hpp"
+#include "PlatformMemory.hpp"
+#include "test_runner.hpp"
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Summary statistics
+// ---------------------------------------------------------------------------
+
+TEST(BenchHarness_SummaryOfKnownSamples) {
+    const bench::Summary summary = bench::summarize({5.0, 1.0, 3.0, 2.0, 4.0, 100.0});
+    EXPECT_EQ(summary.count, 6U);
+    EXPECT_EQ(summary.median, 3.5);
+    EXPECT_EQ(summary.min, 1.0);
+    EXPECT_EQ(summary.max, 100.0);
+    // Deviations from 3.5: 0.5 0.5 1.5 1.5 2.5 96.5 -> median 1.5; the outlier barely moves it.
+    EXPECT_EQ(summary.mad, 1.5);
+    EXPECT_EQ(summary.mean, 115.0 / 6.0);
+    EXPECT_LE(summary.ci_low, summary.median);
+    EXPECT_GE(summary.ci_high, summary.median);
+    EXPECT_EQ(bench::summarize({}).count, 0U);
+}
+
+TEST(BenchHarness_MedianIntervalNarrowsWithMoreSamples) {
+    std::vector<double> samples;
+    for (int i = 1; i <= 101; ++i) {
+        samples.push_back(static_cast<double>(i));
+    }
+    const bench::Summary summary = bench::summarize(samples);
+    EXPECT_EQ(summary.median, 51.0);
+    // Order-statistic ranks 41..61 for n = 101.
+    EXPECT_GE(summary.ci_low, 40.0);
+    EXPECT_LE(summary.ci_high, 62.0);
+    EXPECT_TRUE(summary.ci_high - summary.ci_low < 25.0);
+}
+
+TEST(BenchHarness_MannWhitneySeparatesShiftedSamples) {
+    std::vector<double> low;
+    std::vector<double> high;
+    for (int i = 0; i < 11; ++i) {
+        low.push_back(10.0 + i);
+        high.push_back(100.0 + i);
+    }
+    // Complete separation of 11 vs 11: U = 0, z ~ 3.9.
+    EXPECT_TRUE(bench::mann_whitney_p(low, high) < 0.001);
+    EXPECT_EQ(bench::mann_whitney_p(low, high), bench::mann_whitney_p(high, low));
+    EXPECT_GE(bench::mann_whitney_p(low, low), 0.99);
+    // Interleaved samples are indistinguishable.
+    std::vector<double> odd;
+    std::vector<double> even;
+    for (int i = 0; i < 20; ++i) {
+        (i % 2 == 0 ? even : odd).push_back(static_cast<double>(i));
+    }
+    EXPECT_GE(bench::mann_whitney_p(odd, even), 0.5);
+    EXPECT_EQ(bench::mann_whitney_p({1.0, 1.0}, {1.0, 1.0}), 1.0);
+    EXPECT_EQ(bench::mann_whitney_p({}, high), 1.0);
+}
+
+// ---------------------------------------------------------------------------
+// Calibration
+// ---------------------------------------------------------------------------
+
+TEST(BenchHarness_CalibratesOpsToTheTarget) {
+    bench::HarnessConfig config;
+    config.warmup_runs = 1;
+    config.repetitions = 5;
+    config.target_rep_ms = 1.0;
+    size_t calls = 0;
+    // A fake workload costing exactly 10 ns per operation.
+    const bench::Measurement measurement = bench::measure(
+        [&](size_t ops) {
+            ++calls;
+            return static_cast<double>(ops) * 10.0;
+        },
+        config);
+    EXPECT_GE(measurement.ops_per_rep, 100000U);
+    EXPECT_EQ(measurement.ns_per_op.size(), 5U);
+    EXPECT_EQ(measurement.summary.median, 10.0);
+    EXPECT_EQ(measurement.summary.mad, 0.0);
+    EXPECT_GE(calls, 5U + 1U + 1U);
+}
+
+TEST(BenchHarness_FixedOpsSkipsCalibration) {
+    bench::HarnessConfig config;
+    config.warmup_runs = 1;
+    config.repetitions = 3;
+    config.fixed_ops = 12345;
+    size_t calls = 0;
+    const bench::Measurement measurement = bench::measure(
+        [&](size_t ops) {
+            ++calls;
+            EXPECT_EQ(ops, 12345U);
+            return static_cast<double>(ops);
+        },
+        config);
+    EXPECT_EQ(measurement.ops_per_rep, 12345U);
+    EXPECT_EQ(calls, 4U);
+}
+
+TEST(BenchHarness_QuantileTicksHalveTowardsTheMax) {
+    const std::vector<double> ticks = bench::hdr_quantile_ticks(1000, 2);
+    EXPECT_EQ(ticks[0], 0.0);
+    EXPECT_EQ(ticks[1], 0.25);
+    EXPECT_EQ(ticks[2], 0.5);
+    EXPECT_EQ(ticks[3], 0.625);
+    EXPECT_EQ(ticks.back(), 1.0);
+    for (size_t i = 1; i < ticks.size(); ++i) {
+        EXPECT_TRUE(ticks[i] > ticks[i - 1]);
+    }
+    // The last tick before the max still has at least one of the 1000 samples above it.
+    EXPECT_GE((1.0 - ticks[ticks.size() - 2]) * 1000.0, 1.0);
+    EXPECT_GE(ticks[ticks.size() - 2], 0.998);
+    EXPECT_TRUE(bench::hdr_quantile_ticks(0) == std::vector<double>({0.0, 0.25, 1.0}));
+}
+
+// ---------------------------------------------------------------------------
+// Performance counters
+// ---------------------------------------------------------------------------
+
+TEST(BenchHarness_PerfCountersSeePageFaults) {
+    bench::PerfCounters counters;
+    EXPECT_EQ(bench::perf_event_name(bench::PerfEvent::DtlbMisses), std::string("dtlb_misses"));
+#if !defined(_WIN32)
+    // Touching freshly mapped pages faults each one in; without perf this comes from getrusage().
+    const size_t pages = 256;
+    const size_t size = pages * 4096;
+    counters.start();
+    auto* bytes = static_cast<unsigned char*>(cma::map_page(size));
+    EXPECT_NOT_NULL(bytes);
+    for (size_t offset = 0; offset < size; offset += 4096) {
+        bytes[offset] = 1;
+    }
+    const bench::PerfReading reading = counters.stop();
+    cma::unmap_page(bytes, size);
+    EXPECT_TRUE(reading.has(bench::PerfEvent::PageFaults));
+    EXPECT_GE(reading.value(bench::PerfEvent::PageFaults), static_cast<double>(pages / 2));
+    EXPECT_TRUE(reading.has(bench::PerfEvent::ContextSwitches));
+#endif
+    if (!counters.unavailable().empty()) {
+        EXPECT_TRUE(counters.unavailable()[0].find(':') != std::string::npos);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Thread placement
+// ---------------------------------------------------------------------------
+
+TEST(BenchHarness_ScalingSweepCoversCoresAndOversubscription) {
+    EXPECT_TRUE(bench::scaling_thread_counts(1) == std::vector<unsigned int>({1, 2}));
+    EXPECT_TRUE(bench::scaling_thread_counts(6) == std::vector<unsigned int>({1, 2, 4, 6, 12}));
+    EXPECT_TRUE(bench::scaling_thread_counts(8) == std::vector<unsigned int>({1, 2, 4, 8, 16}));
+}
+
+TEST(BenchHarness_PinningPlans) {
+    bench::CpuTopology topology;
+    topology.cpus = {0, 1, 2, 3};
+    topology.sockets = {0, 0, 1, 1};
+
+    const std::vector<int> all = bench::usable_cpus(topology, bench::Pinning::Cores);
+    const std::vector<int> socket = bench::usable_cpus(topology, bench::Pinning::Socket);
+    EXPECT_EQ(all.size(), 4U);
+    EXPECT_TRUE(socket == std::vector<int>({0, 1}));
+
+    // Five threads on four cores: the fifth shares the first core.
+    const auto cores = bench::plan_pinning(bench::Pinning::Cores, 5, all);
+    EXPECT_EQ(cores.size(), 5U);
+    EXPECT_TRUE(cores[3] == std::vector<int>({3}));
+    EXPECT_TRUE(cores[4] == std::vector<int>({0}));
+
+    const auto socket_plan = bench::plan_pinning(bench::Pinning::Socket, 3, socket);
+    EXPECT_TRUE(socket_plan[2] == socket);
+    EXPECT_TRUE(bench::plan_pinning(bench::Pinning::None, 2, all)[1].empty());
+
+    bench::Pinning pinning = bench::Pinning::None;
+    EXPECT_TRUE(bench::parse_pinning("socket", pinning));
+    EXPECT_TRUE(pinning == bench::Pinning::Socket);
+    EXPECT_FALSE(bench::parse_pinning("numa", pinning));
+}
+
+TEST(BenchHarness_JsonRoundTripsHostInfo) {
+    bench::HostInfo host;
+    host.cpu_model = "Test \"CPU\" @ 3.0GHz";
+    host.logical_cpus = 8;
+    host.kernel = "Linux 6.1";
+    host.compiler = "gcc 13.2.0";
+    host.build_flags = "-O -DNDEBUG";
+    host.turbo = 0;
+    std::ostringstream out;
+    bench::write_host_json(out, host);
+
+    bench::JsonValue json;
+    std::string error;
+    EXPECT_TRUE(bench::parse_json(out.str(), json, &error));
+    const bench::HostInfo parsed = bench::host_from_json(json);
+    EXPECT_EQ(parsed.cpu_model, host.cpu_model);
+    EXPECT_EQ(parsed.logical_cpus, 8U);
+    EXPECT_EQ(parsed.turbo, 0);
+    EXPECT_TRUE(bench::host_differences(host, parsed).empty());
+
+    host.compiler = "gcc 14.1.0";
+    const std::vector<std::string> differences = bench::host_differences(parsed, host);
+    EXPECT_EQ(differences.size(), 1U);
+    EXPECT_EQ(differences[0], std::string("compiler: gcc 13.2.0 -> gcc 14.1.0"));
+}
+
+TEST(BenchHarness_JsonParsesNestingAndRejectsGarbage) {
+    bench::JsonValue json;
+    EXPECT_TRUE(bench::parse_json(" {\"a\": [1, -2.5e1, true, null, \"\\u00e9\\n\"], \"b\": {}} ", json));
+    const bench::JsonValue* a = json.find("a");
+    EXPECT_NOT_NULL(a);
+    EXPECT_EQ(a->array.size(), 5U);
+    EXPECT_EQ(a->array[1].number, -25.0);
+    EXPECT_TRUE(a->array[2].boolean);
+    EXPECT_TRUE(a->array[3].type == bench::JsonValue::Type::Null);
+    EXPECT_EQ(a->array[4].string, std::string("\xc3\xa9\n"));
+    EXPECT_TRUE(json.find("missing") == nullptr);
+    EXPECT_EQ(json.number_or("b", 7.0), 7.0);
+
+    std::string error;
+    EXPECT_FALSE(bench::parse_json("{\"a\": [1, 2}", json, &error));
+    EXPECT_TRUE(error.find("offset") != std::string::npos);
+    EXPECT_FALSE(bench::parse_json("[1] x", json));
+    EXPECT_FALSE(bench::parse_json("\"open", json));
+}
+
+TEST(BenchHarness_JsonSurrogatePairs) {
+    bench::JsonValue json;
+    EXPECT_TRUE(bench::parse_json("\"\\ud83d\\ude00\"", json));
+    EXPECT_EQ(json.string, std::string("\xf0\x9f\x98\x80"));
+
+    // A high surrogate must be followed by a low one (DC00-DFFF).
+    std::string error;
+    EXPECT_FALSE(bench::parse_json("\"\\ud83d\\u0041\"", json, &error));
+    EXPECT_TRUE(error.find("invalid surrogate pair") != std::string::npos);
+    EXPECT_FALSE(bench::parse_json("\"\\ud83d\\ud83d\"", json));
+
+    // Unpaired halves: a lone high surrogate and a lone low one.
+    error.clear();
+    EXPECT_FALSE(bench::parse_json("\"\\ud83d\"", json, &error));
+    EXPECT_TRUE(error.find("invalid surrogate pair") != std::string::npos);
+    error.clear();
+    EXPECT_FALSE(bench::parse_json("\"\\ude00\"", json, &error));
+    EXPECT_TRUE(error.find("invalid surrogate pair") != std::string::npos);
+    EXPECT_FALSE(bench::parse_json("\"\\ud83dx\"", json));
+}
+
+TEST(BenchHarness_JsonStringEscapes) {
+    EXPECT_EQ(bench::json_string("a\"b\\c\n"), std::string("\"a\\\"b\\\\c\\n\""));
+}
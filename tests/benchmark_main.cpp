@@ -1,22 +1,42 @@
 #include "FixedBlockAllocator.hpp"
+#include "allocator_plugins.hpp"
+#include "bench_harness.hpp"
+#include "handoff_workloads.hpp"
+#include "stress_workloads.hpp"
 #include "workload_common.hpp"
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace {
 
 constexpr size_t kBlockSize = 32;
 constexpr const char* kPlotCsvPath = "dashboard/data/results.csv";
+constexpr const char* kHeapProfileFoldedPath = "dashboard/data/heap_profile.folded";
+constexpr const char* kHeapProfilePprofPath = "dashboard/data/heap_profile.pprof";
+constexpr const char* kMicrobenchJsonPath = "dashboard/data/microbench.json";
+constexpr const char* kBaselineJsonPath = "dashboard/data/baseline.json";
+constexpr const char* kScalingCsvPath = "dashboard/data/scaling.csv";
+constexpr const char* kTailCsvPath = "dashboard/data/tail_latency.csv";
+constexpr const char* kBlockSizesCsvPath = "dashboard/data/block_sizes.csv";
 
 // Sink used to defeat dead-code elimination: without consuming the allocated
 // memory the optimizer is free to delete an alloc/free pair entirely (which
@@ -33,15 +53,18 @@ inline void do_not_optimize(void* p) {
 #endif
 }
 
+// Writes/reads the first and last byte of a @p Size-byte block.
+template <size_t Size = kBlockSize>
 inline void touch_block(void* block, size_t i) {
     auto* bytes = static_cast<unsigned char*>(block);
     bytes[0] = static_cast<unsigned char>(i);
-    bytes[kBlockSize - 1] = static_cast<unsigned char>(i >> 8);
+    bytes[Size - 1] = static_cast<unsigned char>(i >> 8);
 }
 
+template <size_t Size = kBlockSize>
 inline unsigned long long read_block(void* block) {
     const auto* bytes = static_cast<const unsigned char*>(block);
-    return static_cast<unsigned long long>(bytes[0]) + bytes[kBlockSize - 1];
+    return static_cast<unsigned long long>(bytes[0]) + bytes[Size - 1];
 }
 
 enum class Workload {
@@ -57,6 +80,14 @@ enum class Threading {
 
 using Clock = std::chrono::high_resolution_clock;
 
+template <typename Fn>
+long long measure_ns(Fn fn) {
+    const auto start = Clock::now();
+    fn();
+    const auto end = Clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
 template <typename Fn>
 long long measure_ms(Fn fn) {
     const auto start = Clock::now();
@@ -79,7 +110,7 @@ constexpr Workload kAllWorkloads[] = {
 // Deterministic mix: ~50% alloc / ~50% free when live is non-empty; always alloc when empty.
 // Use xor'd hash bits for the decision — (salt & 1) correlates with op parity and collapses
 // to a 0/1 live toggle instead of a real mix.
-template <typename Alloc, typename Free>
+template <size_t Size = kBlockSize, typename Alloc, typename Free>
 unsigned long long run_random_mix(size_t operations,
                                   unsigned int seed,
                                   Alloc alloc,
@@ -93,12 +124,12 @@ unsigned long long run_random_mix(size_t operations,
         if (workload::random_mix_should_alloc(live.size(), salt)) {
             void* block = alloc();
             do_not_optimize(block);
-            touch_block(block, op);
+            touch_block<Size>(block, op);
             live.push_back(block);
         } else {
             const size_t index = salt % live.size();
             void* block = live[index];
-            checksum += read_block(block);
+            checksum += read_block<Size>(block);
             live[index] = live.back();
             live.pop_back();
             free_fn(block);
@@ -106,13 +137,13 @@ unsigned long long run_random_mix(size_t operations,
     }
 
     for (void* block : live) {
-        checksum += read_block(block);
+        checksum += read_block<Size>(block);
         free_fn(block);
     }
     return checksum;
 }
 
-template <typename Alloc, typename Free>
+template <size_t Size = kBlockSize, typename Alloc, typename Free>
 unsigned long long run_workload(Workload workload,
                                 size_t iterations,
                                 unsigned int seed,
@@ -124,15 +155,15 @@ unsigned long long run_workload(Workload workload,
         for (size_t i = 0; i < iterations; ++i) {
             void* block = alloc();
             do_not_optimize(block);
-            touch_block(block, i);
-            checksum += read_block(block);
+            touch_block<Size>(block, i);
+            checksum += read_block<Size>(block);
             free_fn(block);
         }
         return checksum;
     }
 
     if (workload == Workload::RandomMix) {
-        return run_random_mix(iterations, seed, alloc, free_fn);
+        return run_random_mix<Size>(iterations, seed, alloc, free_fn);
     }
 
     std::vector<void*> blocks;
@@ -140,63 +171,128 @@ unsigned long long run_workload(Workload workload,
     for (size_t i = 0; i < iterations; ++i) {
         void* block = alloc();
         do_not_optimize(block);
-        touch_block(block, i);
+        touch_block<Size>(block, i);
         blocks.push_back(block);
     }
     for (void* block : blocks) {
-        checksum += read_block(block);
+        checksum += read_block<Size>(block);
         free_fn(block);
     }
     return checksum;
 }
 
-void run_single_custom(Workload workload, size_t iterations) {
+// Custom pools alive during a run, so a MemorySampler can total their mapped
+// bytes. A pool that leaves keeps counting with its final mapped bytes: it only
+// returns pages because the benchmark destroys it.
+class PoolRegistry {
+public:
+    using Pool = cma::FixedBlockAllocator<kBlockSize>;
+
+    void add(const Pool* pool) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pools.push_back(pool);
+    }
+
+    void remove(const Pool* pool) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_retired_bytes += pool->mapped_bytes();
+        m_pools.erase(std::find(m_pools.begin(), m_pools.end(), pool));
+    }
+
+    size_t mapped_bytes() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t total = m_retired_bytes;
+        for (const Pool* pool : m_pools) {
+            total += pool->mapped_bytes();
+        }
+        return total;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<const Pool*> m_pools;
+    size_t m_retired_bytes = 0;
+};
+
+void run_single_custom(Workload workload,
+                       size_t iterations,
+                       cma::SlowPathStats* slow_path,
+                       PoolRegistry* pools) {
     cma::FixedBlockAllocator<kBlockSize> allocator;
+    if (pools != nullptr) {
+        pools->add(&allocator);
+    }
     const unsigned long long checksum = run_workload(
         workload, iterations, 0U, [&]() { return allocator.allocate(); },
         [&](void* p) { allocator.deallocate(p); });
     g_sink.fetch_add(checksum, std::memory_order_relaxed);
+    if (pools != nullptr) {
+        pools->remove(&allocator);
+    }
+    if (slow_path != nullptr) {
+        *slow_path += allocator.slow_path_stats();
+    }
 }
 
-void run_single_malloc(Workload workload, size_t iterations) {
+void run_single_malloc(Workload workload, size_t iterations, const bench::MallocApi& api) {
     const unsigned long long checksum = run_workload(
-        workload, iterations, 0U, [&]() { return std::malloc(kBlockSize); },
-        [&](void* p) { std::free(p); });
+        workload, iterations, 0U, [&]() { return api.malloc_fn(kBlockSize); },
+        [&](void* p) { api.free_fn(p); });
     g_sink.fetch_add(checksum, std::memory_order_relaxed);
 }
 
-void run_multi_custom(Workload workload, size_t iterations_per_thread, unsigned int thread_count) {
+void run_multi_custom(Workload workload,
+                      size_t iterations_per_thread,
+                      unsigned int thread_count,
+                      cma::SlowPathStats* slow_path,
+                      PoolRegistry* pools) {
     // Each thread owns a private allocator. A fixed-block pool is typically used
     // per-thread/per-subsystem, which lets the design scale without lock
     // contention - the fair counterpart to the process-wide system malloc.
     std::vector<std::thread> threads;
     threads.reserve(thread_count);
+    std::vector<cma::SlowPathStats> per_thread(thread_count);
 
     for (unsigned int t = 0; t < thread_count; ++t) {
-        threads.emplace_back([workload, iterations_per_thread, t]() {
+        threads.emplace_back([workload, iterations_per_thread, t, &per_thread, pools]() {
             cma::FixedBlockAllocator<kBlockSize> allocator;
+            if (pools != nullptr) {
+                pools->add(&allocator);
+            }
             const unsigned long long checksum = run_workload(
                 workload, iterations_per_thread, t, [&]() { return allocator.allocate(); },
                 [&](void* p) { allocator.deallocate(p); });
             allocator.flush_local_thread_cache();
             g_sink.fetch_add(checksum, std::memory_order_relaxed);
+            if (pools != nullptr) {
+                pools->remove(&allocator);
+            }
+            per_thread[t] = allocator.slow_path_stats();
         });
     }
 
     for (std::thread& thread : threads) {
         thread.join();
     }
+    if (slow_path != nullptr) {
+        for (const cma::SlowPathStats& stats : per_thread) {
+            *slow_path += stats;
+        }
+    }
 }
 
-void run_multi_malloc(Workload workload, size_t iterations_per_thread, unsigned int thread_count) {
+void run_multi_malloc(Workload workload,
+                      size_t iterations_per_thread,
+                      unsigned int thread_count,
+                      const bench::MallocApi& api) {
     std::vector<std::thread> threads;
     threads.reserve(thread_count);
 
     for (unsigned int t = 0; t < thread_count; ++t) {
-        threads.emplace_back([workload, iterations_per_thread, t]() {
+        threads.emplace_back([workload, iterations_per_thread, t, &api]() {
             const unsigned long long checksum = run_workload(
-                workload, iterations_per_thread, t, [&]() { return std::malloc(kBlockSize); },
-                [&](void* p) { std::free(p); });
+                workload, iterations_per_thread, t, [&]() { return api.malloc_fn(kBlockSize); },
+                [&](void* p) { api.free_fn(p); });
             g_sink.fetch_add(checksum, std::memory_order_relaxed);
         });
     }
@@ -206,45 +302,431 @@ void run_multi_malloc(Workload workload, size_t iterations_per_thread, unsigned
     }
 }
 
-long long benchmark(bool use_custom,
-                    Threading threading,
-                    Workload workload,
-                    size_t iterations,
-                    unsigned int thread_count) {
+// Starts sampling memory for one run of @p malloc_api (nullptr: the custom
+// pools in @p pools). First hands glibc's free memory back to the OS, so what
+// earlier runs left behind does not hide this run's growth.
+std::unique_ptr<bench::MemorySampler> start_memory_sampler(const bench::MallocApi* malloc_api,
+                                                           const std::function<size_t()>& pool_mapped_bytes) {
+    bench::trim_system_malloc();
+    std::function<size_t()> mapped_bytes = pool_mapped_bytes;
+    if (malloc_api != nullptr) {
+        mapped_bytes = nullptr;
+        if (bench::mapped_bytes_known(*malloc_api)) {
+            mapped_bytes = [malloc_api]() { return bench::mapped_bytes(*malloc_api); };
+        }
+    }
+    return std::make_unique<bench::MemorySampler>(mapped_bytes);
+}
+
+// @p malloc_api selects a malloc/free pair to time (the system allocator or a
+// plugin); nullptr times the custom pool. With @p memory, a sampler thread
+// records RSS, virtual size and mapped bytes during the run.
+long long benchmark_ns(const bench::MallocApi* malloc_api,
+                       Threading threading,
+                       Workload workload,
+                       size_t iterations,
+                       unsigned int thread_count,
+                       cma::SlowPathStats* slow_path = nullptr,
+                       bench::MemoryFootprint* memory = nullptr) {
+    PoolRegistry pool_registry;
+    PoolRegistry* pools = memory != nullptr ? &pool_registry : nullptr;
+    std::unique_ptr<bench::MemorySampler> sampler;
+    if (memory != nullptr) {
+        sampler = start_memory_sampler(malloc_api, [pools]() { return pools->mapped_bytes(); });
+    }
+
+    long long ns = 0;
     if (threading == Threading::Single) {
-        if (use_custom) {
-            return measure_ms([&]() { run_single_custom(workload, iterations); });
+        if (malloc_api == nullptr) {
+            ns = measure_ns([&]() { run_single_custom(workload, iterations, slow_path, pools); });
+        } else {
+            ns = measure_ns([&]() { run_single_malloc(workload, iterations, *malloc_api); });
+        }
+    } else {
+        const size_t iterations_per_thread = iterations / thread_count;
+        if (malloc_api == nullptr) {
+            ns = measure_ns(
+                [&]() { run_multi_custom(workload, iterations_per_thread, thread_count, slow_path, pools); });
+        } else {
+            ns = measure_ns(
+                [&]() { run_multi_malloc(workload, iterations_per_thread, thread_count, *malloc_api); });
         }
-        return measure_ms([&]() { run_single_malloc(workload, iterations); });
     }
 
-    const size_t iterations_per_thread = iterations / thread_count;
-    if (use_custom) {
-        return measure_ms(
-            [&]() { run_multi_custom(workload, iterations_per_thread, thread_count); });
+    if (sampler != nullptr) {
+        *memory = sampler->stop();
     }
-    return measure_ms([&]() { run_multi_malloc(workload, iterations_per_thread, thread_count); });
+    return ns;
+}
+
+long long benchmark(const bench::MallocApi* malloc_api,
+                    Threading threading,
+                    Workload workload,
+                    size_t iterations,
+                    unsigned int thread_count,
+                    cma::SlowPathStats* slow_path = nullptr,
+                    bench::MemoryFootprint* memory = nullptr) {
+    return benchmark_ns(malloc_api, threading, workload, iterations, thread_count, slow_path, memory) / 1'000'000;
 }
 
 // Warms caches/CPU frequency with one untimed run, then reports the median of
 // several timed runs so the comparison is stable and order-independent.
-long long stable_ms(bool use_custom,
+long long stable_ms(const bench::MallocApi* malloc_api,
                     Threading threading,
                     Workload workload,
                     size_t iterations,
                     unsigned int thread_count,
                     int runs = 5) {
-    benchmark(use_custom, threading, workload, iterations, thread_count);
+    benchmark(malloc_api, threading, workload, iterations, thread_count);
 
     std::vector<long long> times;
     times.reserve(runs);
     for (int i = 0; i < runs; ++i) {
-        times.push_back(benchmark(use_custom, threading, workload, iterations, thread_count));
+        times.push_back(benchmark(malloc_api, threading, workload, iterations, thread_count));
     }
     std::sort(times.begin(), times.end());
     return times[times.size() / 2];
 }
 
+// -----------------------------------------------------------------------------
+// Cross-thread handoff: one shared allocator, blocks freed by another thread
+// -----------------------------------------------------------------------------
+
+enum class Handoff {
+    ProducerConsumer,
+    Pipeline,
+    AllToAll,
+};
+
+constexpr Handoff kAllHandoffs[] = {
+    Handoff::ProducerConsumer,
+    Handoff::Pipeline,
+    Handoff::AllToAll,
+};
+
+const char* handoff_name(Handoff handoff) {
+    switch (handoff) {
+    case Handoff::ProducerConsumer:
+        return "producer_consumer";
+    case Handoff::Pipeline:
+        return "pipeline";
+    case Handoff::AllToAll:
+        return "all_to_all";
+    }
+    return "unknown";
+}
+
+std::string handoff_benchmark_type(Handoff handoff) {
+    return std::string("xthread_") + handoff_name(handoff);
+}
+
+// Threads a topology actually runs for a requested thread count.
+unsigned int handoff_thread_count(Handoff handoff, unsigned int threads) {
+    switch (handoff) {
+    case Handoff::ProducerConsumer:
+        return handoff::producer_consumer_pairs(threads) * 2U;
+    case Handoff::Pipeline:
+        return handoff::pipeline_stages(threads);
+    case Handoff::AllToAll:
+        return handoff::all_to_all_threads(threads);
+    }
+    return threads;
+}
+
+// Handoff steps on top of the allocate/deallocate hooks the stress drivers
+// use, so both kinds of workload run on the same shared-pool hooks.
+template <typename Hooks>
+struct HandoffSteps {
+    Hooks& hooks;
+
+    void* produce(size_t i) {
+        void* block = hooks.allocate();
+        do_not_optimize(block);
+        touch_block(block, i);
+        return block;
+    }
+
+    void forward(void* block) {
+        touch_block(block, static_cast<size_t>(read_block(block)));
+    }
+
+    unsigned long long consume(void* block) {
+        const unsigned long long value = read_block(block);
+        hooks.deallocate(block);
+        return value;
+    }
+
+    void thread_done(unsigned long long checksum) {
+        hooks.thread_done(checksum);
+    }
+};
+
+template <typename Hooks>
+void run_handoff(Handoff handoff, size_t handoffs, unsigned int thread_count, Hooks& hooks) {
+    HandoffSteps<Hooks> steps{hooks};
+    switch (handoff) {
+    case Handoff::ProducerConsumer:
+        handoff::run_producer_consumer(handoffs, thread_count, steps);
+        break;
+    case Handoff::Pipeline:
+        handoff::run_pipeline(handoffs, thread_count, steps);
+        break;
+    case Handoff::AllToAll:
+        handoff::run_all_to_all(handoffs, thread_count, steps);
+        break;
+    }
+}
+
+// One handoff scenario for shared_pool_ns(); each handoff counts as one op.
+struct HandoffRun {
+    Handoff handoff;
+    size_t handoffs;
+    unsigned int thread_count;
+
+    template <typename Hooks>
+    void operator()(Hooks& hooks) const {
+        run_handoff(handoff, handoffs, thread_count, hooks);
+    }
+
+    const char* name() const {
+        return handoff_name(handoff);
+    }
+
+    unsigned int threads() const {
+        return handoff_thread_count(handoff, thread_count);
+    }
+
+    size_t operations() const {
+        return handoffs;
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Classic stress tests: Larson, cache-thrash/scratch, threadtest, sh6bench
+// -----------------------------------------------------------------------------
+
+enum class Stress {
+    Larson,
+    CacheThrash,
+    CacheScratch,
+    Threadtest,
+    Sh6bench,
+};
+
+constexpr Stress kAllStresses[] = {
+    Stress::Larson,
+    Stress::CacheThrash,
+    Stress::CacheScratch,
+    Stress::Threadtest,
+    Stress::Sh6bench,
+};
+
+const char* stress_name(Stress stress) {
+    switch (stress) {
+    case Stress::Larson:
+        return "larson";
+    case Stress::CacheThrash:
+        return "cache_thrash";
+    case Stress::CacheScratch:
+        return "cache_scratch";
+    case Stress::Threadtest:
+        return "threadtest";
+    case Stress::Sh6bench:
+        return "sh6bench";
+    }
+    return "unknown";
+}
+
+std::string stress_benchmark_type(Stress stress) {
+    return std::string("stress_") + stress_name(stress);
+}
+
+// Allocations a run of about @p total actually performs.
+size_t stress_allocations(Stress stress, size_t total, unsigned int threads) {
+    switch (stress) {
+    case Stress::Larson:
+        return stress::larson_allocations(total, threads);
+    case Stress::CacheThrash:
+    case Stress::CacheScratch:
+        return stress::cache_allocations(total, threads);
+    case Stress::Threadtest:
+        return stress::threadtest_allocations(total, threads);
+    case Stress::Sh6bench:
+        return stress::sh6bench_allocations(total, threads);
+    }
+    return total;
+}
+
+// Requested bytes live at once: Larson holds every thread's slots, the
+// cache tests one block per thread.
+size_t stress_peak_live_bytes(Stress stress, unsigned int threads) {
+    switch (stress) {
+    case Stress::Larson:
+        return threads * stress::kLarsonSlots * kBlockSize;
+    case Stress::CacheThrash:
+    case Stress::CacheScratch:
+        return threads * kBlockSize;
+    case Stress::Threadtest:
+        return threads * stress::kThreadtestBatch * kBlockSize;
+    case Stress::Sh6bench:
+        return threads * stress::kSh6Batch * kBlockSize;
+    }
+    return 0;
+}
+
+template <typename Hooks>
+void run_stress(Stress stress, size_t total, unsigned int thread_count, Hooks& hooks) {
+    switch (stress) {
+    case Stress::Larson:
+        stress::run_larson(total, thread_count, hooks);
+        break;
+    case Stress::CacheThrash:
+        stress::run_cache_thrash(total, thread_count, hooks);
+        break;
+    case Stress::CacheScratch:
+        stress::run_cache_scratch(total, thread_count, hooks);
+        break;
+    case Stress::Threadtest:
+        stress::run_threadtest(total, thread_count, hooks);
+        break;
+    case Stress::Sh6bench:
+        stress::run_sh6bench(total, thread_count, hooks);
+        break;
+    }
+}
+
+// One stress scenario for shared_pool_ns(); each allocation counts as one op.
+struct StressRun {
+    Stress stress;
+    size_t total;
+    unsigned int thread_count;
+
+    template <typename Hooks>
+    void operator()(Hooks& hooks) const {
+        run_stress(stress, total, thread_count, hooks);
+    }
+
+    const char* name() const {
+        return stress_name(stress);
+    }
+
+    unsigned int threads() const {
+        return thread_count;
+    }
+
+    size_t operations() const {
+        return stress_allocations(stress, total, thread_count);
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Shared-pool runs: handoff and stress scenarios on one allocator
+// -----------------------------------------------------------------------------
+
+// One pool shared by every thread, as a server process would use it, so
+// blocks are often freed into a different thread cache than the one that
+// allocated them.
+struct CustomSharedHooks {
+    cma::FixedBlockAllocator<kBlockSize>& allocator;
+
+    void* allocate() {
+        return allocator.allocate();
+    }
+
+    void deallocate(void* block) {
+        allocator.deallocate(block);
+    }
+
+    void thread_done(unsigned long long checksum) {
+        allocator.flush_local_thread_cache();
+        g_sink.fetch_add(checksum, std::memory_order_relaxed);
+    }
+};
+
+struct MallocSharedHooks {
+    const bench::MallocApi& api;
+
+    void* allocate() {
+        return api.malloc_fn(kBlockSize);
+    }
+
+    void deallocate(void* block) {
+        api.free_fn(block);
+    }
+
+    void thread_done(unsigned long long checksum) {
+        g_sink.fetch_add(checksum, std::memory_order_relaxed);
+    }
+};
+
+// Times @p run (a HandoffRun or StressRun) on a fresh shared pool. Same
+// convention as benchmark_ns(): nullptr times the custom pool.
+template <typename Run>
+long long shared_pool_ns(const bench::MallocApi* malloc_api,
+                         const Run& run,
+                         cma::SlowPathStats* slow_path = nullptr,
+                         bench::MemoryFootprint* memory = nullptr) {
+    if (malloc_api == nullptr) {
+        cma::FixedBlockAllocator<kBlockSize> allocator;
+        CustomSharedHooks hooks{allocator};
+        std::unique_ptr<bench::MemorySampler> sampler;
+        if (memory != nullptr) {
+            sampler = start_memory_sampler(nullptr, [&allocator]() { return allocator.mapped_bytes(); });
+        }
+        const long long ns = measure_ns([&]() { run(hooks); });
+        if (sampler != nullptr) {
+            *memory = sampler->stop();
+        }
+        if (slow_path != nullptr) {
+            *slow_path += allocator.slow_path_stats();
+        }
+        return ns;
+    }
+    MallocSharedHooks hooks{*malloc_api};
+    std::unique_ptr<bench::MemorySampler> sampler;
+    if (memory != nullptr) {
+        sampler = start_memory_sampler(malloc_api, nullptr);
+    }
+    const long long ns = measure_ns([&]() { run(hooks); });
+    if (sampler != nullptr) {
+        *memory = sampler->stop();
+    }
+    return ns;
+}
+
+// One timed run with what was sampled alongside it.
+struct RunResult {
+    long long ns = 0;
+    cma::SlowPathStats slow_path;
+    bench::MemoryFootprint memory;
+};
+
+RunResult median_run(std::vector<RunResult> runs) {
+    std::sort(runs.begin(), runs.end(), [](const RunResult& a, const RunResult& b) { return a.ns < b.ns; });
+    return runs[runs.size() / 2];
+}
+
+// Median of @p runs timed runs after one warmup, with the slow-path counters
+// of the median run. The memory footprint, when @p sample_memory is set, comes
+// from one extra untimed run so the sampler thread and malloc_trim() stay out
+// of the timings.
+template <typename Run>
+RunResult stable_shared_pool_run(const bench::MallocApi* malloc_api,
+                                 const Run& run,
+                                 int runs = 3,
+                                 bool sample_memory = false) {
+    shared_pool_ns(malloc_api, run);
+    std::vector<RunResult> results(runs);
+    for (RunResult& result : results) {
+        result.ns = shared_pool_ns(malloc_api, run, &result.slow_path);
+    }
+    RunResult median = median_run(std::move(results));
+    if (sample_memory) {
+        shared_pool_ns(malloc_api, run, nullptr, &median.memory);
+    }
+    return median;
+}
+
 const char* workload_name(Workload workload) {
     switch (workload) {
     case Workload::Interleaved:
@@ -265,6 +747,33 @@ std::string benchmark_type(Threading threading, Workload workload) {
     return std::string(threading_name(threading)) + "_" + workload_name(workload);
 }
 
+const char* allocator_name(const bench::MallocApi* malloc_api) {
+    return malloc_api == nullptr ? "custom" : malloc_api->name.c_str();
+}
+
+// Installed allocator plugins, after printing which were loaded or skipped.
+const std::vector<bench::MallocApi>& load_plugins_verbose() {
+    std::vector<std::string> skipped;
+    const std::vector<bench::MallocApi>& plugins = bench::allocator_plugins(&skipped);
+    for (const bench::MallocApi& plugin : plugins) {
+        std::cout << "plugin: " << plugin.name << " (" << plugin.library << ")\n";
+    }
+    for (const std::string& reason : skipped) {
+        std::cout << "plugin skipped: " << reason << "\n";
+    }
+    return plugins;
+}
+
+// Every allocator a workload is timed against: the custom pool (nullptr), the
+// system malloc, then each loaded plugin.
+std::vector<const bench::MallocApi*> all_contenders(const std::vector<bench::MallocApi>& plugins) {
+    std::vector<const bench::MallocApi*> contenders = {nullptr, &bench::system_malloc()};
+    for (const bench::MallocApi& plugin : plugins) {
+        contenders.push_back(&plugin);
+    }
+    return contenders;
+}
+
 void print_result_row(const std::string& label, long long custom_ms, long long malloc_ms) {
     const double ratio = malloc_ms > 0 ? static_cast<double>(custom_ms) / malloc_ms : 0.0;
     std::cout << std::left << std::setw(28) << label << " custom: " << std::setw(6) << custom_ms
@@ -272,24 +781,103 @@ void print_result_row(const std::string& label, long long custom_ms, long long m
               << std::setprecision(2) << ratio << "x\n";
 }
 
+// One line per plugin under a scenario row; the ratio is still custom/other.
+void print_plugin_rows(const std::vector<bench::MallocApi>& plugins,
+                       Threading threading,
+                       Workload workload,
+                       size_t iterations,
+                       unsigned int thread_count,
+                       long long custom_ms) {
+    for (const bench::MallocApi& plugin : plugins) {
+        const long long plugin_ms = stable_ms(&plugin, threading, workload, iterations, thread_count);
+        const double ratio = plugin_ms > 0 ? static_cast<double>(custom_ms) / plugin_ms : 0.0;
+        std::cout << std::left << std::setw(28) << ("  vs " + plugin.name) << " " << plugin.name << ": "
+                  << std::setw(6) << plugin_ms << " ms  ratio: " << std::fixed << std::setprecision(2) << ratio
+                  << "x\n";
+    }
+}
+
+// One row per scenario and contender, each on a fresh shared pool.
+template <typename Run>
+void run_shared_pool_section(const std::string& title,
+                             const std::vector<bench::MallocApi>& plugins,
+                             const std::vector<Run>& scenarios) {
+    constexpr bool kCounters = cma::FixedBlockAllocator<kBlockSize>::SLOW_PATH_STATS_ENABLED;
+
+    std::cout << "\n" << title << "\n";
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << std::left << std::setw(20) << "workload" << std::setw(9) << "alloc" << std::right << std::setw(8)
+              << "threads" << std::setw(8) << "ms" << std::setw(9) << "Mops/s" << std::setw(9) << "refills"
+              << std::setw(9) << "flushes" << std::setw(9) << "xfrees" << "\n";
+
+    for (const Run& scenario : scenarios) {
+        for (const bench::MallocApi* api : all_contenders(plugins)) {
+            const RunResult run = stable_shared_pool_run(api, scenario);
+            const cma::SlowPathStats& slow_path = run.slow_path;
+            const double mops =
+                run.ns > 0 ? static_cast<double>(scenario.operations()) * 1e3 / static_cast<double>(run.ns) : 0.0;
+            std::cout << std::left << std::setw(20) << scenario.name() << std::setw(9) << allocator_name(api)
+                      << std::right << std::setw(8) << scenario.threads() << std::setw(8) << run.ns / 1'000'000
+                      << std::setw(9) << std::fixed << std::setprecision(1) << mops;
+            if (api == nullptr && kCounters) {
+                std::cout << std::setw(9)
+                          << slow_path.refills_recycled + slow_path.refills_bump + slow_path.refills_growth
+                          << std::setw(9) << slow_path.flushes << std::setw(9) << slow_path.cross_thread_frees;
+            } else {
+                std::cout << std::setw(9) << "-" << std::setw(9) << "-" << std::setw(9) << "-";
+            }
+            std::cout << "\n";
+        }
+    }
+    if (!kCounters) {
+        std::cout << "(refill/flush/cross-thread free counts need a SLOW_PATH_STATS=1 build)\n";
+    }
+}
+
+void run_handoff_section(const std::vector<bench::MallocApi>& plugins, unsigned int thread_count) {
+    const size_t handoffs = 2'000'000;
+    std::vector<HandoffRun> scenarios;
+    for (Handoff handoff : kAllHandoffs) {
+        scenarios.push_back(HandoffRun{handoff, handoffs, thread_count});
+    }
+    run_shared_pool_section("Cross-thread handoff (one shared allocator, " + std::to_string(handoffs) +
+                                " blocks, each freed by another thread)",
+                            plugins, scenarios);
+}
+
+void run_stress_section(const std::vector<bench::MallocApi>& plugins, unsigned int thread_count) {
+    const size_t total = 2'000'000;
+    std::vector<StressRun> scenarios;
+    for (Stress stress : kAllStresses) {
+        scenarios.push_back(StressRun{stress, total, thread_count});
+    }
+    run_shared_pool_section("Stress tests (one shared allocator, " + std::to_string(thread_count) +
+                                " threads, about " + std::to_string(total) + " allocations)",
+                            plugins, scenarios);
+}
+
 void run_console_benchmark() {
     const size_t single_iterations = 5'000'000;
     const unsigned int thread_count = default_thread_count();
     const size_t multi_iterations = single_iterations;
+    const bench::MallocApi* system = &bench::system_malloc();
 
     std::cout << "\n" << std::string(72, '=') << "\n";
     std::cout << "  Fixed-Size Allocator Benchmark (" << kBlockSize << " bytes)\n";
-    std::cout << std::string(72, '=') << "\n\n";
+    std::cout << std::string(72, '=') << "\n";
+    const std::vector<bench::MallocApi>& plugins = load_plugins_verbose();
+    std::cout << "\n";
 
     std::cout << "Single-thread (" << single_iterations << " operations)\n";
     std::cout << std::string(72, '-') << "\n";
 
     for (Workload workload : kAllWorkloads) {
         const long long custom_ms =
-            stable_ms(true, Threading::Single, workload, single_iterations, 1);
+            stable_ms(nullptr, Threading::Single, workload, single_iterations, 1);
         const long long malloc_ms =
-            stable_ms(false, Threading::Single, workload, single_iterations, 1);
+            stable_ms(system, Threading::Single, workload, single_iterations, 1);
         print_result_row(benchmark_type(Threading::Single, workload), custom_ms, malloc_ms);
+        print_plugin_rows(plugins, Threading::Single, workload, single_iterations, 1, custom_ms);
     }
 
     std::cout << "\nMulti-thread (" << thread_count << " threads, " << multi_iterations
@@ -298,15 +886,96 @@ void run_console_benchmark() {
 
     for (Workload workload : kAllWorkloads) {
         const long long custom_ms =
-            stable_ms(true, Threading::Multi, workload, multi_iterations, thread_count);
+            stable_ms(nullptr, Threading::Multi, workload, multi_iterations, thread_count);
         const long long malloc_ms =
-            stable_ms(false, Threading::Multi, workload, multi_iterations, thread_count);
+            stable_ms(system, Threading::Multi, workload, multi_iterations, thread_count);
         print_result_row(benchmark_type(Threading::Multi, workload), custom_ms, malloc_ms);
+        print_plugin_rows(plugins, Threading::Multi, workload, multi_iterations, thread_count, custom_ms);
     }
 
+    run_handoff_section(plugins, thread_count);
+    run_stress_section(plugins, thread_count);
+
     std::cout << std::string(72, '=') << "\n";
 }
 
+// Slow-path columns of results.csv, taken from the median custom run. They
+// are all zero unless the benchmark was built with SLOW_PATH_STATS=1.
+constexpr const char* kSlowPathCsvHeader =
+    "lock_acquisitions,lock_contended,lock_wait_ns,refills_recycled,refills_bump,refills_growth,"
+    "flushes,pages_mapped,pages_unmapped,mmap_calls,mmap_ns,munmap_calls,munmap_ns,cross_thread_frees";
+
+std::string slow_path_csv(const cma::SlowPathStats& stats) {
+    const uint64_t fields[] = {
+        stats.lock_acquisitions, stats.lock_contended, stats.lock_wait_ns,  stats.refills_recycled,
+        stats.refills_bump,      stats.refills_growth, stats.flushes,       stats.pages_mapped,
+        stats.pages_unmapped,    stats.mmap_calls,     stats.mmap_ns,       stats.munmap_calls,
+        stats.munmap_ns,         stats.cross_thread_frees,
+    };
+    std::string row;
+    for (const uint64_t field : fields) {
+        if (!row.empty()) {
+            row += ',';
+        }
+        row += std::to_string(field);
+    }
+    return row;
+}
+
+// Memory columns of results.csv, from the median run. Ratios are relative to
+// the peak requested bytes (0 when that is unknown, as for handoffs); RSS
+// counts only the growth during the run. Mapped bytes are 0 for allocators
+// that do not expose them.
+constexpr const char* kMemoryCsvHeader =
+    "peak_live_bytes,peak_mapped_bytes,final_mapped_bytes,rss_before,peak_rss,final_rss,peak_vm_bytes,"
+    "mapped_live_ratio,rss_live_ratio";
+
+std::string memory_csv(const bench::MemoryFootprint& memory, size_t peak_live_bytes) {
+    const auto ratio = [peak_live_bytes](size_t bytes) {
+        return peak_live_bytes > 0 ? static_cast<double>(bytes) / static_cast<double>(peak_live_bytes) : 0.0;
+    };
+    std::ostringstream row;
+    row << peak_live_bytes << "," << memory.peak_mapped_bytes << "," << memory.final_mapped_bytes << ","
+        << memory.rss_before << "," << memory.peak_rss << "," << memory.final_rss << ","
+        << memory.peak_virtual_bytes << "," << std::fixed << std::setprecision(3)
+        << (memory.mapped_known ? ratio(memory.peak_mapped_bytes) : 0.0) << "," << ratio(memory.rss_growth());
+    return row.str();
+}
+
+// Most blocks one thread running @p workload holds at once.
+size_t peak_live_blocks(Workload workload, size_t iterations, unsigned int seed) {
+    switch (workload) {
+    case Workload::Interleaved:
+        return iterations > 0 ? 1 : 0;
+    case Workload::Batch:
+        return iterations;
+    case Workload::RandomMix:
+        break;
+    }
+    size_t live = 0;
+    size_t peak = 0;
+    for (size_t op = 0; op < iterations; ++op) {
+        if (workload::random_mix_should_alloc(live, workload::random_mix_salt(op, seed))) {
+            peak = std::max(peak, ++live);
+        } else {
+            --live;
+        }
+    }
+    return peak;
+}
+
+// Requested bytes live at the peak of a run, summing per-thread peaks.
+size_t peak_live_bytes(Threading threading, Workload workload, size_t iterations, unsigned int thread_count) {
+    if (threading == Threading::Single) {
+        return peak_live_blocks(workload, iterations, 0U) * kBlockSize;
+    }
+    size_t blocks = 0;
+    for (unsigned int t = 0; t < thread_count; ++t) {
+        blocks += peak_live_blocks(workload, iterations / thread_count, t);
+    }
+    return blocks * kBlockSize;
+}
+
 void generate_plot_data() {
     const std::vector<size_t> allocation_counts = {
         10000, 50000, 100000, 250000, 500000, 1000000, 2000000,
@@ -315,34 +984,57 @@ void generate_plot_data() {
     const int num_runs_per_test = 3;
 
     std::cout << "--- Generating " << kPlotCsvPath << " ---\n";
+    const std::vector<bench::MallocApi>& plugins = load_plugins_verbose();
 
     std::filesystem::create_directories("dashboard/data");
     std::ofstream file(kPlotCsvPath);
-    file << "allocator_type,benchmark_type,num_allocations,time_ms\n";
+    file << "allocator_type,benchmark_type,num_allocations,time_ms," << kSlowPathCsvHeader << ","
+         << kMemoryCsvHeader << "\n";
 
     for (const size_t count : allocation_counts) {
         for (Threading threading : {Threading::Single, Threading::Multi}) {
             for (Workload workload : kAllWorkloads) {
                 const std::string bench_type = benchmark_type(threading, workload);
                 const unsigned int threads = threading == Threading::Multi ? thread_count : 1U;
+                const size_t live_bytes = peak_live_bytes(threading, workload, count, threads);
 
-                std::vector<long long> system_times;
-                std::vector<long long> custom_times;
-
-                for (int run = 0; run < num_runs_per_test; ++run) {
-                    system_times.push_back(
-                        benchmark(false, threading, workload, count, threads));
-                    custom_times.push_back(benchmark(true, threading, workload, count, threads));
+                // System first, then plugins, then custom. Malloc-style
+                // allocators have no slow-path counters; their columns stay zero.
+                std::vector<const bench::MallocApi*> contenders = all_contenders(plugins);
+                std::rotate(contenders.begin(), contenders.begin() + 1, contenders.end());
+                for (const bench::MallocApi* api : contenders) {
+                    std::vector<RunResult> runs(num_runs_per_test);
+                    for (RunResult& run : runs) {
+                        run.ns = benchmark_ns(api, threading, workload, count, threads, &run.slow_path);
+                    }
+                    // Memory comes from one extra untimed run, as in stable_shared_pool_run().
+                    RunResult median = median_run(std::move(runs));
+                    benchmark_ns(api, threading, workload, count, threads, nullptr, &median.memory);
+                    file << allocator_name(api) << "," << bench_type << "," << count << "," << median.ns / 1'000'000
+                         << "," << slow_path_csv(median.slow_path) << "," << memory_csv(median.memory, live_bytes)
+                         << "\n";
                 }
+            }
+        }
 
-                std::sort(system_times.begin(), system_times.end());
-                std::sort(custom_times.begin(), custom_times.end());
-
-                const long long system_median = system_times[num_runs_per_test / 2];
-                const long long custom_median = custom_times[num_runs_per_test / 2];
+        // Cross-thread rows: the count is the number of blocks handed off.
+        for (Handoff handoff : kAllHandoffs) {
+            for (const bench::MallocApi* api : all_contenders(plugins)) {
+                const RunResult run = stable_shared_pool_run(api, HandoffRun{handoff, count, thread_count}, num_runs_per_test, true);
+                file << allocator_name(api) << "," << handoff_benchmark_type(handoff) << "," << count << ","
+                     << run.ns / 1'000'000 << "," << slow_path_csv(run.slow_path) << ","
+                     << memory_csv(run.memory, 0) << "\n";
+            }
+        }
 
-                file << "system," << bench_type << "," << count << "," << system_median << "\n";
-                file << "custom," << bench_type << "," << count << "," << custom_median << "\n";
+        // Stress rows: the count is the requested allocation total.
+        for (Stress stress : kAllStresses) {
+            const size_t live_bytes = stress_peak_live_bytes(stress, thread_count);
+            for (const bench::MallocApi* api : all_contenders(plugins)) {
+                const RunResult run = stable_shared_pool_run(api, StressRun{stress, count, thread_count}, num_runs_per_test, true);
+                file << allocator_name(api) << "," << stress_benchmark_type(stress) << "," << count << ","
+                     << run.ns / 1'000'000 << "," << slow_path_csv(run.slow_path) << ","
+                     << memory_csv(run.memory, live_bytes) << "\n";
             }
         }
     }
@@ -350,17 +1042,1695 @@ void generate_plot_data() {
     std::cout << "CSV generation complete.\n";
 }
 
-void print_usage(const char* prog_name) {
-    std::cerr << "Usage: " << prog_name << " [command]\n\n"
-              << "Commands:\n"
-              << "  benchmark   Compare custom vs malloc (single and multi-thread).\n"
-              << "  plot        Generate dashboard/data/results.csv for plotting.\n"
-              << "  trace       Sample allocator stats to JSON (see: trace --help via missing args).\n";
+// Touches one cache line in each of the first few blocks of many pages - the
+// access pattern that defeats an uncolored layout, where block i of every
+// 64 KB-aligned page maps to the same cache sets.
+template <size_t BlockSize>
+double colored_walk_ns_per_access(bool cache_coloring, size_t pages, size_t blocks_per_walk) {
+    using Pool = cma::FixedBlockAllocator<BlockSize>;
+    cma::AllocatorOptions options;
+    options.cache_coloring = cache_coloring;
+    Pool allocator(options);
+
+    std::vector<void*> blocks;
+    blocks.reserve(pages * Pool::blocks_per_page());
+    for (size_t i = 0; i < pages * Pool::blocks_per_page(); ++i) {
+        blocks.push_back(allocator.allocate());
+    }
+
+    // Bump allocation hands out each page's blocks in address order, so the
+    // first blocks_per_walk entries of each page-sized run are its lowest slots.
+    std::vector<volatile unsigned char*> walk;
+    walk.reserve(pages * blocks_per_walk);
+    for (size_t slot = 0; slot < blocks_per_walk; ++slot) {
+        for (size_t page = 0; page < pages; ++page) {
+            walk.push_back(static_cast<unsigned char*>(blocks[page * Pool::blocks_per_page() + slot]));
+        }
+    }
+
+    const size_t rounds = 200;
+    unsigned long long checksum = 0;
+    const auto start = Clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (volatile unsigned char* line : walk) {
+            checksum += *line;
+            *line = static_cast<unsigned char>(round);
+        }
+    }
+    const auto end = Clock::now();
+    g_sink.fetch_add(checksum, std::memory_order_relaxed);
+
+    for (void* block : blocks) {
+        allocator.deallocate(block);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / static_cast<double>(rounds * walk.size());
 }
 
-} // namespace
+template <size_t BlockSize>
+void print_coloring_row(size_t pages, size_t blocks_per_walk) {
+    colored_walk_ns_per_access<BlockSize>(false, pages, blocks_per_walk);
+    const double plain = colored_walk_ns_per_access<BlockSize>(false, pages, blocks_per_walk);
+    const double colored = colored_walk_ns_per_access<BlockSize>(true, pages, blocks_per_walk);
+    std::cout << std::left << std::setw(10) << (std::to_string(BlockSize) + " B") << std::setw(8)
+              << cma::FixedBlockAllocator<BlockSize>::color_count() << std::fixed
+              << std::setprecision(2) << std::setw(16) << plain << std::setw(16) << colored
+              << (colored > 0.0 ? plain / colored : 0.0) << "x\n";
+}
 
-int run_benchmark_cli(int argc, char* argv[]) {
+void run_coloring_benchmark() {
+    const size_t pages = 512;
+    const size_t blocks_per_walk = 4;
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Cache coloring: first " << blocks_per_walk << " blocks of " << pages
+              << " pages\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << std::left << std::setw(10) << "block" << std::setw(8) << "colors" << std::setw(16)
+              << "plain ns/acc" << std::setw(16) << "colored ns/acc"
+              << "speedup\n";
+    std::cout << std::string(72, '-') << "\n";
+    print_coloring_row<kBlockSize>(pages, blocks_per_walk);
+    print_coloring_row<1000>(pages, blocks_per_walk);
+    print_coloring_row<1024>(pages, blocks_per_walk);
+    print_coloring_row<4096>(pages, blocks_per_walk);
+    std::cout << std::string(72, '=') << "\n";
+}
+
+struct ListNode {
+    ListNode* next;
+    unsigned long long value;
+};
+
+static_assert(sizeof(ListNode) <= kBlockSize, "ListNode must fit in one block");
+
+struct LocalityResult {
+    double build_ns_per_node = 0.0;
+    double traverse_ns_per_node = 0.0;
+};
+
+// Scrambles the pool by freeing a large working set in pseudo-random order,
+// then builds a linked list from fresh allocations and walks it. The walk is
+// where free-list order shows up: scattered nodes miss cache and TLB.
+LocalityResult measure_locality(bool address_ordered, size_t nodes) {
+    cma::AllocatorOptions options;
+    options.address_ordered = address_ordered;
+    cma::FixedBlockAllocator<kBlockSize> allocator(options);
+
+    std::vector<void*> churn;
+    churn.reserve(nodes);
+    for (size_t i = 0; i < nodes; ++i) {
+        churn.push_back(allocator.allocate());
+    }
+    for (size_t i = nodes; i > 1; --i) {
+        const size_t j = workload::random_mix_salt(i) % i;
+        std::swap(churn[i - 1], churn[j]);
+    }
+    // Pin one block per page so scrambled pages stay mapped instead of being
+    // released and re-carved in order.
+    std::vector<void*> pinned;
+    std::unordered_set<uintptr_t> pinned_pages;
+    for (void* block : churn) {
+        const uintptr_t page = reinterpret_cast<uintptr_t>(block) /
+                               cma::FixedBlockAllocator<kBlockSize>::PAGE_SIZE;
+        if (pinned_pages.insert(page).second) {
+            pinned.push_back(block);
+        } else {
+            allocator.deallocate(block);
+        }
+    }
+    allocator.flush_local_thread_cache();
+
+    const auto build_start = Clock::now();
+    ListNode* head = nullptr;
+    ListNode* tail = nullptr;
+    for (size_t i = 0; i < nodes - pinned.size(); ++i) {
+        auto* node = static_cast<ListNode*>(allocator.allocate());
+        node->next = nullptr;
+        node->value = i;
+        if (tail == nullptr) {
+            head = node;
+        } else {
+            tail->next = node;
+        }
+        tail = node;
+    }
+    const auto build_end = Clock::now();
+
+    const int passes = 10;
+    unsigned long long checksum = 0;
+    const auto walk_start = Clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (ListNode* node = head; node != nullptr; node = node->next) {
+            checksum += node->value;
+        }
+    }
+    const auto walk_end = Clock::now();
+    g_sink.fetch_add(checksum, std::memory_order_relaxed);
+
+    for (ListNode* node = head; node != nullptr;) {
+        ListNode* next = node->next;
+        allocator.deallocate(node);
+        node = next;
+    }
+    for (void* block : pinned) {
+        allocator.deallocate(block);
+    }
+
+    const double built = static_cast<double>(nodes - pinned.size());
+    return LocalityResult{
+        std::chrono::duration<double, std::nano>(build_end - build_start).count() / built,
+        std::chrono::duration<double, std::nano>(walk_end - walk_start).count() / (built * passes)};
+}
+
+void run_locality_benchmark() {
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Free-list order: build a list after scrambled frees, then traverse\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << std::left << std::setw(12) << "nodes" << std::setw(14) << "mode" << std::setw(16)
+              << "build ns/node" << "traverse ns/node\n";
+    std::cout << std::string(72, '-') << "\n";
+
+    for (size_t nodes : {100'000UL, 1'000'000UL, 4'000'000UL}) {
+        for (bool ordered : {false, true}) {
+            measure_locality(ordered, nodes);
+            const LocalityResult result = measure_locality(ordered, nodes);
+            std::cout << std::left << std::setw(12) << nodes << std::setw(14)
+                      << (ordered ? "address" : "lifo") << std::fixed << std::setprecision(2)
+                      << std::setw(16) << result.build_ns_per_node << result.traverse_ns_per_node
+                      << "\n";
+        }
+    }
+    std::cout << std::string(72, '=') << "\n";
+}
+
+// Simulates a traffic spike: fill many pages, free ~97% of the blocks at
+// random (a long-lived survivor pins nearly every page), then compact through
+// a handle table whose slot index lives inside each block.
+void run_compaction_benchmark() {
+    using Pool = cma::FixedBlockAllocator<kBlockSize>;
+    const size_t pages = 1000;
+    const size_t survivors_per_thousand = 30;
+
+    Pool allocator;
+    std::vector<void*> handles;
+    const size_t total = pages * Pool::blocks_per_page();
+    std::vector<void*> blocks;
+    blocks.reserve(total);
+    for (size_t i = 0; i < total; ++i) {
+        blocks.push_back(allocator.allocate());
+    }
+    for (size_t i = 0; i < total; ++i) {
+        if (workload::random_mix_salt(i) % 1000 < survivors_per_thousand) {
+            const size_t slot = handles.size();
+            std::memcpy(blocks[i], &slot, sizeof(slot));
+            handles.push_back(blocks[i]);
+        } else {
+            allocator.deallocate(blocks[i]);
+        }
+    }
+    allocator.flush_local_thread_cache();
+
+    const Pool::Stats before = allocator.stats();
+    const auto sparsest = allocator.sparsest_pages(1);
+
+    allocator.set_relocation_handler([&](void* from, void* to) {
+        size_t slot = 0;
+        std::memcpy(&slot, to, sizeof(slot));
+        if (slot >= handles.size() || handles[slot] != from) {
+            return false;
+        }
+        handles[slot] = to;
+        return true;
+    });
+    Pool::CompactionResult result;
+    const long long elapsed_ms = measure_ms([&]() { result = allocator.compact(0.25); });
+    const Pool::Stats after = allocator.stats();
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Fragment-then-compact (" << pages << " pages, " << handles.size()
+              << " survivors)\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << "sparsest page occupancy : " << std::fixed << std::setprecision(2)
+              << (sparsest.empty() ? 0.0 : sparsest.front().occupancy() * 100.0) << "%\n";
+    std::cout << "pages before / after    : " << before.active_pages << " / " << after.active_pages
+              << "\n";
+    std::cout << "mapped before / after   : " << before.mapped_bytes / 1024 << " KB / "
+              << after.mapped_bytes / 1024 << " KB\n";
+    std::cout << "pages released          : " << result.pages_released << " ("
+              << result.bytes_released / 1024 << " KB)\n";
+    std::cout << "net memory recovered    : "
+              << (before.mapped_bytes - after.mapped_bytes) / 1024 << " KB\n";
+    std::cout << "blocks moved / pinned   : " << result.blocks_moved << " / " << result.blocks_pinned
+              << "\n";
+    std::cout << "compaction time         : " << elapsed_ms << " ms\n";
+    std::cout << std::string(72, '=') << "\n";
+
+    for (void* block : handles) {
+        allocator.deallocate(block);
+    }
+}
+
+// allocate() + first write latency while every thread keeps growing the
+// pool, i.e. each refill eventually needs a fresh page.
+std::vector<long long> growth_latencies_ns(const cma::AllocatorOptions& options, unsigned int threads,
+                                           size_t per_thread) {
+    using Pool = cma::FixedBlockAllocator<kBlockSize>;
+    Pool allocator(options);
+    if (options.background_growth) {
+        // Start from a full ready queue, as a long-running pool would be.
+        while (allocator.ready_page_count() < options.ready_pages) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::vector<std::vector<long long>> samples(threads);
+    std::vector<std::vector<void*>> blocks(threads);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            samples[t].reserve(per_thread);
+            blocks[t].reserve(per_thread);
+            for (size_t i = 0; i < per_thread; ++i) {
+                const auto start = Clock::now();
+                void* block = allocator.allocate();
+                touch_block(block, i);
+                const auto end = Clock::now();
+                samples[t].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                blocks[t].push_back(block);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<long long> merged;
+    for (unsigned int t = 0; t < threads; ++t) {
+        merged.insert(merged.end(), samples[t].begin(), samples[t].end());
+        for (void* block : blocks[t]) {
+            allocator.deallocate(block);
+        }
+    }
+    std::sort(merged.begin(), merged.end());
+    return merged;
+}
+
+long long percentile_ns(const std::vector<long long>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+void run_growth_benchmark() {
+    const unsigned int threads = std::min(4U, default_thread_count());
+    const size_t pages_per_thread = 200;
+    const size_t per_thread = pages_per_thread * cma::FixedBlockAllocator<kBlockSize>::blocks_per_page();
+
+    struct Config {
+        const char* label;
+        bool background;
+        bool prefault;
+    };
+    const Config configs[] = {
+        {"grow under lock", false, false},
+        {"background", true, false},
+        {"background + prefault", true, true},
+    };
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  allocate()+touch latency while growing (" << threads << " threads x " << pages_per_thread
+              << " pages)\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << std::left << std::setw(24) << "Growth" << std::right << std::setw(9) << "p50" << std::setw(9)
+              << "p99" << std::setw(10) << "p99.9" << std::setw(11) << "p99.99" << std::setw(9) << "max"
+              << "  (ns)\n";
+    std::cout << std::string(72, '-') << "\n";
+    for (const Config& config : configs) {
+        cma::AllocatorOptions options;
+        options.background_growth = config.background;
+        options.prefault_ready_pages = config.prefault;
+        options.ready_pages = 8;
+        const std::vector<long long> sorted = growth_latencies_ns(options, threads, per_thread);
+        std::cout << std::left << std::setw(24) << config.label << std::right << std::setw(9)
+                  << percentile_ns(sorted, 0.50) << std::setw(9) << percentile_ns(sorted, 0.99) << std::setw(10)
+                  << percentile_ns(sorted, 0.999) << std::setw(11) << percentile_ns(sorted, 0.9999)
+                  << std::setw(9) << sorted.back() << "\n";
+    }
+    std::cout << std::string(72, '=') << "\n";
+}
+
+struct UnmapContentionResult {
+    std::vector<long long> refill_side_ns;  // sorted allocate() latencies of the observer
+    long long churn_ms = 0;
+};
+
+// Churner threads fill and then free whole pages in waves (each wave ends in a
+// flush that empties many pages at once) while an observer thread keeps
+// cycling blocks through the central pool and times every allocate().
+UnmapContentionResult measure_unmap_contention(bool deferred_unmap) {
+    using Pool = cma::FixedBlockAllocator<kBlockSize>;
+    const unsigned int churners = 3;
+    const size_t waves = 40;
+    const size_t pages_per_wave = 64;
+    const size_t observer_batch = 2 * Pool::HIGH_WATER_MARK;
+
+    cma::AllocatorOptions options;
+    options.deferred_unmap = deferred_unmap;
+    Pool allocator(options);
+    std::atomic<unsigned int> churning{churners};
+    UnmapContentionResult result;
+
+    std::thread observer([&]() {
+        std::vector<void*> blocks(observer_batch);
+        while (churning.load(std::memory_order_acquire) != 0) {
+            for (size_t i = 0; i < observer_batch; ++i) {
+                const auto start = Clock::now();
+                blocks[i] = allocator.allocate();
+                const auto end = Clock::now();
+                result.refill_side_ns.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            }
+            for (void* block : blocks) {
+                allocator.deallocate(block);
+            }
+        }
+        allocator.flush_local_thread_cache();
+    });
+
+    result.churn_ms = measure_ms([&]() {
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < churners; ++t) {
+            threads.emplace_back([&]() {
+                std::vector<void*> blocks;
+                blocks.reserve(pages_per_wave * Pool::blocks_per_page());
+                for (size_t wave = 0; wave < waves; ++wave) {
+                    for (size_t i = 0; i < pages_per_wave * Pool::blocks_per_page(); ++i) {
+                        blocks.push_back(allocator.allocate());
+                    }
+                    for (void* block : blocks) {
+                        allocator.deallocate(block);
+                    }
+                    blocks.clear();
+                    allocator.flush_local_thread_cache();
+                }
+                churning.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+    observer.join();
+    std::sort(result.refill_side_ns.begin(), result.refill_side_ns.end());
+    return result;
+}
+
+void run_unmap_contention_benchmark() {
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Observer allocate() latency while 3 threads free 64-page waves\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << std::left << std::setw(22) << "Unmap" << std::right << std::setw(8) << "p50" << std::setw(9)
+              << "p99" << std::setw(10) << "p99.9" << std::setw(11) << "max" << std::setw(12) << "churn ms"
+              << "\n";
+    std::cout << std::string(72, '-') << "\n";
+    for (bool deferred : {false, true}) {
+        const UnmapContentionResult result = measure_unmap_contention(deferred);
+        const std::vector<long long>& sorted = result.refill_side_ns;
+        std::cout << std::left << std::setw(22) << (deferred ? "deferred + merged" : "under central lock")
+                  << std::right << std::setw(8) << percentile_ns(sorted, 0.50) << std::setw(9)
+                  << percentile_ns(sorted, 0.99) << std::setw(10) << percentile_ns(sorted, 0.999) << std::setw(11)
+                  << (sorted.empty() ? 0 : sorted.back()) << std::setw(12) << result.churn_ms << "\n";
+    }
+    std::cout << "(observer latencies in ns)\n";
+    std::cout << std::string(72, '=') << "\n";
+}
+
+// Median wall time of a single-threaded workload on an allocator built with
+// @p options; the last run's sampled latencies are left in @p latency.
+long long sampled_workload_ms(Workload workload,
+                              size_t iterations,
+                              const cma::AllocatorOptions& options,
+                              cma::LatencyStats& latency) {
+    std::vector<long long> times;
+    for (int run = 0; run < 5; ++run) {
+        cma::FixedBlockAllocator<kBlockSize> allocator(options);
+        times.push_back(measure_ms([&]() {
+            const unsigned long long checksum = run_workload(
+                workload, iterations, 0U, [&]() { return allocator.allocate(); },
+                [&](void* p) { allocator.deallocate(p); });
+            g_sink.fetch_add(checksum, std::memory_order_relaxed);
+        }));
+        latency = allocator.latency_stats();
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void print_latency_row(const char* op, const cma::LatencySummary& summary) {
+    std::cout << "  " << std::left << std::setw(12) << op << std::right << std::setw(9) << summary.count
+              << std::setw(7) << summary.p50 << std::setw(7) << summary.p90 << std::setw(8) << summary.p99
+              << std::setw(9) << summary.p999 << std::setw(11) << summary.max << "\n";
+}
+
+void run_latency_benchmark() {
+    const size_t iterations = 5'000'000;
+    const size_t interval = 1024;
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Sampled latency (1 in " << interval << " calls, " << iterations << " operations, ns)\n";
+    std::cout << std::string(72, '=') << "\n";
+    for (Workload workload : kAllWorkloads) {
+        cma::LatencyStats unused;
+        cma::LatencyStats latency;
+        cma::AllocatorOptions sampled;
+        sampled.latency_sample_interval = interval;
+        const long long off_ms = sampled_workload_ms(workload, iterations, cma::AllocatorOptions{}, unused);
+        const long long on_ms = sampled_workload_ms(workload, iterations, sampled, latency);
+
+        std::cout << workload_name(workload) << ": " << off_ms << " ms unsampled, " << on_ms
+                  << " ms sampled\n";
+        std::cout << "  " << std::left << std::setw(12) << "op" << std::right << std::setw(9) << "samples"
+                  << std::setw(7) << "p50" << std::setw(7) << "p90" << std::setw(8) << "p99" << std::setw(9)
+                  << "p99.9" << std::setw(11) << "max" << "\n";
+        print_latency_row("allocate", latency.allocate);
+        print_latency_row("deallocate", latency.deallocate);
+    }
+    std::cout << std::string(72, '=') << "\n";
+}
+
+// -----------------------------------------------------------------------------
+// Tail latency: every allocate/deallocate timed on a fixed schedule
+// -----------------------------------------------------------------------------
+
+// Nanoseconds per read_cycle_counter() tick, measured against steady_clock.
+double calibrate_ns_per_tick() {
+    const auto wall_start = std::chrono::steady_clock::now();
+    const uint64_t tick_start = cma::read_cycle_counter();
+    while (std::chrono::steady_clock::now() - wall_start < std::chrono::milliseconds(20)) {
+    }
+    const uint64_t ticks = cma::read_cycle_counter() - tick_start;
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_start).count();
+    return ticks > 0 ? ns / static_cast<double>(ticks) : 1.0;
+}
+
+/**
+ * Issues allocator calls on a fixed schedule, one every interval ticks, and
+ * times each call twice. Service time runs from the call's actual start.
+ * Response time runs from the slot the schedule gave it, so when one call
+ * stalls, every call queued behind it is charged for the wait. Timing only
+ * the calls themselves would hide that (coordinated omission). An interval of
+ * 0 issues calls back to back, and response time equals service time.
+ */
+class PacedTimer {
+public:
+    enum Op { Allocate, Deallocate, OpCount };
+
+    struct OpLatency {
+        cma::LatencyHistogram response;
+        cma::LatencyHistogram service;
+    };
+
+    explicit PacedTimer(uint64_t interval_ticks) : m_interval(interval_ticks) {}
+
+    void start() {
+        m_next = cma::read_cycle_counter();
+    }
+
+    template <typename Alloc>
+    void* allocate(Alloc alloc) {
+        const uint64_t intended = wait_for_slot();
+        const uint64_t begin = cma::read_cycle_counter();
+        void* block = alloc();
+        record(m_ops[Allocate], intended, begin);
+        return block;
+    }
+
+    template <typename Free>
+    void deallocate(Free free_fn) {
+        const uint64_t intended = wait_for_slot();
+        const uint64_t begin = cma::read_cycle_counter();
+        free_fn();
+        record(m_ops[Deallocate], intended, begin);
+    }
+
+    const OpLatency& latency(Op op) const {
+        return m_ops[op];
+    }
+
+    // Calls that started more than one interval after their slot.
+    uint64_t late_starts() const {
+        return m_late;
+    }
+
+private:
+    uint64_t wait_for_slot() {
+        uint64_t now = cma::read_cycle_counter();
+        if (m_interval == 0) {
+            return now;
+        }
+        const uint64_t intended = m_next;
+        m_next += m_interval;
+        while (now < intended) {
+            now = cma::read_cycle_counter();
+        }
+        if (now - intended > m_interval) {
+            ++m_late;
+        }
+        return intended;
+    }
+
+    void record(OpLatency& latency, uint64_t intended, uint64_t begin) {
+        const uint64_t end = cma::read_cycle_counter();
+        latency.service.record(end - begin);
+        latency.response.record(end - intended);
+    }
+
+    uint64_t m_interval;
+    uint64_t m_next = 0;
+    uint64_t m_late = 0;
+    OpLatency m_ops[OpCount];
+};
+
+// One paced single-threaded run of @p workload on a fresh custom pool or on
+// @p malloc_api.
+std::unique_ptr<PacedTimer> paced_run(const bench::MallocApi* malloc_api,
+                                      Workload workload,
+                                      size_t iterations,
+                                      uint64_t interval_ticks) {
+    auto timer = std::make_unique<PacedTimer>(interval_ticks);
+    if (malloc_api != nullptr) {
+        const bench::MallocApi& api = *malloc_api;
+        bench::trim_system_malloc();
+        timer->start();
+        g_sink.fetch_add(run_workload(
+                             workload, iterations, 0U,
+                             [&]() { return timer->allocate([&]() { return api.malloc_fn(kBlockSize); }); },
+                             [&](void* p) { timer->deallocate([&]() { api.free_fn(p); }); }),
+                         std::memory_order_relaxed);
+        return timer;
+    }
+    cma::FixedBlockAllocator<kBlockSize> allocator;
+    timer->start();
+    g_sink.fetch_add(run_workload(
+                         workload, iterations, 0U,
+                         [&]() { return timer->allocate([&]() { return allocator.allocate(); }); },
+                         [&](void* p) { timer->deallocate([&]() { allocator.deallocate(p); }); }),
+                     std::memory_order_relaxed);
+    return timer;
+}
+
+void print_tail_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name << " tail [--rate N] [--ops N] [--filter text] [--csv path]\n\n"
+              << "Times every allocate and deallocate of each single-threaded workload with the\n"
+              << "cycle counter, for custom, system malloc and any allocator plugins. Calls are\n"
+              << "issued on a fixed schedule of N per second (default 1000000; 0 runs them back\n"
+              << "to back), and response time is measured from each call's scheduled start, so a\n"
+              << "stall also counts against the calls queued behind it. --ops sets the workload\n"
+              << "size (default 500000). Prints percentiles and writes the full distribution to\n"
+              << kTailCsvPath << ".\n";
+}
+
+int run_tail(int argc, char* argv[]) {
+    double rate = 1'000'000.0;
+    size_t iterations = 500'000;
+    std::string filter;
+    std::string csv_path = kTailCsvPath;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--rate" && i + 1 < argc) {
+            rate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--ops" && i + 1 < argc) {
+            iterations = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            print_tail_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0 || rate < 0.0) {
+        print_tail_usage(argv[0]);
+        return 1;
+    }
+
+    const double ns_per_tick = calibrate_ns_per_tick();
+    const uint64_t interval_ticks = rate > 0.0 ? static_cast<uint64_t>(1e9 / rate / ns_per_tick + 0.5) : 0;
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Tail latency (" << kBlockSize << "-byte blocks, " << iterations << " ops per run, ";
+    if (interval_ticks > 0) {
+        std::cout << std::fixed << std::setprecision(2) << rate / 1e6 << " Mops/s schedule, ns)\n";
+    } else {
+        std::cout << "unpaced, ns)\n";
+    }
+    std::cout << std::string(72, '=') << "\n";
+    const std::vector<bench::MallocApi>& plugins = load_plugins_verbose();
+
+    const std::filesystem::path parent = std::filesystem::path(csv_path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream file(csv_path);
+    file << "allocator,workload,op,kind,count,quantile,latency_ns\n";
+
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << std::left << std::setw(12) << "workload" << std::setw(9) << "alloc" << std::setw(6) << "op"
+              << std::setw(5) << "time" << std::right << std::setw(8) << "p50" << std::setw(9) << "p99"
+              << std::setw(9) << "p99.9" << std::setw(9) << "p99.99" << std::setw(9) << "max" << "\n";
+
+    const auto to_ns = [ns_per_tick](uint64_t ticks) {
+        return static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick + 0.5);
+    };
+    std::vector<std::string> notes;
+    for (Workload workload : kAllWorkloads) {
+        if (!filter.empty() && std::string(workload_name(workload)).find(filter) == std::string::npos) {
+            continue;
+        }
+        for (const bench::MallocApi* api : all_contenders(plugins)) {
+            const std::unique_ptr<PacedTimer> timer = paced_run(api, workload, iterations, interval_ticks);
+            uint64_t calls = 0;
+            for (const PacedTimer::Op op : {PacedTimer::Allocate, PacedTimer::Deallocate}) {
+                const PacedTimer::OpLatency& latency = timer->latency(op);
+                const char* op_name = op == PacedTimer::Allocate ? "alloc" : "free";
+                calls += latency.service.count();
+                for (const bool response : {true, false}) {
+                    if (response && interval_ticks == 0) {
+                        continue;  // unpaced: no schedule, so only service times
+                    }
+                    const cma::LatencyHistogram& histogram = response ? latency.response : latency.service;
+                    const char* kind = response ? "response" : "service";
+                    std::cout << std::left << std::setw(12) << workload_name(workload) << std::setw(9)
+                              << allocator_name(api) << std::setw(6) << op_name << std::setw(5)
+                              << (response ? "resp" : "svc") << std::right << std::setw(8)
+                              << to_ns(histogram.value_at_quantile(0.5)) << std::setw(9)
+                              << to_ns(histogram.value_at_quantile(0.99)) << std::setw(9)
+                              << to_ns(histogram.value_at_quantile(0.999)) << std::setw(9)
+                              << to_ns(histogram.value_at_quantile(0.9999)) << std::setw(9)
+                              << to_ns(histogram.max()) << "\n";
+                    for (const double quantile : bench::hdr_quantile_ticks(histogram.count())) {
+                        file << allocator_name(api) << "," << workload_name(workload) << "," << op_name << ","
+                             << kind << "," << histogram.count() << "," << std::setprecision(12) << quantile << ","
+                             << to_ns(histogram.value_at_quantile(quantile)) << "\n";
+                    }
+                }
+            }
+            const double late = calls > 0 ? 100.0 * static_cast<double>(timer->late_starts()) / calls : 0.0;
+            if (late >= 1.0) {
+                std::ostringstream note;
+                note << allocator_name(api) << " " << workload_name(workload) << ": " << std::fixed
+                     << std::setprecision(1) << late << "% of calls started over one interval late";
+                notes.push_back(note.str());
+            }
+        }
+    }
+    std::cout << std::string(72, '-') << "\n";
+    for (const std::string& note : notes) {
+        std::cout << "note: " << note << "\n";
+    }
+    std::cout << "resp: from the scheduled start; svc: the call alone. Timer overhead is included.\n";
+    std::cout << "wrote " << csv_path << "\n";
+    std::cout << std::string(72, '=') << "\n";
+    return 0;
+}
+
+// Two call sites that keep different amounts live, so the profile has a clear winner.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+void retain_session_objects(cma::FixedBlockAllocator<kBlockSize>& allocator, std::vector<void*>& live, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        live.push_back(allocator.allocate());
+        touch_block(live.back(), i);
+    }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+void retain_cache_entries(cma::FixedBlockAllocator<kBlockSize>& allocator, std::vector<void*>& live, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        live.push_back(allocator.allocate());
+        touch_block(live.back(), i);
+    }
+}
+
+void run_heap_profile_benchmark() {
+    const size_t iterations = 5'000'000;
+    const size_t sample_bytes = 512 * 1024;
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Heap profiler (1 sample per ~" << sample_bytes / 1024 << " KB allocated)\n";
+    std::cout << std::string(72, '=') << "\n";
+    cma::HeapProfiler overhead_profiler(sample_bytes);
+    cma::AllocatorOptions profiled;
+    profiled.heap_profiler = &overhead_profiler;
+    for (Workload workload : kAllWorkloads) {
+        cma::LatencyStats unused;
+        const long long off_ms = sampled_workload_ms(workload, iterations, cma::AllocatorOptions{}, unused);
+        const long long on_ms = sampled_workload_ms(workload, iterations, profiled, unused);
+        std::cout << std::left << std::setw(14) << workload_name(workload) << std::right << std::setw(6) << off_ms
+                  << " ms off " << std::setw(6) << on_ms << " ms profiled\n";
+    }
+
+    cma::HeapProfiler profiler(sample_bytes / 16);
+    cma::AllocatorOptions options;
+    options.heap_profiler = &profiler;
+    cma::FixedBlockAllocator<kBlockSize> allocator(options);
+    std::vector<void*> sessions;
+    std::vector<void*> cache;
+    retain_session_objects(allocator, sessions, 300'000);
+    retain_cache_entries(allocator, cache, 100'000);
+
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << "live: " << (sessions.size() + cache.size()) * kBlockSize << " bytes actual, "
+              << profiler.live_bytes() << " estimated from " << profiler.live_samples() << " samples\n";
+    std::filesystem::create_directories("dashboard/data");
+    std::ofstream folded(kHeapProfileFoldedPath);
+    profiler.write_collapsed(folded);
+    std::ofstream pprof(kHeapProfilePprofPath);
+    profiler.write_pprof(pprof);
+    std::cout << "wrote " << kHeapProfileFoldedPath << " (flamegraph.pl) and " << kHeapProfilePprofPath
+              << " (pprof)\n";
+    std::cout << std::string(72, '=') << "\n";
+    for (void* block : sessions) {
+        allocator.deallocate(block);
+    }
+    for (void* block : cache) {
+        allocator.deallocate(block);
+    }
+}
+
+struct MicrobenchResult {
+    std::string allocator;
+    std::string benchmark;
+    unsigned int threads;
+    bench::Measurement measurement;
+    bench::PerfReading perf;  // one extra repetition of ops_per_rep, with --perf
+};
+
+void print_microbench_usage(const char* prog_name, const char* command) {
+    std::cerr << "Usage: " << prog_name << " " << command
+              << " [--reps N] [--warmup N] [--target-ms T] [--filter text] [--json path]\n"
+              << "                  [--perf]\n\n"
+              << "Times every workload (single/multi x interleaved/batch/random_mix) for custom,\n"
+              << "system malloc and any allocator plugins in ns/op: calibrates ops per repetition to\n"
+              << "~T ms (default 20), runs N warmups (default 2) and N repetitions (default 11), and\n"
+              << "reports median, MAD and a 95% confidence interval. --perf runs one more\n"
+              << "repetition under perf_event_open counters (cycles, instructions, cache and dTLB\n"
+              << "misses, page faults, context switches) and reports them per op. Results and host\n"
+              << "details go to " << kMicrobenchJsonPath << "; baseline writes the same JSON to\n"
+              << kBaselineJsonPath << " for compare.\n";
+}
+
+// Runs body(t) on @p placement.size() threads, each pinned to its CPU set.
+// Timing starts once every thread is running and pinned, and stops when the
+// last one finishes, so thread creation is not measured.
+template <typename Body>
+long long run_placed_threads(const std::vector<std::vector<int>>& placement, bool& pinned, Body body) {
+    const unsigned int thread_count = static_cast<unsigned int>(placement.size());
+    std::atomic<unsigned int> ready{0};
+    std::atomic<unsigned int> pin_failures{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (unsigned int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            if (!bench::pin_current_thread(placement[t])) {
+                pin_failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            ready.fetch_add(1, std::memory_order_release);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            body(t);
+        });
+    }
+    while (ready.load(std::memory_order_acquire) < thread_count) {
+        std::this_thread::yield();
+    }
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const auto end = Clock::now();
+    pinned = pin_failures.load() == 0;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Times one microbenchmark repetition of @p total operations. Unlike
+// benchmark_ns(), the custom pools are built and the worker threads started
+// before the clock starts, so only the workload's op loop is timed.
+long long microbench_ns(const bench::MallocApi* api,
+                        Threading threading,
+                        Workload workload,
+                        size_t total,
+                        unsigned int threads) {
+    const size_t ops_per_thread = total / threads;
+    // One private pool per thread, as in run_multi_custom().
+    std::vector<std::unique_ptr<cma::FixedBlockAllocator<kBlockSize>>> pools;
+    if (api == nullptr) {
+        for (unsigned int t = 0; t < threads; ++t) {
+            pools.push_back(std::make_unique<cma::FixedBlockAllocator<kBlockSize>>());
+        }
+    }
+    const auto body = [&](unsigned int t) {
+        if (api != nullptr) {
+            g_sink.fetch_add(run_workload(workload, ops_per_thread, t, [&]() { return api->malloc_fn(kBlockSize); },
+                                          [&](void* p) { api->free_fn(p); }),
+                             std::memory_order_relaxed);
+            return;
+        }
+        cma::FixedBlockAllocator<kBlockSize>& allocator = *pools[t];
+        g_sink.fetch_add(run_workload(workload, ops_per_thread, t, [&]() { return allocator.allocate(); },
+                                      [&](void* p) { allocator.deallocate(p); }),
+                         std::memory_order_relaxed);
+        allocator.flush_local_thread_cache();
+    };
+    if (threading == Threading::Single) {
+        return measure_ns([&]() { body(0); });
+    }
+    bool pinned = true;
+    return run_placed_threads(bench::plan_pinning(bench::Pinning::None, threads, {}), pinned, body);
+}
+
+// One timed repetition of a microbenchmark: @p ops operations, returning nanoseconds.
+std::function<double(size_t)> microbench_run(const bench::MallocApi* api,
+                                              Threading threading,
+                                              Workload workload,
+                                              unsigned int threads) {
+    return [=](size_t ops) {
+        // Multi-thread runs split ops evenly, so keep them a multiple of the thread count.
+        const size_t total = std::max<size_t>(ops / threads, 1) * threads;
+        return static_cast<double>(microbench_ns(api, threading, workload, total, threads)) *
+               static_cast<double>(ops) / static_cast<double>(total);
+    };
+}
+
+// Per-op count of @p event, or a negative value when it was not counted.
+double perf_per_op(const MicrobenchResult& result, bench::PerfEvent event) {
+    if (!result.perf.has(event) || result.measurement.ops_per_rep == 0) {
+        return -1.0;
+    }
+    return result.perf.value(event) / static_cast<double>(result.measurement.ops_per_rep);
+}
+
+void print_perf_table(const std::vector<MicrobenchResult>& results, const bench::PerfCounters& counters) {
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << "per op" << (counters.user_only() ? " (user space only)" : "") << "\n";
+    for (const std::string& line : counters.unavailable()) {
+        std::cout << "not counted: " << line << "\n";
+    }
+    std::cout << std::left << std::setw(22) << "benchmark" << std::setw(8) << "alloc" << std::right;
+    for (const char* column : {"cycles", "instr", "L1D", "LLC", "dTLB", "faults", "cs"}) {
+        std::cout << std::setw(7) << column;
+    }
+    std::cout << "\n";
+    for (const MicrobenchResult& result : results) {
+        std::cout << std::left << std::setw(22) << result.benchmark << std::setw(8) << result.allocator
+                  << std::right;
+        for (size_t i = 0; i < bench::kPerfEventCount; ++i) {
+            const double value = perf_per_op(result, static_cast<bench::PerfEvent>(i));
+            if (value < 0.0) {
+                std::cout << std::setw(7) << "-";
+            } else {
+                // Cycles and instructions are whole-ish numbers; misses and faults are rare.
+                std::cout << std::fixed << std::setprecision(i < 2 ? 1 : 3) << std::setw(7) << value;
+            }
+        }
+        std::cout << "\n";
+    }
+}
+
+void write_microbench_json(const std::string& path,
+                           const bench::HostInfo& host,
+                           const bench::HarnessConfig& config,
+                           const std::vector<MicrobenchResult>& results,
+                           const bench::PerfCounters* counters) {
+    const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream out(path);
+    out << "{\"host\":";
+    bench::write_host_json(out, host);
+    out << ",\"config\":{\"block_size\":" << kBlockSize << ",\"warmup_runs\":" << config.warmup_runs
+        << ",\"repetitions\":" << config.repetitions << ",\"target_rep_ms\":" << config.target_rep_ms
+        << "}";
+    if (counters != nullptr) {
+        out << ",\"perf\":{\"user_only\":" << (counters->user_only() ? "true" : "false") << ",\"unavailable\":[";
+        for (size_t i = 0; i < counters->unavailable().size(); ++i) {
+            out << (i == 0 ? "" : ",") << bench::json_string(counters->unavailable()[i]);
+        }
+        out << "]}";
+    }
+    out << ",\"unit\":\"ns_per_op\",\"results\":[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const MicrobenchResult& result = results[i];
+        out << (i == 0 ? "" : ",") << "\n{\"allocator\":" << bench::json_string(result.allocator)
+            << ",\"benchmark\":" << bench::json_string(result.benchmark) << ",\"threads\":" << result.threads
+            << ",\"ops_per_rep\":" << result.measurement.ops_per_rep << ",\"summary\":";
+        bench::write_summary_json(out, result.measurement.summary);
+        out << ",\"samples\":[";
+        for (size_t j = 0; j < result.measurement.ns_per_op.size(); ++j) {
+            out << (j == 0 ? "" : ",") << result.measurement.ns_per_op[j];
+        }
+        out << "]";
+        if (counters != nullptr) {
+            out << ",\"perf_per_op\":{";
+            for (size_t i = 0; i < bench::kPerfEventCount; ++i) {
+                const auto event = static_cast<bench::PerfEvent>(i);
+                const double value = perf_per_op(result, event);
+                out << (i == 0 ? "" : ",") << "\"" << bench::perf_event_name(event) << "\":";
+                if (value < 0.0) {
+                    out << "null";
+                } else {
+                    out << value;
+                }
+            }
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+int run_microbench(int argc, char* argv[], const char* default_json_path) {
+    bench::HarnessConfig config;
+    std::string json_path = default_json_path;
+    std::string filter;
+    bool perf = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--perf") {
+            perf = true;
+        } else if (arg == "--reps" && i + 1 < argc) {
+            config.repetitions = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            config.warmup_runs = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--target-ms" && i + 1 < argc) {
+            config.target_rep_ms = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            print_microbench_usage(argv[0], argv[1]);
+            return 1;
+        }
+    }
+    if (config.repetitions == 0 || config.target_rep_ms <= 0.0) {
+        print_microbench_usage(argv[0], argv[1]);
+        return 1;
+    }
+
+    const bench::HostInfo host = bench::detect_host();
+    const unsigned int thread_count = default_thread_count();
+    const std::vector<bench::MallocApi>& plugins = bench::allocator_plugins();
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Microbenchmark (" << kBlockSize << "-byte blocks, ns/op, " << config.repetitions
+              << " reps)\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << "cpu: " << (host.cpu_model.empty() ? "unknown" : host.cpu_model) << ", " << host.logical_cpus
+              << " logical, governor " << (host.governor.empty() ? "n/a" : host.governor) << ", "
+              << std::fixed << std::setprecision(0) << host.current_mhz << "/" << host.max_mhz << " MHz\n";
+    for (const std::string& warning : bench::host_warnings(host)) {
+        std::cout << "warning: " << warning << "\n";
+    }
+    load_plugins_verbose();
+    const std::unique_ptr<bench::PerfCounters> counters = perf ? std::make_unique<bench::PerfCounters>() : nullptr;
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << std::left << std::setw(22) << "benchmark" << std::setw(8) << "alloc" << std::right << std::setw(11)
+              << "ops/rep" << std::setw(9) << "median" << std::setw(8) << "MAD" << std::setw(20) << "95% CI"
+              << "\n";
+
+    std::vector<MicrobenchResult> results;
+    for (Threading threading : {Threading::Single, Threading::Multi}) {
+        const unsigned int threads = threading == Threading::Multi ? thread_count : 1U;
+        for (Workload workload : kAllWorkloads) {
+            const std::string name = benchmark_type(threading, workload);
+            if (!filter.empty() && name.find(filter) == std::string::npos) {
+                continue;
+            }
+            for (const bench::MallocApi* api : all_contenders(plugins)) {
+                const auto run = microbench_run(api, threading, workload, threads);
+                const bench::Measurement measurement = bench::measure(run, config);
+                const bench::Summary& summary = measurement.summary;
+                std::cout << std::left << std::setw(22) << name << std::setw(8) << allocator_name(api)
+                          << std::right << std::setw(11) << measurement.ops_per_rep << std::setprecision(2)
+                          << std::setw(9) << summary.median << std::setw(8) << summary.mad << "   [" << std::setw(6)
+                          << summary.ci_low << ", " << std::setw(6) << summary.ci_high << "]\n";
+                results.push_back(MicrobenchResult{allocator_name(api), name, threads, measurement, {}});
+                if (counters) {
+                    // Worker threads are started inside run(), so the inherited counters cover them.
+                    counters->start();
+                    run(measurement.ops_per_rep);
+                    results.back().perf = counters->stop();
+                }
+            }
+        }
+    }
+    if (counters) {
+        print_perf_table(results, *counters);
+    }
+    write_microbench_json(json_path, host, config, results, counters.get());
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << "wrote " << json_path << "\n";
+    std::cout << std::string(72, '=') << "\n";
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Baseline comparison: re-run a saved microbench JSON and flag regressions
+// -----------------------------------------------------------------------------
+
+void print_compare_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name
+              << " compare [--baseline path] [--threshold pct] [--alpha p] [--filter text] [--json path]\n\n"
+              << "Re-runs every benchmark in the baseline (default " << kBaselineJsonPath << ", written\n"
+              << "by the baseline command) with its op count, warmups and repetitions. A benchmark\n"
+              << "regresses when its median ns/op is more than pct% (default 5) slower and a\n"
+              << "Mann-Whitney U test on the repetitions gives p < alpha (default 0.05). Prints a\n"
+              << "diff table, writes the new run to " << kMicrobenchJsonPath << " (or --json),\n"
+              << "and exits 1 if anything regressed, 2 if the baseline cannot be used, nothing\n"
+              << "was compared, or (without --filter) any entry had to be skipped.\n";
+}
+
+int run_compare(int argc, char* argv[]) {
+    std::string baseline_path = kBaselineJsonPath;
+    std::string json_path = kMicrobenchJsonPath;
+    std::string filter;
+    double threshold_pct = 5.0;
+    double alpha = 0.05;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold_pct = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--alpha" && i + 1 < argc) {
+            alpha = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            print_compare_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (threshold_pct < 0.0 || alpha <= 0.0 || alpha >= 1.0) {
+        print_compare_usage(argv[0]);
+        return 2;
+    }
+
+    std::ifstream baseline_file(baseline_path);
+    if (!baseline_file) {
+        std::cerr << "error: cannot read " << baseline_path << " (create it with: " << argv[0] << " baseline)\n";
+        return 2;
+    }
+    std::ostringstream text;
+    text << baseline_file.rdbuf();
+    bench::JsonValue baseline;
+    std::string error;
+    if (!bench::parse_json(text.str(), baseline, &error)) {
+        std::cerr << "error: " << baseline_path << ": " << error << "\n";
+        return 2;
+    }
+    const bench::JsonValue* baseline_results = baseline.find("results");
+    if (baseline_results == nullptr || baseline_results->type != bench::JsonValue::Type::Array) {
+        std::cerr << "error: " << baseline_path << " has no results array\n";
+        return 2;
+    }
+
+    bench::HarnessConfig config;
+    if (const bench::JsonValue* saved = baseline.find("config")) {
+        config.warmup_runs = static_cast<size_t>(saved->number_or("warmup_runs", 2.0));
+        config.repetitions = static_cast<size_t>(saved->number_or("repetitions", 11.0));
+        config.target_rep_ms = saved->number_or("target_rep_ms", 20.0);
+    }
+    const bench::HostInfo host = bench::detect_host();
+    const bench::JsonValue* saved_host = baseline.find("host");
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Compare with " << baseline_path << " (" << config.repetitions << " reps, regression > "
+              << std::fixed << std::setprecision(1) << threshold_pct << "% at p < " << std::setprecision(3)
+              << alpha << ")\n";
+    std::cout << std::string(72, '=') << "\n";
+    if (saved_host != nullptr) {
+        for (const std::string& difference : bench::host_differences(bench::host_from_json(*saved_host), host)) {
+            std::cout << "warning: host changed, " << difference << "\n";
+        }
+    }
+    for (const std::string& warning : bench::host_warnings(host)) {
+        std::cout << "warning: " << warning << "\n";
+    }
+    const std::vector<bench::MallocApi>& plugins = load_plugins_verbose();
+    const std::vector<const bench::MallocApi*> contenders = all_contenders(plugins);
+
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << std::left << std::setw(20) << "benchmark" << std::setw(9) << "alloc" << std::right << std::setw(9)
+              << "base ns" << std::setw(9) << "now ns" << std::setw(9) << "change" << std::setw(8) << "p"
+              << "  verdict\n";
+
+    std::vector<MicrobenchResult> results;
+    size_t regressions = 0;
+    size_t improvements = 0;
+    size_t skipped = 0;
+    for (const bench::JsonValue& entry : baseline_results->array) {
+        const std::string allocator = entry.string_or("allocator");
+        const std::string benchmark = entry.string_or("benchmark");
+        if (!filter.empty() && benchmark.find(filter) == std::string::npos) {
+            continue;
+        }
+        const auto api = std::find_if(contenders.begin(), contenders.end(), [&](const bench::MallocApi* candidate) {
+            return allocator == allocator_name(candidate);
+        });
+        Threading threading = Threading::Single;
+        Workload workload = Workload::Interleaved;
+        bool known_benchmark = false;
+        for (Threading t : {Threading::Single, Threading::Multi}) {
+            for (Workload w : kAllWorkloads) {
+                if (benchmark_type(t, w) == benchmark) {
+                    threading = t;
+                    workload = w;
+                    known_benchmark = true;
+                }
+            }
+        }
+        std::vector<double> base_samples;
+        if (const bench::JsonValue* samples = entry.find("samples")) {
+            for (const bench::JsonValue& sample : samples->array) {
+                base_samples.push_back(sample.number);
+            }
+        }
+        const size_t ops = static_cast<size_t>(entry.number_or("ops_per_rep"));
+        if (api == contenders.end() || !known_benchmark || base_samples.empty() || ops == 0) {
+            std::cout << std::left << std::setw(20) << benchmark << std::setw(9) << allocator
+                      << "  skipped: " << (api == contenders.end() ? "allocator not loaded" : "unusable entry")
+                      << "\n";
+            ++skipped;
+            continue;
+        }
+
+        const unsigned int threads = std::max(1U, static_cast<unsigned int>(entry.number_or("threads", 1.0)));
+        bench::HarnessConfig rerun = config;
+        rerun.fixed_ops = ops;
+        const bench::Measurement measurement =
+            bench::measure(microbench_run(*api, threading, workload, threads), rerun);
+        results.push_back(MicrobenchResult{allocator, benchmark, threads, measurement, {}});
+
+        const double base_median = bench::summarize(base_samples).median;
+        const double now_median = measurement.summary.median;
+        const double change_pct = base_median > 0.0 ? (now_median - base_median) / base_median * 100.0 : 0.0;
+        const double p = bench::mann_whitney_p(base_samples, measurement.ns_per_op);
+        const bool significant = p < alpha && std::abs(change_pct) > threshold_pct;
+        const char* verdict = !significant ? "same" : change_pct > 0.0 ? "REGRESSION" : "faster";
+        regressions += significant && change_pct > 0.0 ? 1 : 0;
+        improvements += significant && change_pct < 0.0 ? 1 : 0;
+        std::cout << std::left << std::setw(20) << benchmark << std::setw(9) << allocator << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(9) << base_median << std::setw(9) << now_median
+                  << std::showpos << std::setprecision(1) << std::setw(8) << change_pct << "%" << std::noshowpos
+                  << std::setprecision(3) << std::setw(8) << p << "  " << verdict << "\n";
+    }
+    write_microbench_json(json_path, host, config, results, nullptr);
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << results.size() << " compared, " << regressions << " regressed, " << improvements << " faster, "
+              << skipped << " skipped\n";
+    std::cout << "wrote " << json_path << "\n";
+    std::cout << std::string(72, '=') << "\n";
+    // A run that silently checked less than the baseline holds is not a pass.
+    if (results.empty() || (skipped > 0 && filter.empty())) {
+        std::cerr << "error: "
+                  << (results.empty() ? "no baseline entry could be compared" : "baseline entries were skipped")
+                  << "\n";
+        return 2;
+    }
+    return regressions > 0 ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Thread scaling: throughput from one thread to 2x the core count
+// -----------------------------------------------------------------------------
+
+// One line of the scaling sweep. The custom pool runs both as one allocator
+// shared by every thread (each thread still has its own cache in front of the
+// shared central pool) and as a private allocator per thread; malloc-style
+// allocators are process-wide, so they only have the shared form.
+struct ScaleContender {
+    std::string name;
+    const bench::MallocApi* malloc_api;  // nullptr: the custom pool
+    bool shared;
+};
+
+long long scale_ns(const ScaleContender& contender,
+                   Workload workload,
+                   size_t ops_per_thread,
+                   const std::vector<std::vector<int>>& placement,
+                   bool& pinned) {
+    if (contender.malloc_api != nullptr) {
+        const bench::MallocApi& api = *contender.malloc_api;
+        return run_placed_threads(placement, pinned, [&](unsigned int t) {
+            g_sink.fetch_add(run_workload(workload, ops_per_thread, t, [&]() { return api.malloc_fn(kBlockSize); },
+                                          [&](void* p) { api.free_fn(p); }),
+                             std::memory_order_relaxed);
+        });
+    }
+    if (contender.shared) {
+        cma::FixedBlockAllocator<kBlockSize> allocator;
+        return run_placed_threads(placement, pinned, [&](unsigned int t) {
+            g_sink.fetch_add(run_workload(workload, ops_per_thread, t, [&]() { return allocator.allocate(); },
+                                          [&](void* p) { allocator.deallocate(p); }),
+                             std::memory_order_relaxed);
+            allocator.flush_local_thread_cache();
+        });
+    }
+    return run_placed_threads(placement, pinned, [&](unsigned int t) {
+        cma::FixedBlockAllocator<kBlockSize> allocator;
+        g_sink.fetch_add(run_workload(workload, ops_per_thread, t, [&]() { return allocator.allocate(); },
+                                      [&](void* p) { allocator.deallocate(p); }),
+                         std::memory_order_relaxed);
+        allocator.flush_local_thread_cache();
+    });
+}
+
+void print_scale_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name
+              << " scale [--pin none|cores|socket] [--cores N] [--ops N] [--reps N] [--csv path]\n\n"
+              << "Sweeps thread counts 1, 2, 4, ... up to the core count, then the core count and 2x\n"
+              << "oversubscription, running every workload with N operations per thread (default\n"
+              << "1000000) on a shared custom pool, per-thread custom pools, system malloc and any\n"
+              << "allocator plugins. Reports the median of N runs (default 5) as Mops/s. --pin cores\n"
+              << "pins thread t to one CPU, --pin socket keeps all threads on the first socket;\n"
+              << "--cores overrides the number of CPUs the sweep is sized for. Writes\n"
+              << kScalingCsvPath << ".\n";
+}
+
+int run_scale(int argc, char* argv[]) {
+    bench::Pinning pinning = bench::Pinning::None;
+    unsigned int cores_override = 0;
+    size_t ops_per_thread = 1'000'000;
+    int reps = 5;
+    std::string csv_path = kScalingCsvPath;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--pin" && i + 1 < argc) {
+            if (!bench::parse_pinning(argv[++i], pinning)) {
+                print_scale_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--cores" && i + 1 < argc) {
+            cores_override = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--ops" && i + 1 < argc) {
+            ops_per_thread = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--reps" && i + 1 < argc) {
+            reps = std::atoi(argv[++i]);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            print_scale_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (ops_per_thread == 0 || reps <= 0) {
+        print_scale_usage(argv[0]);
+        return 1;
+    }
+
+    const bench::CpuTopology topology = bench::detect_cpu_topology();
+    const std::vector<int> cpus = bench::usable_cpus(topology, pinning);
+    if (pinning != bench::Pinning::None && cpus.empty()) {
+        std::cerr << "warning: CPU affinity is not available here; running unpinned\n";
+        pinning = bench::Pinning::None;
+    }
+    const unsigned int cores = cores_override > 0 ? cores_override
+                               : !cpus.empty()    ? static_cast<unsigned int>(cpus.size())
+                                                  : default_thread_count();
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Thread scaling (" << kBlockSize << "-byte blocks, " << ops_per_thread
+              << " ops per thread, pin " << bench::pinning_name(pinning) << ", " << cores << " cores)\n";
+    std::cout << std::string(72, '=') << "\n";
+    const std::vector<bench::MallocApi>& plugins = load_plugins_verbose();
+
+    std::vector<ScaleContender> contenders = {{"custom", nullptr, true}, {"custom", nullptr, false}};
+    for (const bench::MallocApi* api : all_contenders(plugins)) {
+        if (api != nullptr) {
+            contenders.push_back(ScaleContender{api->name, api, true});
+        }
+    }
+
+    const std::filesystem::path parent = std::filesystem::path(csv_path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream file(csv_path);
+    file << "allocator,sharing,workload,threads,pinning,ops,time_ns,mops_per_sec,mops_per_thread,efficiency\n";
+
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << std::left << std::setw(13) << "workload" << std::setw(9) << "alloc" << std::setw(12) << "sharing"
+              << std::right << std::setw(8) << "threads" << std::setw(10) << "Mops/s" << std::setw(12)
+              << "per thread" << std::setw(11) << "efficiency" << "\n";
+
+    const std::vector<unsigned int> thread_counts = bench::scaling_thread_counts(cores);
+    bool all_pinned = true;
+    for (Workload workload : kAllWorkloads) {
+        for (const ScaleContender& contender : contenders) {
+            const char* sharing = contender.shared ? "shared" : "per_thread";
+            double single_thread_mops = 0.0;
+            for (const unsigned int threads : thread_counts) {
+                const auto placement = bench::plan_pinning(pinning, threads, cpus);
+                bool pinned = true;
+                scale_ns(contender, workload, ops_per_thread, placement, pinned);  // warmup
+                std::vector<long long> times;
+                for (int run = 0; run < reps; ++run) {
+                    times.push_back(scale_ns(contender, workload, ops_per_thread, placement, pinned));
+                    all_pinned = all_pinned && pinned;
+                }
+                std::sort(times.begin(), times.end());
+                const long long ns = std::max(times[times.size() / 2], 1LL);
+                const size_t ops = ops_per_thread * threads;
+                const double mops = static_cast<double>(ops) * 1e3 / static_cast<double>(ns);
+                if (threads == 1) {
+                    single_thread_mops = mops;
+                }
+                // Fraction of linear scaling from the 1-thread run.
+                const double efficiency = single_thread_mops > 0.0 ? mops / (single_thread_mops * threads) : 0.0;
+
+                std::cout << std::left << std::setw(13) << workload_name(workload) << std::setw(9)
+                          << contender.name << std::setw(12) << sharing << std::right << std::setw(8) << threads
+                          << std::fixed << std::setprecision(1) << std::setw(10) << mops << std::setw(12)
+                          << mops / threads << std::setprecision(2) << std::setw(11) << efficiency << "\n";
+                file << contender.name << "," << sharing << "," << workload_name(workload) << "," << threads << ","
+                     << bench::pinning_name(pinning) << "," << ops << "," << ns << "," << mops << ","
+                     << mops / threads << "," << efficiency << "\n";
+            }
+        }
+    }
+    if (!all_pinned) {
+        std::cout << "warning: some threads could not be pinned\n";
+    }
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << "wrote " << csv_path << "\n";
+    std::cout << std::string(72, '=') << "\n";
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Block-size sweep: every workload at each pool size the allocator is used with
+// -----------------------------------------------------------------------------
+
+// Each size instantiates its own FixedBlockAllocator<Size>.
+using SweepBlockSizes = std::index_sequence<8, 16, 24, 32, 48, 64, 128, 256, 512, 1024, 4096>;
+
+// Caps the blocks of one run, so a 4 KB batch holds at most this many bytes.
+constexpr size_t kSweepByteBudget = 128 * 1024 * 1024;
+
+struct SweepConfig {
+    size_t ops = 200'000;
+    int reps = 3;
+    unsigned int thread_count = 1;
+    std::vector<const bench::MallocApi*> contenders;  // nullptr: the custom pool
+};
+
+// How one allocator lays out blocks of one size, from a batch of real blocks.
+struct SweepLayout {
+    size_t blocks_per_page = 0;  // custom pool only
+    double utilization = 0.0;    // requested bytes / bytes consumed (pages, or malloc chunks); 0 if unknown
+    double line_split = 0.0;     // fraction of blocks spanning one more cache line than they need
+};
+
+struct SweepRow {
+    size_t block_size;
+    std::string allocator;
+    std::string benchmark;
+    size_t ops;
+    long long ns;
+    SweepLayout layout;
+};
+
+// True if a block at @p address touches more cache lines than its size needs.
+bool splits_cache_line(const void* address, size_t size) {
+    const uintptr_t start = reinterpret_cast<uintptr_t>(address);
+    const uintptr_t lines = (start + size - 1) / 64 - start / 64 + 1;
+    return lines > (size + 63) / 64;
+}
+
+template <size_t Size>
+SweepLayout sweep_layout(const bench::MallocApi* malloc_api) {
+    const size_t count = kSweepByteBudget / 8 / Size;
+    std::vector<void*> blocks;
+    blocks.reserve(count);
+    SweepLayout layout;
+    size_t mapped = 0;
+    const auto measure = [&](auto alloc) {
+        size_t split = 0;
+        for (size_t i = 0; i < count; ++i) {
+            blocks.push_back(alloc());
+            split += splits_cache_line(blocks.back(), Size) ? 1 : 0;
+        }
+        layout.line_split = static_cast<double>(split) / static_cast<double>(count);
+    };
+    if (malloc_api == nullptr) {
+        using Pool = cma::FixedBlockAllocator<Size>;
+        Pool pool;
+        measure([&]() { return pool.allocate(); });
+        mapped = pool.mapped_bytes();
+        layout.blocks_per_page = Pool::blocks_per_page();
+        for (void* block : blocks) {
+            pool.deallocate(block);
+        }
+    } else {
+        // Chunk bytes rather than arena size: freed arena pages that glibc has
+        // trimmed with madvise still count as arena, so its growth undercounts.
+        const bool known = bench::mapped_bytes_known(*malloc_api);
+        const size_t before = known ? bench::allocated_bytes(*malloc_api) : 0;
+        measure([&]() { return malloc_api->malloc_fn(Size); });
+        const size_t after = known ? bench::allocated_bytes(*malloc_api) : 0;
+        mapped = after > before ? after - before : 0;
+        for (void* block : blocks) {
+            malloc_api->free_fn(block);
+        }
+    }
+    layout.utilization = mapped > 0 ? static_cast<double>(count * Size) / static_cast<double>(mapped) : 0.0;
+    return layout;
+}
+
+// One timed run of @p workload with @p Size-byte blocks. Multi-thread runs
+// give each thread its own pool and split @p iterations evenly, as in plot.
+template <size_t Size>
+long long sweep_ns(const bench::MallocApi* malloc_api,
+                   Threading threading,
+                   Workload workload,
+                   size_t iterations,
+                   unsigned int thread_count) {
+    const unsigned int threads = threading == Threading::Multi ? thread_count : 1U;
+    const auto body = [&](unsigned int t) {
+        const size_t ops = iterations / threads;
+        if (malloc_api != nullptr) {
+            g_sink.fetch_add(run_workload<Size>(workload, ops, t, [&]() { return malloc_api->malloc_fn(Size); },
+                                                [&](void* p) { malloc_api->free_fn(p); }),
+                             std::memory_order_relaxed);
+            return;
+        }
+        cma::FixedBlockAllocator<Size> allocator;
+        g_sink.fetch_add(run_workload<Size>(workload, ops, t, [&]() { return allocator.allocate(); },
+                                            [&](void* p) { allocator.deallocate(p); }),
+                         std::memory_order_relaxed);
+        allocator.flush_local_thread_cache();
+    };
+    if (threading == Threading::Single) {
+        return measure_ns([&]() { body(0); });
+    }
+    bool pinned = true;
+    return run_placed_threads(bench::plan_pinning(bench::Pinning::None, threads, {}), pinned, body);
+}
+
+template <size_t Size>
+void sweep_block_size(const SweepConfig& config, std::vector<SweepRow>& rows) {
+    const size_t iterations = std::min(config.ops, kSweepByteBudget / Size);
+    for (const bench::MallocApi* api : config.contenders) {
+        const SweepLayout layout = sweep_layout<Size>(api);
+        for (Threading threading : {Threading::Single, Threading::Multi}) {
+            const size_t total = std::max<size_t>(iterations / config.thread_count, 1) * config.thread_count;
+            const size_t ops = threading == Threading::Multi ? total : iterations;
+            for (Workload workload : kAllWorkloads) {
+                sweep_ns<Size>(api, threading, workload, ops, config.thread_count);  // warmup
+                std::vector<long long> times;
+                for (int run = 0; run < config.reps; ++run) {
+                    times.push_back(sweep_ns<Size>(api, threading, workload, ops, config.thread_count));
+                }
+                std::sort(times.begin(), times.end());
+                rows.push_back(SweepRow{Size, allocator_name(api), benchmark_type(threading, workload), ops,
+                                        std::max(times[times.size() / 2], 1LL), layout});
+            }
+        }
+    }
+}
+
+template <size_t... Sizes>
+std::vector<SweepRow> sweep_block_sizes(std::index_sequence<Sizes...>, const SweepConfig& config) {
+    std::vector<SweepRow> rows;
+    (sweep_block_size<Sizes>(config, rows), ...);
+    return rows;
+}
+
+double sweep_mops(const SweepRow& row) {
+    return static_cast<double>(row.ops) * 1e3 / static_cast<double>(row.ns);
+}
+
+void print_sizes_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name << " sizes [--ops N] [--reps N] [--csv path]\n\n"
+              << "Runs every workload (single/multi x interleaved/batch/random_mix) with block sizes\n"
+              << "8 to 4096 bytes, each a separate FixedBlockAllocator instantiation, against\n"
+              << "malloc and any allocator plugins at the same size. Each point is the median of\n"
+              << "N runs (default 3) of N operations (default 200000, capped at 128 MB of blocks).\n"
+              << "Also reports blocks per 64 KB page, how much of the mapped memory a large batch\n"
+              << "actually uses, and how many blocks straddle a cache line. Writes\n"
+              << kBlockSizesCsvPath << ".\n";
+}
+
+int run_sizes(int argc, char* argv[]) {
+    SweepConfig config;
+    std::string csv_path = kBlockSizesCsvPath;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--ops" && i + 1 < argc) {
+            config.ops = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--reps" && i + 1 < argc) {
+            config.reps = std::atoi(argv[++i]);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            print_sizes_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.ops == 0 || config.reps <= 0) {
+        print_sizes_usage(argv[0]);
+        return 1;
+    }
+    config.thread_count = default_thread_count();
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Block-size sweep (" << config.ops << " ops, " << config.thread_count
+              << " threads for multi, Mops/s)\n";
+    std::cout << std::string(72, '=') << "\n";
+    config.contenders = all_contenders(load_plugins_verbose());
+    const std::vector<SweepRow> rows = sweep_block_sizes(SweepBlockSizes{}, config);
+
+    const std::filesystem::path parent = std::filesystem::path(csv_path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream file(csv_path);
+    file << "block_size,allocator,benchmark,ops,time_ns,mops_per_sec,blocks_per_page,utilization,line_split\n";
+    for (const SweepRow& row : rows) {
+        file << row.block_size << "," << row.allocator << "," << row.benchmark << "," << row.ops << "," << row.ns
+             << "," << std::fixed << std::setprecision(3) << sweep_mops(row) << "," << row.layout.blocks_per_page
+             << "," << row.layout.utilization << "," << row.layout.line_split << "\n";
+    }
+
+    // Console: one line per size and benchmark, custom against each other allocator.
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << std::right << std::setw(6) << "size" << "  " << std::left << std::setw(20) << "benchmark"
+              << std::right << std::setw(9) << "custom";
+    for (size_t i = 1; i < config.contenders.size(); ++i) {
+        std::cout << std::setw(9) << allocator_name(config.contenders[i]);
+    }
+    std::cout << std::setw(9) << "speedup" << "\n";
+    const size_t per_contender = 2 * std::size(kAllWorkloads);
+    const size_t per_size = per_contender * config.contenders.size();
+    for (size_t base = 0; base + per_size <= rows.size(); base += per_size) {
+        for (size_t b = 0; b < per_contender; ++b) {
+            const SweepRow& custom = rows[base + b];
+            const SweepRow& system = rows[base + per_contender + b];
+            std::cout << std::setw(6) << custom.block_size << "  " << std::left << std::setw(20) << custom.benchmark
+                      << std::right << std::fixed << std::setprecision(1);
+            for (size_t c = 0; c < config.contenders.size(); ++c) {
+                std::cout << std::setw(9) << sweep_mops(rows[base + c * per_contender + b]);
+            }
+            std::cout << std::setprecision(2) << std::setw(8) << sweep_mops(custom) / sweep_mops(system) << "x\n";
+        }
+    }
+
+    std::cout << std::string(72, '-') << "\n";
+    std::cout << std::right << std::setw(6) << "size" << std::setw(12) << "blocks/page" << std::setw(13)
+              << "custom used" << std::setw(13) << "custom split" << std::setw(13) << "malloc used" << std::setw(13)
+              << "malloc split" << "\n";
+    const auto percent = [](double fraction) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(1) << fraction * 100.0 << "%";
+        return text.str();
+    };
+    for (size_t base = 0; base + per_size <= rows.size(); base += per_size) {
+        const SweepLayout& custom = rows[base].layout;
+        const SweepLayout& system = rows[base + per_contender].layout;
+        std::cout << std::setw(6) << rows[base].block_size << std::setw(12) << custom.blocks_per_page
+                  << std::setw(13) << percent(custom.utilization) << std::setw(13) << percent(custom.line_split)
+                  << std::setw(13) << (system.utilization > 0.0 ? percent(system.utilization) : "-")
+                  << std::setw(13) << percent(system.line_split) << "\n";
+    }
+    std::cout << "used: requested bytes over the pages (custom) or chunks (malloc) holding a\n"
+              << kSweepByteBudget / 8 / (1024 * 1024)
+              << " MB batch; split: blocks spanning one more cache line than needed.\n";
+    std::cout << "wrote " << csv_path << "\n";
+    std::cout << std::string(72, '=') << "\n";
+    return 0;
+}
+
+void print_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name << " [command]\n\n"
+              << "Commands:\n"
+              << "  benchmark   Compare custom vs malloc (single and multi-thread).\n"
+              << "  plot        Generate dashboard/data/results.csv for plotting.\n"
+              << "              Both also time any installed jemalloc/tcmalloc/mimalloc, plus\n"
+              << "              CMA_BENCH_PLUGINS=name=path[,...] libraries exporting malloc/free.\n"
+              << "  microbench  ns/op with calibration, repetitions, median/MAD/CI and JSON output;\n"
+              << "              --perf adds per-op hardware counters (perf_event_open).\n"
+              << "  baseline    microbench, saved as the baseline for compare.\n"
+              << "  compare     Re-run the baseline; diff table, U test, exit 1 on regression.\n"
+              << "  scale       Mops/s from 1 thread to 2x cores, shared vs per-thread, optional pinning.\n"
+              << "  sizes       Every workload at block sizes 8..4096 vs malloc, with page utilization.\n"
+              << "  coloring    Walk one block per page across many pages, colored vs not.\n"
+              << "  locality    Build-then-traverse a linked list, LIFO vs address-ordered.\n"
+              << "  compact     Fragment a pool, then compact it through a handle table.\n"
+              << "  growth      allocate() tail latency while growing, with/without background growth.\n"
+              << "  unmap       Refill latency while other threads free pages in waves.\n"
+              << "  latency     Sampled allocate/deallocate percentiles and sampling overhead.\n"
+              << "  tail        Per-call latency percentiles on a fixed schedule (tail --rate N).\n"
+              << "  heapprof    Heap profiler overhead, plus a sample profile in dashboard/data.\n"
+              << "  ipc         Two processes exchange messages via a shared pool vs a socketpair.\n"
+              << "  persist     Restart a file-backed pool vs rebuilding it (persist --mb N).\n"
+              << "  replay      Replay an alloc/free trace on its original threads (replay --trace f).\n"
+              << "  trace       Sample allocator stats to JSON (see: trace --help via missing args).\n";
+}
+
+} // namespace
+
+int run_benchmark_cli(int argc, char* argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "microbench") {
+        return run_microbench(argc, argv, kMicrobenchJsonPath);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "baseline") {
+        return run_microbench(argc, argv, kBaselineJsonPath);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "compare") {
+        return run_compare(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "scale") {
+        return run_scale(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "tail") {
+        return run_tail(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "sizes") {
+        return run_sizes(argc, argv);
+    }
     if (argc != 2) {
         print_usage(argv[0]);
         return 1;
@@ -372,6 +2742,20 @@ int run_benchmark_cli(int argc, char* argv[]) {
         run_console_benchmark();
     } else if (command == "plot") {
         generate_plot_data();
+    } else if (command == "coloring") {
+        run_coloring_benchmark();
+    } else if (command == "locality") {
+        run_locality_benchmark();
+    } else if (command == "compact") {
+        run_compaction_benchmark();
+    } else if (command == "growth") {
+        run_growth_benchmark();
+    } else if (command == "unmap") {
+        run_unmap_contention_benchmark();
+    } else if (command == "latency") {
+        run_latency_benchmark();
+    } else if (command == "heapprof") {
+        run_heap_profile_benchmark();
     } else {
         std::cerr << "Error: Unknown command '" << command << "'\n\n";
         print_usage(argv[0]);
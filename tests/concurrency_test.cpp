@@ -1,10 +1,12 @@
 #include "FixedBlockAllocator.hpp"
 #include "test_helpers.hpp"
+#include "stress_workloads.hpp"
 #include "test_runner.hpp"
 #include "workload_common.hpp"
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <cstring>
@@ -1241,3 +1243,198 @@ TEST(Concurrency_CapacityInvariantUnderParallelAlloc) {
     flush_thread_cache(allocator);
     EXPECT_EQ(allocator.live_block_count(), 0U);
 }
+
+TEST(Concurrency_QuotaBlockWaitsForCrossThreadFree) {
+    cma::AllocatorOptions options;
+    options.byte_limit = Allocator::PAGE_SIZE;
+    options.quota_policy = cma::QuotaPolicy::Block;
+    options.quota_timeout = std::chrono::milliseconds(5000);
+    Allocator allocator(options);
+
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page());
+    PhaseBarrier ready(2);
+
+    std::thread releaser([&]() {
+        ready.arrive_and_wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        deallocate_blocks(allocator, blocks);
+        flush_thread_cache(allocator);
+    });
+
+    ready.arrive_and_wait();
+    void* block = allocator.allocate();
+    EXPECT_NOT_NULL(block);
+    releaser.join();
+
+    allocator.deallocate(block);
+    flush_thread_cache(allocator);
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+}
+
+TEST(Concurrency_QuotaBlockTimesOut) {
+    cma::AllocatorOptions options;
+    options.byte_limit = Allocator::PAGE_SIZE;
+    options.quota_policy = cma::QuotaPolicy::Block;
+    options.quota_timeout = std::chrono::milliseconds(20);
+    Allocator allocator(options);
+
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page());
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_NULL(allocator.allocate());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, options.quota_timeout);
+
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(Concurrency_BackgroundGrowthUnderParallelGrowth) {
+    cma::AllocatorOptions options;
+    options.background_growth = true;
+    options.ready_pages = 2;
+    Allocator allocator(options);
+    const unsigned int thread_count = default_thread_count();
+    const size_t per_thread = 3 * Allocator::blocks_per_page();
+
+    std::vector<std::vector<void*>> per_thread_blocks(thread_count);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&, i]() {
+            per_thread_blocks[i] = allocate_blocks(allocator, per_thread);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<void*> all;
+    for (const auto& blocks : per_thread_blocks) {
+        all.insert(all.end(), blocks.begin(), blocks.end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end());
+    EXPECT_EQ(allocator.live_block_count(), all.size());
+
+    deallocate_blocks(allocator, all);
+    flush_thread_cache(allocator);
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+}
+
+// Larson and cache-scratch free blocks on threads that did not allocate them;
+// every driver must hand each block back exactly once.
+TEST(Concurrency_StressWorkloadsReturnEveryBlock) {
+    struct CountingHooks {
+        Allocator& allocator;
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+
+        void* allocate() {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            return allocator.allocate();
+        }
+
+        void deallocate(void* block) {
+            deallocations.fetch_add(1, std::memory_order_relaxed);
+            allocator.deallocate(block);
+        }
+
+        void thread_done(unsigned long long) {
+            allocator.flush_local_thread_cache();
+        }
+    };
+
+    const unsigned int thread_count = tsan_threads(4);
+    const size_t total = tsan_scale(40000);
+    using Driver = void (*)(size_t, unsigned int, CountingHooks&);
+    const Driver drivers[] = {
+        stress::run_larson<CountingHooks>,       stress::run_cache_thrash<CountingHooks>,
+        stress::run_cache_scratch<CountingHooks>, stress::run_threadtest<CountingHooks>,
+        stress::run_sh6bench<CountingHooks>,
+    };
+    for (const Driver driver : drivers) {
+        Allocator allocator;
+        CountingHooks hooks{allocator};
+        driver(total, thread_count, hooks);
+        EXPECT_TRUE(hooks.allocations.load() >= total / 2);
+        EXPECT_EQ(hooks.deallocations.load(), hooks.allocations.load());
+        EXPECT_EQ(allocator.live_block_count(), 0U);
+        expect_stats_consistent(allocator);
+    }
+}
+
+// Racing frees of one handle: the generation compare-exchange lets exactly one
+// of them through, so the block is never freed twice.
+TEST(Concurrency_RacingHandleFreesFreeOnce) {
+    cma::AllocatorOptions options;
+    options.handle_region_pages = 4;
+    options.handle_generation_bits = 8;
+    Allocator allocator(options);
+    const unsigned int thread_count = tsan_threads(4);
+    const size_t rounds = tsan_scale(200);
+
+    for (size_t round = 0; round < rounds; ++round) {
+        const Allocator::Handle handle = allocator.allocate_handle();
+        PhaseBarrier start(thread_count);
+        std::atomic<unsigned int> successes{0};
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&]() {
+                start.arrive_and_wait();
+                if (allocator.deallocate_handle(handle)) {
+                    successes.fetch_add(1, std::memory_order_relaxed);
+                }
+                flush_thread_cache(allocator);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(successes.load(), 1U);
+    }
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+    expect_stats_consistent(allocator);
+}
+
+// reserve() pages memory in without the central lock; blocks other threads
+// are using meanwhile must keep their contents, and no page may be lost.
+TEST(Concurrency_ReserveWhileOthersAllocate) {
+    Allocator allocator;
+    const unsigned int thread_count = tsan_threads(3);
+    const size_t batch = 256;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> corrupted{0};
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::vector<void*> blocks = allocate_blocks(allocator, batch);
+                for (size_t i = 0; i < blocks.size(); ++i) {
+                    const size_t tag = (static_cast<size_t>(t) << 32U) | i;
+                    std::memcpy(blocks[i], &tag, sizeof(tag));
+                }
+                std::this_thread::yield();
+                for (size_t i = 0; i < blocks.size(); ++i) {
+                    size_t tag = 0;
+                    std::memcpy(&tag, blocks[i], sizeof(tag));
+                    if (tag != ((static_cast<size_t>(t) << 32U) | i)) {
+                        corrupted.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                deallocate_blocks(allocator, blocks);
+            }
+            flush_thread_cache(allocator);
+        });
+    }
+
+    for (size_t pages = 1; pages <= tsan_scale(16); ++pages) {
+        EXPECT_TRUE(allocator.reserve(pages * 4 * Allocator::blocks_per_page()));
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(corrupted.load(), 0U);
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+    EXPECT_TRUE(allocator.active_page_count() >= allocator.reserved_pages());
+    expect_stats_consistent(allocator);
+}
@@ -2,11 +2,24 @@
 #include "test_helpers.hpp"
 #include "test_runner.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <set>
+#include <thread>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+using cma::AllocatorOptions;
+using cma::MemoryBudget;
+using cma::QuotaPolicy;
+
 using cma_test::Allocator;
 using cma_test::allocate_blocks;
 using cma_test::deallocate_blocks;
@@ -282,6 +295,41 @@ TEST(EmptyPage_ShuffledFreeOrderEventuallyReleasesAllPages) {
     EXPECT_EQ(allocator.active_page_count(), 0U);
 }
 
+TEST(EmptyPage_ImmediateAndDeferredUnmapReleaseTheSamePages) {
+    for (bool deferred : {false, true}) {
+        AllocatorOptions options;
+        options.deferred_unmap = deferred;
+        Allocator allocator(options);
+
+        auto blocks = allocate_blocks(allocator, 6 * Allocator::blocks_per_page());
+        const size_t peak_pages = allocator.active_page_count();
+        const auto split = blocks.begin() + Allocator::blocks_per_page();
+        std::vector<void*> survivors(blocks.begin(), split);
+        deallocate_blocks(allocator, std::vector<void*>(split, blocks.end()));
+        allocator.flush_local_thread_cache();
+        EXPECT_LE(allocator.active_page_count(), 2U);
+        EXPECT_GE(peak_pages, 6U);
+        expect_consistent(allocator);
+
+        deallocate_blocks(allocator, survivors);
+        allocator.flush_local_thread_cache();
+        EXPECT_EQ(allocator.active_page_count(), 0U);
+    }
+}
+
+TEST(EmptyPage_DeferredUnmapCreditsSharedBudget) {
+    MemoryBudget budget(8 * Allocator::PAGE_SIZE);
+    AllocatorOptions options;
+    options.shared_budget = &budget;
+    Allocator allocator(options);
+
+    auto blocks = allocate_blocks(allocator, 4 * Allocator::blocks_per_page());
+    EXPECT_GE(budget.used(), 4 * Allocator::PAGE_SIZE);
+    deallocate_blocks(allocator, blocks);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(budget.used(), 0U);
+}
+
 // ---------------------------------------------------------------------------
 // Stats API
 // ---------------------------------------------------------------------------
@@ -548,6 +596,867 @@ TEST(EdgeCase_TwoAllocatorsAreIndependent) {
     EXPECT_EQ(second.active_page_count(), 0U);
 }
 
+// ---------------------------------------------------------------------------
+// Quotas
+// ---------------------------------------------------------------------------
+
+TEST(Quota_ByteLimitCapsMappedPages) {
+    AllocatorOptions options;
+    options.byte_limit = 2 * Allocator::PAGE_SIZE;
+    Allocator allocator(options);
+
+    const size_t capacity = Allocator::blocks_per_page() * 2;
+    auto blocks = allocate_blocks(allocator, capacity);
+    for (void* block : blocks) {
+        EXPECT_NOT_NULL(block);
+    }
+    EXPECT_NULL(allocator.allocate());
+    EXPECT_EQ(allocator.active_page_count(), 2U);
+    EXPECT_LE(allocator.mapped_bytes(), options.byte_limit);
+
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(Quota_FreedBlocksAreReusedUnderLimit) {
+    AllocatorOptions options;
+    options.byte_limit = Allocator::PAGE_SIZE;
+    Allocator allocator(options);
+
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page());
+    EXPECT_NULL(allocator.allocate());
+
+    allocator.deallocate(blocks.back());
+    blocks.pop_back();
+    void* reused = allocator.allocate();
+    EXPECT_NOT_NULL(reused);
+    blocks.push_back(reused);
+
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(Quota_SharedBudgetSpansAllocators) {
+    MemoryBudget budget(3 * Allocator::PAGE_SIZE);
+    AllocatorOptions options;
+    options.shared_budget = &budget;
+
+    Allocator first(options);
+    Allocator second(options);
+    EXPECT_EQ(budget.used(), 2 * Allocator::PAGE_SIZE);
+
+    // One page of headroom left: whichever allocator grows first takes it.
+    auto first_blocks = allocate_blocks(first, Allocator::blocks_per_page() * 2);
+    EXPECT_EQ(budget.used(), 3 * Allocator::PAGE_SIZE);
+    auto second_blocks = allocate_blocks(second, Allocator::blocks_per_page());
+    EXPECT_NULL(second.allocate());
+
+    deallocate_blocks(first, first_blocks);
+    first.flush_local_thread_cache();
+    EXPECT_EQ(budget.used(), Allocator::PAGE_SIZE);
+
+    void* block = second.allocate();
+    EXPECT_NOT_NULL(block);
+    second.deallocate(block);
+    deallocate_blocks(second, second_blocks);
+}
+
+TEST(Quota_CallbackCanShedAndRetry) {
+    std::vector<void*> held;
+    Allocator* target = nullptr;
+    size_t callback_calls = 0;
+
+    AllocatorOptions options;
+    options.byte_limit = Allocator::PAGE_SIZE;
+    options.quota_policy = QuotaPolicy::Callback;
+    options.on_quota_exhausted = [&]() {
+        ++callback_calls;
+        deallocate_blocks(*target, held);
+        held.clear();
+        target->flush_local_thread_cache();
+    };
+    Allocator allocator(options);
+    target = &allocator;
+
+    held = allocate_blocks(allocator, Allocator::blocks_per_page());
+    void* block = allocator.allocate();
+    EXPECT_NOT_NULL(block);
+    EXPECT_EQ(callback_calls, 1U);
+    EXPECT_EQ(allocator.live_block_count(), 1U);
+
+    allocator.deallocate(block);
+}
+
+TEST(Quota_CallbackGivesUpAfterOneRetry) {
+    size_t callback_calls = 0;
+    AllocatorOptions options;
+    options.byte_limit = Allocator::PAGE_SIZE;
+    options.quota_policy = QuotaPolicy::Callback;
+    options.on_quota_exhausted = [&]() { ++callback_calls; };
+    Allocator allocator(options);
+
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page());
+    EXPECT_NULL(allocator.allocate());
+    EXPECT_EQ(callback_calls, 1U);
+
+    deallocate_blocks(allocator, blocks);
+}
+
+// ---------------------------------------------------------------------------
+// Cache coloring
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Lowest block offset within each distinct page, in allocation order.
+std::vector<size_t> first_block_offsets(const std::vector<void*>& blocks, size_t page_size) {
+    std::vector<uintptr_t> pages;
+    std::vector<size_t> offsets;
+    for (void* block : blocks) {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(block);
+        const uintptr_t page = address & ~(static_cast<uintptr_t>(page_size) - 1);
+        const size_t offset = static_cast<size_t>(address - page);
+        size_t i = 0;
+        while (i < pages.size() && pages[i] != page) {
+            ++i;
+        }
+        if (i == pages.size()) {
+            pages.push_back(page);
+            offsets.push_back(offset);
+        } else if (offset < offsets[i]) {
+            offsets[i] = offset;
+        }
+    }
+    return offsets;
+}
+
+} // namespace
+
+TEST(Coloring_EvenlyDividingBlockSizeHasOneColor) {
+    EXPECT_EQ(Allocator::color_count(), 1U);
+    EXPECT_TRUE(cma::FixedBlockAllocator<1024>::color_count() > 1U);
+}
+
+TEST(Coloring_SuccessivePagesStartAtDifferentCacheLines) {
+    using BigAllocator = cma::FixedBlockAllocator<1024>;
+    BigAllocator allocator;
+    const size_t pages = 4;
+    auto blocks = allocate_blocks<1024>(allocator, BigAllocator::blocks_per_page() * pages);
+
+    const std::vector<size_t> offsets = first_block_offsets(blocks, BigAllocator::PAGE_SIZE);
+    EXPECT_EQ(offsets.size(), pages);
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        EXPECT_NE(offsets[i], offsets[i - 1]);
+        EXPECT_EQ((offsets[i] - offsets[0]) % BigAllocator::CACHE_LINE_SIZE, 0U);
+    }
+    for (size_t offset : offsets) {
+        EXPECT_LE(offset + BigAllocator::blocks_per_page() * 1024, BigAllocator::PAGE_SIZE);
+    }
+
+    deallocate_blocks<1024>(allocator, blocks);
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), 0U);
+}
+
+TEST(Coloring_DisabledKeepsIdenticalLayout) {
+    using BigAllocator = cma::FixedBlockAllocator<1024>;
+    AllocatorOptions options;
+    options.cache_coloring = false;
+    BigAllocator allocator(options);
+    auto blocks = allocate_blocks<1024>(allocator, BigAllocator::blocks_per_page() * 3);
+
+    const std::vector<size_t> offsets = first_block_offsets(blocks, BigAllocator::PAGE_SIZE);
+    EXPECT_EQ(offsets.size(), 3U);
+    EXPECT_EQ(offsets[0], offsets[1]);
+    EXPECT_EQ(offsets[1], offsets[2]);
+
+    deallocate_blocks<1024>(allocator, blocks);
+}
+
+// ---------------------------------------------------------------------------
+// Address-ordered free lists
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Frees every block except the first in a scrambled order, flushes, and
+// returns the next batch of allocations (served from the page's free list).
+std::vector<void*> reallocate_after_scrambled_free(Allocator& allocator, std::vector<void*>& blocks) {
+    const size_t count = blocks.size();
+    for (size_t step = 1; step < count; ++step) {
+        allocator.deallocate(blocks[(step * 7919) % (count - 1) + 1]);
+    }
+    allocator.flush_local_thread_cache();
+    return allocate_blocks(allocator, Allocator::REFILL_BATCH);
+}
+
+} // namespace
+
+TEST(AddressOrder_RefillHandsOutAscendingBlocks) {
+    AllocatorOptions options;
+    options.address_ordered = true;
+    Allocator allocator(options);
+
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page());
+    auto reused = reallocate_after_scrambled_free(allocator, blocks);
+    for (size_t i = 1; i < reused.size(); ++i) {
+        EXPECT_TRUE(reused[i - 1] < reused[i]);
+    }
+    EXPECT_EQ(allocator.live_block_count(), 1U + reused.size());
+    expect_consistent(allocator);
+
+    deallocate_blocks(allocator, reused);
+    allocator.deallocate(blocks[0]);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), 0U);
+}
+
+TEST(AddressOrder_DefaultModeKeepsFreeOrder) {
+    Allocator allocator;
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page());
+    auto reused = reallocate_after_scrambled_free(allocator, blocks);
+
+    bool ascending = true;
+    for (size_t i = 1; i < reused.size(); ++i) {
+        ascending = ascending && reused[i - 1] < reused[i];
+    }
+    EXPECT_FALSE(ascending);
+
+    deallocate_blocks(allocator, reused);
+    allocator.deallocate(blocks[0]);
+}
+
+TEST(AddressOrder_ExcessFlushAcrossPagesReleasesEverything) {
+    AllocatorOptions options;
+    options.address_ordered = true;
+    Allocator allocator(options);
+
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page() * 3);
+    for (size_t i = 0; i < blocks.size(); i += 2) {
+        allocator.deallocate(blocks[i]);
+    }
+    for (size_t i = 1; i < blocks.size(); i += 2) {
+        allocator.deallocate(blocks[i]);
+    }
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+    expect_consistent(allocator);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), 0U);
+}
+
+// ---------------------------------------------------------------------------
+// Fragmentation report and compaction
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Keeps every `stride`-th block of `pages` full pages live, as a handle table
+// whose slot index is stored in the block so a relocation can find it.
+std::vector<void*> fragment_pages(Allocator& allocator, size_t pages, size_t stride) {
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page() * pages);
+    std::vector<void*> handles;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (i % stride == 0) {
+            const size_t slot = handles.size();
+            std::memcpy(blocks[i], &slot, sizeof(slot));
+            handles.push_back(blocks[i]);
+        } else {
+            allocator.deallocate(blocks[i]);
+        }
+    }
+    allocator.flush_local_thread_cache();
+    return handles;
+}
+
+} // namespace
+
+TEST(Fragmentation_OccupancyMatchesLiveBlocks) {
+    Allocator allocator;
+    auto handles = fragment_pages(allocator, 3, 10);
+
+    const auto report = allocator.page_occupancy();
+    EXPECT_EQ(report.size(), allocator.active_page_count());
+    size_t live = 0;
+    for (const auto& entry : report) {
+        live += entry.live_blocks;
+        EXPECT_EQ(entry.capacity_blocks, Allocator::blocks_per_page());
+        EXPECT_LE(entry.occupancy(), 1.0);
+    }
+    EXPECT_EQ(live, handles.size());
+
+    deallocate_blocks(allocator, handles);
+}
+
+TEST(Fragmentation_SparsestPagesAreSortedAndSkipEmptyPages) {
+    Allocator allocator;
+    auto dense = allocate_blocks(allocator, Allocator::blocks_per_page());
+    auto sparse = fragment_pages(allocator, 2, 50);
+
+    const auto sparsest = allocator.sparsest_pages(2);
+    EXPECT_EQ(sparsest.size(), 2U);
+    EXPECT_LE(sparsest[0].live_blocks, sparsest[1].live_blocks);
+    for (const auto& entry : sparsest) {
+        EXPECT_TRUE(entry.live_blocks > 0);
+        EXPECT_TRUE(entry.occupancy() < 0.05);
+    }
+
+    deallocate_blocks(allocator, dense);
+    deallocate_blocks(allocator, sparse);
+}
+
+TEST(Compaction_WithoutHandlerIsNoOp) {
+    Allocator allocator;
+    auto handles = fragment_pages(allocator, 3, 20);
+    const size_t pages_before = allocator.active_page_count();
+
+    const auto result = allocator.compact(0.5);
+    EXPECT_EQ(result.blocks_moved, 0U);
+    EXPECT_EQ(allocator.active_page_count(), pages_before);
+
+    deallocate_blocks(allocator, handles);
+}
+
+TEST(Compaction_MovesLiveBlocksAndReleasesSparsePages) {
+    Allocator allocator;
+    auto handles = fragment_pages(allocator, 6, 40);
+    const size_t pages_before = allocator.active_page_count();
+
+    allocator.set_relocation_handler([&](void* from, void* to) {
+        size_t slot = 0;
+        std::memcpy(&slot, to, sizeof(slot));
+        EXPECT_TRUE(handles[slot] == from);
+        handles[slot] = to;
+        return true;
+    });
+    const auto result = allocator.compact(0.25);
+
+    EXPECT_EQ(result.blocks_pinned, 0U);
+    EXPECT_TRUE(result.blocks_moved > 0);
+    EXPECT_TRUE(result.pages_released > 0);
+    EXPECT_EQ(result.bytes_released, result.pages_released * Allocator::PAGE_SIZE);
+    EXPECT_TRUE(allocator.active_page_count() < pages_before);
+    EXPECT_EQ(allocator.live_block_count(), handles.size());
+    for (size_t slot = 0; slot < handles.size(); ++slot) {
+        size_t stored = 0;
+        std::memcpy(&stored, handles[slot], sizeof(stored));
+        EXPECT_EQ(stored, slot);
+    }
+    expect_consistent(allocator);
+
+    deallocate_blocks(allocator, handles);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), 0U);
+}
+
+TEST(Compaction_DeclinedRelocationKeepsPageMapped) {
+    Allocator allocator;
+    auto handles = fragment_pages(allocator, 3, 100);
+    const size_t pages_before = allocator.active_page_count();
+
+    allocator.set_relocation_handler([](void*, void*) { return false; });
+    const auto result = allocator.compact(0.5);
+
+    EXPECT_EQ(result.blocks_moved, 0U);
+    EXPECT_TRUE(result.blocks_pinned > 0);
+    EXPECT_EQ(result.pages_released, 0U);
+    EXPECT_EQ(allocator.active_page_count(), pages_before);
+    EXPECT_EQ(allocator.live_block_count(), handles.size());
+
+    deallocate_blocks(allocator, handles);
+}
+
+// Freeing the blocks being moved is a caller error, but it must only cost the
+// compaction: the emptied pages stay mapped until compact() is done with them.
+TEST(Compaction_FreeDuringEvacuationDefersPageRelease) {
+    Allocator allocator;
+    auto handles = fragment_pages(allocator, 3, 100);
+
+    allocator.set_relocation_handler([&](void* from, void*) {
+        allocator.deallocate(from);
+        allocator.flush_local_thread_cache();
+        return false;
+    });
+    const auto result = allocator.compact(0.5);
+
+    EXPECT_TRUE(result.pages_evacuated > 0);
+    EXPECT_EQ(result.blocks_moved, 0U);
+    EXPECT_EQ(result.pages_released, result.pages_evacuated);
+    EXPECT_EQ(allocator.live_block_count(), handles.size() - result.blocks_pinned);
+    expect_consistent(allocator);
+}
+
+// ---------------------------------------------------------------------------
+// 32-bit handles
+// ---------------------------------------------------------------------------
+
+namespace {
+
+AllocatorOptions handle_options(size_t region_pages, unsigned int generation_bits = 0) {
+    AllocatorOptions options;
+    options.handle_region_pages = region_pages;
+    options.handle_generation_bits = generation_bits;
+    return options;
+}
+
+} // namespace
+
+TEST(Handle_DisabledByDefault) {
+    Allocator allocator;
+    EXPECT_FALSE(allocator.handles_enabled());
+    EXPECT_EQ(allocator.allocate_handle(), Allocator::INVALID_HANDLE);
+    EXPECT_NULL(allocator.resolve_checked(0));
+}
+
+TEST(Handle_RoundTripsThroughResolve) {
+    Allocator allocator(handle_options(16));
+    EXPECT_TRUE(allocator.handles_enabled());
+
+    std::vector<Allocator::Handle> handles;
+    for (size_t i = 0; i < Allocator::blocks_per_page() * 3; ++i) {
+        const Allocator::Handle handle = allocator.allocate_handle();
+        EXPECT_NE(handle, Allocator::INVALID_HANDLE);
+        void* block = allocator.resolve(handle);
+        EXPECT_TRUE(block == allocator.resolve_checked(handle));
+        EXPECT_EQ(allocator.handle_of(block), handle);
+        std::memcpy(block, &i, sizeof(i));
+        handles.push_back(handle);
+    }
+    EXPECT_EQ(std::set<Allocator::Handle>(handles.begin(), handles.end()).size(), handles.size());
+
+    for (size_t i = 0; i < handles.size(); ++i) {
+        size_t stored = 0;
+        std::memcpy(&stored, allocator.resolve(handles[i]), sizeof(stored));
+        EXPECT_EQ(stored, i);
+        EXPECT_TRUE(allocator.deallocate_handle(handles[i]));
+    }
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), 0U);
+}
+
+TEST(Handle_PointerFromOutsideRegionHasNoHandle) {
+    Allocator allocator(handle_options(4));
+    int local = 0;
+    EXPECT_EQ(allocator.handle_of(&local), Allocator::INVALID_HANDLE);
+}
+
+TEST(Handle_TailAndInteriorPointersHaveNoHandle) {
+    // 48-byte blocks leave a tail after the last slot of each page.
+    using TailAllocator = cma::FixedBlockAllocator<48>;
+    TailAllocator allocator(handle_options(2, 4));
+    auto blocks = allocate_blocks<48>(allocator, TailAllocator::blocks_per_page());
+    char* last = static_cast<char*>(*std::max_element(blocks.begin(), blocks.end()));
+    EXPECT_NE(allocator.handle_of(last), TailAllocator::INVALID_HANDLE);
+
+    EXPECT_EQ(allocator.handle_of(last + 1), TailAllocator::INVALID_HANDLE);
+    EXPECT_EQ(allocator.handle_of(last + 47), TailAllocator::INVALID_HANDLE);
+    const uintptr_t tail = reinterpret_cast<uintptr_t>(last) + 48;
+    EXPECT_EQ(tail / TailAllocator::PAGE_SIZE, reinterpret_cast<uintptr_t>(last) / TailAllocator::PAGE_SIZE);
+    EXPECT_EQ(allocator.handle_of(reinterpret_cast<void*>(tail)), TailAllocator::INVALID_HANDLE);
+    deallocate_blocks<48>(allocator, blocks);
+}
+
+TEST(Handle_RegionCapacityBoundsGrowth) {
+    Allocator allocator(handle_options(2));
+    EXPECT_EQ(allocator.handle_region_page_capacity(), 2U);
+
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page() * 2);
+    EXPECT_EQ(allocator.allocate_handle(), Allocator::INVALID_HANDLE);
+    EXPECT_EQ(allocator.active_page_count(), 2U);
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(Handle_ReleasedPageIndexIsReused) {
+    Allocator allocator(handle_options(2));
+    auto blocks = allocate_blocks(allocator, Allocator::blocks_per_page() * 2);
+    deallocate_blocks(allocator, blocks);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), 0U);
+
+    // Both indices were returned, so the region can be filled again.
+    blocks = allocate_blocks(allocator, Allocator::blocks_per_page() * 2);
+    for (void* block : blocks) {
+        EXPECT_NOT_NULL(block);
+        EXPECT_NE(allocator.handle_of(block), Allocator::INVALID_HANDLE);
+    }
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(Handle_GenerationRejectsStaleHandles) {
+    Allocator allocator(handle_options(4, 4));
+    const Allocator::Handle first = allocator.allocate_handle();
+    EXPECT_NOT_NULL(allocator.resolve_checked(first));
+    EXPECT_TRUE(allocator.deallocate_handle(first));
+
+    EXPECT_NULL(allocator.resolve_checked(first));
+    EXPECT_FALSE(allocator.deallocate_handle(first));
+
+    // LIFO reuse hands back the same slot under a new generation.
+    const Allocator::Handle second = allocator.allocate_handle();
+    EXPECT_TRUE(allocator.resolve(second) == allocator.resolve(first));
+    EXPECT_NE(second, first);
+    EXPECT_NULL(allocator.resolve_checked(first));
+    EXPECT_NOT_NULL(allocator.resolve_checked(second));
+    EXPECT_TRUE(allocator.deallocate_handle(second));
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+}
+
+TEST(Handle_PlainDeallocateAgesGeneration) {
+    Allocator allocator(handle_options(4, 4));
+    const Allocator::Handle handle = allocator.allocate_handle();
+    allocator.deallocate(allocator.resolve(handle));
+
+    EXPECT_NULL(allocator.resolve_checked(handle));
+    EXPECT_FALSE(allocator.deallocate_handle(handle));
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+}
+
+// ---------------------------------------------------------------------------
+// Reservation
+// ---------------------------------------------------------------------------
+
+TEST(Reserve_GrowsPoolToCoverRequest) {
+    Allocator allocator;
+    EXPECT_TRUE(allocator.reserve(10 * Allocator::blocks_per_page()));
+    EXPECT_GE(allocator.active_page_count(), 10U);
+    EXPECT_EQ(allocator.reserved_pages(), allocator.active_page_count());
+
+    // Already covered: no further growth.
+    const size_t pages = allocator.active_page_count();
+    EXPECT_TRUE(allocator.reserve(Allocator::blocks_per_page()));
+    EXPECT_EQ(allocator.active_page_count(), pages);
+}
+
+TEST(Reserve_ReservedPagesSurviveFullDrain) {
+    Allocator allocator;
+    allocator.reserve(4 * Allocator::blocks_per_page());
+    const size_t reserved = allocator.reserved_pages();
+
+    auto blocks = allocate_blocks(allocator, 4 * Allocator::blocks_per_page());
+    deallocate_blocks(allocator, blocks);
+    allocator.flush_local_thread_cache();
+
+    EXPECT_EQ(allocator.active_page_count(), reserved);
+    EXPECT_EQ(allocator.live_block_count(), 0U);
+    expect_consistent(allocator);
+}
+
+TEST(Reserve_PagesBeyondReservationAreStillReleased) {
+    Allocator allocator;
+    allocator.reserve(2 * Allocator::blocks_per_page());
+    const size_t reserved = allocator.reserved_pages();
+
+    auto blocks = allocate_blocks(allocator, (reserved + 3) * Allocator::blocks_per_page());
+    EXPECT_GE(allocator.active_page_count(), reserved + 3);
+    deallocate_blocks(allocator, blocks);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), reserved);
+}
+
+#if defined(__linux__)
+namespace {
+
+// VmLck from /proc/self/status: bytes the process holds mlocked.
+size_t locked_bytes() {
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+    char line[256];
+    unsigned long long kb = 0;
+    while (std::fgets(line, sizeof(line), status) != nullptr) {
+        if (std::sscanf(line, "VmLck: %llu kB", &kb) == 1) {
+            break;
+        }
+    }
+    std::fclose(status);
+    return static_cast<size_t>(kb) * 1024;
+}
+
+std::set<uintptr_t> pages_of(const std::vector<void*>& blocks) {
+    std::set<uintptr_t> pages;
+    for (void* block : blocks) {
+        pages.insert(reinterpret_cast<uintptr_t>(block) & ~(static_cast<uintptr_t>(Allocator::PAGE_ALIGNMENT) - 1));
+    }
+    return pages;
+}
+
+} // namespace
+
+// Pages grown on the refill path are mlocked once the central lock is
+// dropped, and munlocked again when they are released.
+TEST(LockPages_GrownPagesAreLockedAfterRefill) {
+    AllocatorOptions options;
+    options.lock_pages = true;
+    Allocator allocator(options);
+    const size_t before = locked_bytes();
+
+    auto blocks = allocate_blocks(allocator, 3 * Allocator::blocks_per_page());
+    const size_t grown = allocator.active_page_count() - 1;
+    EXPECT_GE(grown, 2U);
+    if (locked_bytes() == before) {
+        deallocate_blocks(allocator, blocks);
+        return;  // RLIMIT_MEMLOCK too small to test locking here
+    }
+    EXPECT_EQ(locked_bytes(), before + grown * Allocator::PAGE_SIZE);
+
+    deallocate_blocks(allocator, blocks);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(locked_bytes(), before - Allocator::PAGE_SIZE);
+}
+
+// Reserved pages that empty while pages beyond the reservation are still
+// live are kept, so the prefaulted, mlocked pages are the ones that remain.
+TEST(Reserve_ReservedPagesStayMappedAndLockedWhenTheyEmptyFirst) {
+    AllocatorOptions options;
+    options.lock_pages = true;
+    Allocator allocator(options);
+    if (!allocator.reserve(4 * Allocator::blocks_per_page())) {
+        return;  // RLIMIT_MEMLOCK too small to test locking here
+    }
+    const size_t reserved = allocator.reserved_pages();
+    const size_t locked = locked_bytes();
+
+    auto reserved_blocks = allocate_blocks(allocator, reserved * Allocator::blocks_per_page());
+    EXPECT_EQ(allocator.active_page_count(), reserved);
+    const std::set<uintptr_t> reserved_pages = pages_of(reserved_blocks);
+    auto overflow = allocate_blocks(allocator, 3 * Allocator::blocks_per_page());
+    EXPECT_EQ(allocator.active_page_count(), reserved + 3);
+
+    deallocate_blocks(allocator, reserved_blocks);
+    allocator.flush_local_thread_cache();
+    deallocate_blocks(allocator, overflow);
+    allocator.flush_local_thread_cache();
+    EXPECT_EQ(allocator.active_page_count(), reserved);
+    EXPECT_EQ(locked_bytes(), locked);
+
+    // The reservation is served from the same pages, without growing.
+    reserved_blocks = allocate_blocks(allocator, reserved * Allocator::blocks_per_page());
+    EXPECT_TRUE(pages_of(reserved_blocks) == reserved_pages);
+    EXPECT_EQ(allocator.active_page_count(), reserved);
+    deallocate_blocks(allocator, reserved_blocks);
+}
+#endif
+
+#if !defined(_WIN32)
+namespace {
+
+long minor_faults() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+// Allocates and writes one block per slot of @p blocks, then frees them all.
+// The vector is sized (and so already touched) by the caller.
+void touch_round(Allocator& allocator, std::vector<void*>& blocks) {
+    for (void*& block : blocks) {
+        block = allocator.allocate();
+        std::memset(block, 0x5A, kBlockSize);
+    }
+    for (void* block : blocks) {
+        allocator.deallocate(block);
+    }
+}
+
+} // namespace
+
+#ifndef CMA_TSAN_BUILD
+// TSan's shadow memory faults on first touch too, swamping the count.
+TEST(Reserve_FirstTouchIsPrefaulted) {
+    const size_t count = 32 * Allocator::blocks_per_page();
+    Allocator allocator;
+    allocator.reserve(count);
+    std::vector<void*> blocks(count);
+
+    const long before = minor_faults();
+    touch_round(allocator, blocks);
+    const long faults = minor_faults() - before;
+    // Lazily faulted, this round would take one fault per 4 KB of blocks.
+    EXPECT_LE(faults, static_cast<long>(count * kBlockSize / 4096 / 4));
+}
+#endif
+
+TEST(Reserve_SteadyStateAllocationHasNoMinorFaults) {
+    const size_t count = 32 * Allocator::blocks_per_page();
+    Allocator allocator;
+    allocator.reserve(count);
+    std::vector<void*> blocks(count);
+    touch_round(allocator, blocks);  // thread cache setup
+
+    const long before = minor_faults();
+    for (int round = 0; round < 5; ++round) {
+        touch_round(allocator, blocks);
+    }
+    EXPECT_EQ(minor_faults() - before, 0L);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Background growth
+// ---------------------------------------------------------------------------
+
+namespace {
+
+AllocatorOptions background_options(size_t ready_pages) {
+    AllocatorOptions options;
+    options.background_growth = true;
+    options.ready_pages = ready_pages;
+    options.prefault_ready_pages = true;
+    return options;
+}
+
+// The growth thread runs on its own schedule; give it a bounded time to catch up.
+bool wait_for_ready_pages(const Allocator& allocator, size_t count) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (allocator.ready_page_count() != count) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(BackgroundGrowth_ReadyQueueFillsAndRefills) {
+    Allocator allocator(background_options(3));
+    EXPECT_TRUE(wait_for_ready_pages(allocator, 3));
+    EXPECT_EQ(allocator.active_page_count(), 1U);
+
+    // Three more pages come from the queue, which is then topped up again.
+    auto blocks = allocate_blocks(allocator, 4 * Allocator::blocks_per_page());
+    EXPECT_EQ(allocator.active_page_count(), 4U);
+    EXPECT_TRUE(wait_for_ready_pages(allocator, 3));
+
+    std::set<void*> unique(blocks.begin(), blocks.end());
+    EXPECT_EQ(unique.size(), blocks.size());
+    expect_consistent(allocator);
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(BackgroundGrowth_ReadyPagesCountAgainstByteLimit) {
+    AllocatorOptions options = background_options(4);
+    options.byte_limit = 3 * Allocator::PAGE_SIZE;
+    Allocator allocator(options);
+    EXPECT_TRUE(wait_for_ready_pages(allocator, 2));
+
+    auto blocks = allocate_blocks(allocator, 3 * Allocator::blocks_per_page());
+    EXPECT_NULL(allocator.allocate());
+    EXPECT_EQ(allocator.active_page_count(), 3U);
+    EXPECT_EQ(allocator.ready_page_count(), 0U);
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(BackgroundGrowth_IgnoredInHandleMode) {
+    AllocatorOptions options = background_options(2);
+    options.handle_region_pages = 8;
+    Allocator allocator(options);
+    auto blocks = allocate_blocks(allocator, 2 * Allocator::blocks_per_page());
+    EXPECT_EQ(allocator.ready_page_count(), 0U);
+    deallocate_blocks(allocator, blocks);
+}
+
+// ---------------------------------------------------------------------------
+// Slow-path stats (counters are only live in CMA_SLOW_PATH_STATS builds)
+// ---------------------------------------------------------------------------
+
+TEST(SlowPathStats_CountRefillSourcesFlushesAndPages) {
+    Allocator allocator;
+    // Frees past the high-water mark go to the central pool, so the second
+    // round refills from recycled blocks; the final flush releases every page.
+    for (int round = 0; round < 2; ++round) {
+        auto blocks = allocate_blocks(allocator, 3 * Allocator::blocks_per_page());
+        deallocate_blocks(allocator, blocks);
+    }
+    allocator.flush_local_thread_cache();
+
+    const cma::SlowPathStats stats = allocator.slow_path_stats();
+    if (!Allocator::SLOW_PATH_STATS_ENABLED) {
+        EXPECT_EQ(stats.lock_acquisitions, 0U);
+        EXPECT_EQ(stats.refills_bump, 0U);
+        EXPECT_EQ(stats.pages_mapped, 0U);
+        return;
+    }
+    EXPECT_GE(stats.refills_bump, 1U);
+    EXPECT_GE(stats.refills_growth, 2U);
+    EXPECT_GE(stats.refills_recycled, 1U);
+    EXPECT_GE(stats.flushes, 2U);
+    EXPECT_EQ(stats.lock_acquisitions,
+              stats.refills_bump + stats.refills_growth + stats.refills_recycled + stats.flushes);
+    EXPECT_EQ(stats.lock_contended, 0U);
+    EXPECT_EQ(stats.mmap_calls, stats.pages_mapped);
+    EXPECT_EQ(stats.pages_unmapped, stats.pages_mapped);
+    EXPECT_GE(stats.munmap_calls, 1U);
+    EXPECT_LE(stats.munmap_calls, stats.pages_unmapped);
+    EXPECT_EQ(stats.cross_thread_frees, 0U);
+}
+
+TEST(SlowPathStats_CountCrossThreadFreesOnFlush) {
+    Allocator allocator;
+    auto blocks = allocate_blocks(allocator, 100);
+    std::thread other([&]() {
+        deallocate_blocks(allocator, blocks);
+        allocator.flush_local_thread_cache();
+    });
+    other.join();
+    EXPECT_EQ(allocator.slow_path_stats().cross_thread_frees, Allocator::SLOW_PATH_STATS_ENABLED ? 100U : 0U);
+}
+
+// ---------------------------------------------------------------------------
+// Sampled latency histograms
+// ---------------------------------------------------------------------------
+
+TEST(Latency_DisabledByDefault) {
+    Allocator allocator;
+    auto blocks = allocate_blocks(allocator, 5000);
+    deallocate_blocks(allocator, blocks);
+    const cma::LatencyStats stats = allocator.latency_stats();
+    EXPECT_EQ(stats.allocate.count, 0U);
+    EXPECT_EQ(stats.deallocate.count, 0U);
+}
+
+TEST(Latency_SamplesEveryNthCallAndMergesThreads) {
+    AllocatorOptions options;
+    options.latency_sample_interval = 4;
+    Allocator allocator(options);
+    auto blocks = allocate_blocks(allocator, 400);
+    deallocate_blocks(allocator, blocks);
+    std::thread other([&]() {
+        auto mine = allocate_blocks(allocator, 200);
+        deallocate_blocks(allocator, mine);
+        allocator.flush_local_thread_cache();
+    });
+    other.join();
+
+    const cma::LatencyStats stats = allocator.latency_stats();
+    EXPECT_EQ(stats.allocate.count, 150U);
+    EXPECT_EQ(stats.deallocate.count, 150U);
+    EXPECT_LE(stats.allocate.p50, stats.allocate.p90);
+    EXPECT_LE(stats.allocate.p99, stats.allocate.p999);
+    EXPECT_LE(stats.allocate.p999, stats.allocate.max);
+    EXPECT_TRUE(stats.allocate.max > 0);
+}
+
+// Exited threads hand their slot to the next thread; their samples stay counted.
+TEST(Latency_ThreadChurnKeepsExitedSamples) {
+    AllocatorOptions options;
+    options.latency_sample_interval = 4;
+    Allocator allocator(options);
+    for (int round = 0; round < 20; ++round) {
+        std::thread worker([&]() {
+            auto mine = allocate_blocks(allocator, 40);
+            deallocate_blocks(allocator, mine);
+            allocator.flush_local_thread_cache();
+        });
+        worker.join();
+    }
+
+    const cma::LatencyStats stats = allocator.latency_stats();
+    EXPECT_EQ(stats.allocate.count, 200U);
+    EXPECT_EQ(stats.deallocate.count, 200U);
+}
+
 // ---------------------------------------------------------------------------
 // Template / block-size variants
 // ---------------------------------------------------------------------------
@@ -570,3 +1479,43 @@ TEST(Template_BlockSize64_AllocateAndFree) {
 TEST(Template_DifferentBlockSizesHaveDifferentBlocksPerPage) {
     EXPECT_NE(cma::FixedBlockAllocator<8>::blocks_per_page(), cma::FixedBlockAllocator<64>::blocks_per_page());
 }
+
+namespace {
+
+// Blocks are as aligned as max_align_t allows for their size: every colored
+// page, the uncolored layout and the handle region alike.
+template <size_t BlockSize>
+void expect_blocks_aligned(const AllocatorOptions& options) {
+    using SizedAllocator = cma::FixedBlockAllocator<BlockSize>;
+    const size_t expected = std::min<size_t>(alignof(std::max_align_t), BlockSize & (~BlockSize + 1));
+    SizedAllocator allocator(options);
+    const size_t count = SizedAllocator::blocks_per_page() * 3;
+    auto blocks = allocate_blocks<BlockSize>(allocator, count);
+    size_t misaligned = 0;
+    for (void* block : blocks) {
+        misaligned += reinterpret_cast<uintptr_t>(block) % expected != 0 ? 1 : 0;
+    }
+    EXPECT_EQ(misaligned, 0U);
+    deallocate_blocks<BlockSize>(allocator, blocks);
+}
+
+template <size_t BlockSize>
+void expect_blocks_aligned_in_every_layout() {
+    AllocatorOptions options;
+    expect_blocks_aligned<BlockSize>(options);
+    options.cache_coloring = false;
+    expect_blocks_aligned<BlockSize>(options);
+    options.cache_coloring = true;
+    options.handle_region_pages = 8;
+    expect_blocks_aligned<BlockSize>(options);
+}
+
+} // namespace
+
+TEST(Template_BlocksAreMaxAligned) {
+    expect_blocks_aligned_in_every_layout<16>();
+    expect_blocks_aligned_in_every_layout<32>();
+    expect_blocks_aligned_in_every_layout<48>();
+    expect_blocks_aligned_in_every_layout<64>();
+    expect_blocks_aligned_in_every_layout<1024>();
+}
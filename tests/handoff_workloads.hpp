@@ -0,0 +1,219 @@
+#pragma once
+
+// Cross-thread workloads: blocks are allocated on one thread and freed on
+// another, passed along single-producer/single-consumer rings. The topology
+// code is allocator-agnostic; a Hooks object supplies the per-block work:
+//
+//   void* produce(size_t i);                 allocate and fill block i
+//   void forward(void* block);               intermediate pipeline stage
+//   unsigned long long consume(void* block); read and free
+//   void thread_done(unsigned long long checksum);
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace handoff {
+
+constexpr size_t kRingCapacity = 256;
+
+// Bounded SPSC ring of block pointers. Head and tail live on separate cache
+// lines so the two sides only share a line when they touch the same slot.
+class Ring {
+public:
+    bool push(void* block) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == kRingCapacity) {
+            return false;
+        }
+        m_slots[tail % kRingCapacity] = block;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(void*& block) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        block = m_slots[head % kRingCapacity];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) void* m_slots[kRingCapacity] = {};
+};
+
+// Waiting side of a full or empty ring. Yielding (rather than pure spinning)
+// keeps the workloads live when there are more threads than cores.
+inline void backoff() {
+    std::this_thread::yield();
+}
+
+inline void push_blocking(Ring& ring, void* block) {
+    while (!ring.push(block)) {
+        backoff();
+    }
+}
+
+inline void* pop_blocking(Ring& ring) {
+    void* block = nullptr;
+    while (!ring.pop(block)) {
+        backoff();
+    }
+    return block;
+}
+
+inline std::vector<std::unique_ptr<Ring>> make_rings(size_t count) {
+    std::vector<std::unique_ptr<Ring>> rings;
+    rings.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        rings.push_back(std::make_unique<Ring>());
+    }
+    return rings;
+}
+
+// Threads used by each topology for a requested count (every topology needs
+// at least two threads to hand anything off).
+inline unsigned int producer_consumer_pairs(unsigned int threads) {
+    return std::max(1U, threads / 2U);
+}
+
+inline unsigned int pipeline_stages(unsigned int threads) {
+    return std::max(2U, threads);
+}
+
+inline unsigned int all_to_all_threads(unsigned int threads) {
+    return std::max(2U, threads);
+}
+
+// threads/2 producer->consumer pairs, each moving total/pairs blocks.
+template <typename Hooks>
+void run_producer_consumer(size_t total, unsigned int threads, Hooks& hooks) {
+    const unsigned int pairs = producer_consumer_pairs(threads);
+    const size_t per_pair = total / pairs;
+    std::vector<std::unique_ptr<Ring>> rings = make_rings(pairs);
+    std::vector<std::thread> workers;
+    workers.reserve(pairs * 2U);
+
+    for (unsigned int p = 0; p < pairs; ++p) {
+        Ring& ring = *rings[p];
+        workers.emplace_back([&hooks, &ring, per_pair]() {
+            for (size_t i = 0; i < per_pair; ++i) {
+                push_blocking(ring, hooks.produce(i));
+            }
+            hooks.thread_done(0);
+        });
+        workers.emplace_back([&hooks, &ring, per_pair]() {
+            unsigned long long checksum = 0;
+            for (size_t i = 0; i < per_pair; ++i) {
+                checksum += hooks.consume(pop_blocking(ring));
+            }
+            hooks.thread_done(checksum);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// A chain of stages: the first allocates, the middle ones touch each block
+// and pass it on, the last frees.
+template <typename Hooks>
+void run_pipeline(size_t total, unsigned int threads, Hooks& hooks) {
+    const unsigned int stages = pipeline_stages(threads);
+    std::vector<std::unique_ptr<Ring>> rings = make_rings(stages - 1U);
+    std::vector<std::thread> workers;
+    workers.reserve(stages);
+
+    workers.emplace_back([&hooks, &rings, total]() {
+        for (size_t i = 0; i < total; ++i) {
+            push_blocking(*rings[0], hooks.produce(i));
+        }
+        hooks.thread_done(0);
+    });
+    for (unsigned int stage = 1; stage + 1U < stages; ++stage) {
+        workers.emplace_back([&hooks, &rings, stage, total]() {
+            for (size_t i = 0; i < total; ++i) {
+                void* block = pop_blocking(*rings[stage - 1U]);
+                hooks.forward(block);
+                push_blocking(*rings[stage], block);
+            }
+            hooks.thread_done(0);
+        });
+    }
+    workers.emplace_back([&hooks, &rings, stages, total]() {
+        unsigned long long checksum = 0;
+        for (size_t i = 0; i < total; ++i) {
+            checksum += hooks.consume(pop_blocking(*rings[stages - 2U]));
+        }
+        hooks.thread_done(checksum);
+    });
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Every thread allocates total/threads blocks, sends them round-robin to all
+// other threads, and frees whatever it receives. A thread whose outgoing ring
+// is full drains its own inbox while it waits, so no cycle of full rings can
+// stall.
+template <typename Hooks>
+void run_all_to_all(size_t total, unsigned int threads, Hooks& hooks) {
+    const unsigned int count = all_to_all_threads(threads);
+    const size_t per_thread = total / count;
+    const size_t expected = per_thread * count;
+    // rings[from * count + to]; the diagonal is unused.
+    std::vector<std::unique_ptr<Ring>> rings = make_rings(static_cast<size_t>(count) * count);
+    std::atomic<size_t> freed{0};
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+
+    for (unsigned int self = 0; self < count; ++self) {
+        workers.emplace_back([&, self]() {
+            unsigned long long checksum = 0;
+            auto drain = [&]() {
+                size_t drained = 0;
+                for (unsigned int from = 0; from < count; ++from) {
+                    void* block = nullptr;
+                    while (from != self && rings[static_cast<size_t>(from) * count + self]->pop(block)) {
+                        checksum += hooks.consume(block);
+                        ++drained;
+                    }
+                }
+                if (drained != 0) {
+                    freed.fetch_add(drained, std::memory_order_relaxed);
+                }
+                return drained;
+            };
+
+            for (size_t i = 0; i < per_thread; ++i) {
+                const unsigned int to = (self + 1U + static_cast<unsigned int>(i % (count - 1U))) % count;
+                void* block = hooks.produce(i);
+                Ring& ring = *rings[static_cast<size_t>(self) * count + to];
+                while (!ring.push(block)) {
+                    if (drain() == 0) {
+                        backoff();
+                    }
+                }
+            }
+            while (freed.load(std::memory_order_relaxed) < expected) {
+                if (drain() == 0) {
+                    backoff();
+                }
+            }
+            hooks.thread_done(checksum);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace handoff
@@ -0,0 +1,158 @@
+#include "FixedBlockAllocator.hpp"
+#include "HeapProfiler.hpp"
+#include "test_helpers.hpp"
+#include "test_runner.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using cma::AllocatorOptions;
+using cma::HeapProfiler;
+
+using cma_test::Allocator;
+using cma_test::deallocate_blocks;
+using cma_test::kBlockSize;
+
+namespace {
+
+AllocatorOptions profiled(HeapProfiler& profiler) {
+    AllocatorOptions options;
+    options.heap_profiler = &profiler;
+    return options;
+}
+
+// Two distinct call sites; noinline keeps their return addresses apart.
+#if defined(__GNUC__) || defined(__clang__)
+#define CMA_TEST_NOINLINE __attribute__((noinline))
+#else
+#define CMA_TEST_NOINLINE
+#endif
+
+CMA_TEST_NOINLINE void allocate_from_site_a(Allocator& allocator, std::vector<void*>& out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(allocator.allocate());
+    }
+}
+
+CMA_TEST_NOINLINE void allocate_from_site_b(Allocator& allocator, std::vector<void*>& out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(allocator.allocate());
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Sampling and the live table
+// ---------------------------------------------------------------------------
+
+TEST(HeapProfiler_SamplesEveryBlockAtBlockSizeRate) {
+    HeapProfiler profiler(kBlockSize);
+    Allocator allocator(profiled(profiler));
+    std::vector<void*> blocks;
+    allocate_from_site_a(allocator, blocks, 100);
+    EXPECT_EQ(profiler.live_samples(), 100U);
+    EXPECT_EQ(profiler.live_bytes(), 100U * kBlockSize);
+
+    std::vector<void*> freed(blocks.begin(), blocks.begin() + 60);
+    blocks.erase(blocks.begin(), blocks.begin() + 60);
+    deallocate_blocks(allocator, freed);
+    EXPECT_EQ(profiler.live_samples(), 40U);
+    deallocate_blocks(allocator, blocks);
+    EXPECT_EQ(profiler.live_samples(), 0U);
+    EXPECT_TRUE(profiler.live_sites().empty());
+}
+
+TEST(HeapProfiler_SeparatesCallSites) {
+    HeapProfiler profiler(kBlockSize);
+    Allocator allocator(profiled(profiler));
+    std::vector<void*> a;
+    std::vector<void*> b;
+    allocate_from_site_a(allocator, a, 30);
+    allocate_from_site_b(allocator, b, 70);
+
+    const std::vector<HeapProfiler::Site> sites = profiler.live_sites();
+    if (sites.empty() || sites[0].frames.empty()) {
+        deallocate_blocks(allocator, a);
+        deallocate_blocks(allocator, b);
+        return;  // no stack capture on this platform
+    }
+    EXPECT_EQ(sites.size(), 2U);
+    EXPECT_EQ(sites[0].live_samples, 70U);
+    EXPECT_EQ(sites[1].live_samples, 30U);
+    EXPECT_EQ(sites[0].live_bytes, 70U * kBlockSize);
+    deallocate_blocks(allocator, b);
+    EXPECT_EQ(profiler.live_sites().size(), 1U);
+    deallocate_blocks(allocator, a);
+}
+
+TEST(HeapProfiler_SparseSamplingEstimatesLiveBytes) {
+    const size_t mean_blocks = 64;
+    HeapProfiler profiler(mean_blocks * kBlockSize);
+    Allocator allocator(profiled(profiler));
+    std::vector<void*> blocks;
+    allocate_from_site_a(allocator, blocks, 64000);
+
+    // ~1000 expected samples; +-20% is many standard deviations wide.
+    EXPECT_GE(profiler.live_samples(), 800U);
+    EXPECT_LE(profiler.live_samples(), 1200U);
+    const size_t actual = blocks.size() * kBlockSize;
+    EXPECT_GE(profiler.live_bytes(), actual * 8 / 10);
+    EXPECT_LE(profiler.live_bytes(), actual * 12 / 10);
+    deallocate_blocks(allocator, blocks);
+    EXPECT_EQ(profiler.live_samples(), 0U);
+}
+
+TEST(HeapProfiler_SharedAcrossPoolsOfDifferentSizes) {
+    HeapProfiler profiler(8);
+    cma::FixedBlockAllocator<16> small(profiled(profiler));
+    cma::FixedBlockAllocator<128> large(profiled(profiler));
+    void* a = small.allocate();
+    void* b = large.allocate();
+    EXPECT_EQ(profiler.live_samples(), 2U);
+    EXPECT_EQ(profiler.live_bytes(), 16U + 128U);
+    small.deallocate(a);
+    large.deallocate(b);
+    EXPECT_EQ(profiler.live_samples(), 0U);
+}
+
+// ---------------------------------------------------------------------------
+// Output formats
+// ---------------------------------------------------------------------------
+
+TEST(HeapProfiler_CollapsedLinesEndWithLiveBytes) {
+    HeapProfiler profiler(kBlockSize);
+    Allocator allocator(profiled(profiler));
+    std::vector<void*> blocks;
+    allocate_from_site_a(allocator, blocks, 10);
+
+    std::ostringstream out;
+    profiler.write_collapsed(out);
+    std::istringstream lines(out.str());
+    std::string line;
+    size_t total = 0;
+    while (std::getline(lines, line)) {
+        const size_t space = line.rfind(' ');
+        EXPECT_TRUE(space != std::string::npos && space > 0);
+        total += std::stoul(line.substr(space + 1));
+    }
+    EXPECT_EQ(total, 10U * kBlockSize);
+    deallocate_blocks(allocator, blocks);
+}
+
+TEST(HeapProfiler_PprofHeaderTotals) {
+    HeapProfiler profiler(kBlockSize);
+    Allocator allocator(profiled(profiler));
+    std::vector<void*> blocks;
+    allocate_from_site_a(allocator, blocks, 5);
+
+    std::ostringstream out;
+    profiler.write_pprof(out);
+    const std::string text = out.str();
+    const std::string expected = "heap profile: 5: " + std::to_string(5 * kBlockSize) + " [5: " +
+                                 std::to_string(5 * kBlockSize) + "] @ heapprofile\n";
+    EXPECT_EQ(text.compare(0, expected.size(), expected), 0);
+    EXPECT_TRUE(text.find("MAPPED_LIBRARIES:") != std::string::npos);
+    deallocate_blocks(allocator, blocks);
+}
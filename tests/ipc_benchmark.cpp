@@ -0,0 +1,237 @@
+#include "ipc_benchmark.hpp"
+
+#include "SharedBlockPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t kMessageSize = 256;
+constexpr size_t kPoolBlocks = 16 * 1024;
+constexpr size_t kRingSlots = 4096;  // power of two
+
+using Pool = cma::SharedBlockPool<kMessageSize>;
+using Clock = std::chrono::steady_clock;
+
+void print_ipc_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name << " ipc [--messages N]\n\n"
+              << "Sends N " << kMessageSize
+              << "-byte messages from a forked producer to a consumer, once through a\n"
+              << "shared-memory block pool (only offsets cross the ring) and once through a\n"
+              << "socketpair, and reports messages per second for each.\n";
+}
+
+#if !defined(_WIN32)
+
+// Single-producer / single-consumer ring of block offsets, placed in its own
+// shared region. Each side owns one index; the other side only reads it.
+struct OffsetRing {
+    alignas(64) std::atomic<uint64_t> head{0};  // next slot the producer writes
+    alignas(64) std::atomic<uint64_t> tail{0};  // next slot the consumer reads
+    alignas(64) uint64_t slots[kRingSlots];
+};
+
+void fill_message(unsigned char* message, size_t seq) {
+    std::memset(message, static_cast<int>(seq & 0xFF), kMessageSize);
+    std::memcpy(message, &seq, sizeof(seq));
+}
+
+bool message_ok(const unsigned char* message, size_t seq) {
+    size_t stored = 0;
+    std::memcpy(&stored, message, sizeof(stored));
+    return stored == seq && message[kMessageSize - 1] == static_cast<unsigned char>(seq & 0xFF);
+}
+
+// Waits for @p child and returns true when it exited cleanly.
+bool reap(pid_t child) {
+    int status = -1;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+double run_shared_pool(size_t messages, bool& ok) {
+    const std::string pool_name = "/cma_ipc_pool_" + std::to_string(getpid());
+    const std::string ring_name = "/cma_ipc_ring_" + std::to_string(getpid());
+    auto pool = Pool::create(pool_name, kPoolBlocks);
+    const cma::SharedRegion ring_region = cma::create_shared_region(ring_name.c_str(), sizeof(OffsetRing));
+    if (!pool || ring_region.base == nullptr) {
+        std::cerr << "Error: could not create shared-memory objects\n";
+        Pool::remove(pool_name);
+        cma::remove_shared_region(ring_name.c_str());
+        ok = false;
+        return 0.0;
+    }
+    OffsetRing* ring = new (ring_region.base) OffsetRing();
+
+    const auto start = Clock::now();
+    const pid_t producer = fork();
+    if (producer == 0) {
+        // Attach by name, as an unrelated process would.
+        auto shared = Pool::open(pool_name);
+        const cma::SharedRegion region = cma::open_shared_region(ring_name.c_str());
+        if (!shared || region.base == nullptr) {
+            _exit(1);
+        }
+        auto* child_ring = static_cast<OffsetRing*>(region.base);
+        for (size_t seq = 0; seq < messages; ++seq) {
+            void* block = shared->allocate();
+            while (block == nullptr) {
+                sched_yield();
+                block = shared->allocate();
+            }
+            fill_message(static_cast<unsigned char*>(block), seq);
+            const uint64_t head = child_ring->head.load(std::memory_order_relaxed);
+            while (head - child_ring->tail.load(std::memory_order_acquire) >= kRingSlots) {
+                sched_yield();  // ring full; let the consumer run (matters on few cores)
+            }
+            child_ring->slots[head & (kRingSlots - 1)] = shared->to_offset(block);
+            child_ring->head.store(head + 1, std::memory_order_release);
+        }
+        _exit(0);
+    }
+
+    bool consumer_ok = true;
+    for (size_t seq = 0; seq < messages; ++seq) {
+        const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        while (ring->head.load(std::memory_order_acquire) == tail) {
+            sched_yield();
+        }
+        void* block = pool->from_offset(ring->slots[tail & (kRingSlots - 1)]);
+        ring->tail.store(tail + 1, std::memory_order_release);
+        consumer_ok = consumer_ok && message_ok(static_cast<unsigned char*>(block), seq);
+        pool->deallocate(block);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    ok = reap(producer) && consumer_ok && pool->live_blocks() == 0;
+    cma::close_shared_region(ring_region);
+    cma::remove_shared_region(ring_name.c_str());
+    Pool::remove(pool_name);
+    return seconds;
+}
+
+bool read_all(int fd, unsigned char* buffer, size_t size) {
+    while (size > 0) {
+        const ssize_t n = read(fd, buffer, size);
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_all(int fd, const unsigned char* buffer, size_t size) {
+    while (size > 0) {
+        const ssize_t n = write(fd, buffer, size);
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+double run_socketpair(size_t messages, bool& ok) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        std::cerr << "Error: socketpair failed\n";
+        ok = false;
+        return 0.0;
+    }
+
+    const auto start = Clock::now();
+    const pid_t producer = fork();
+    if (producer == 0) {
+        close(fds[0]);
+        unsigned char message[kMessageSize];
+        for (size_t seq = 0; seq < messages; ++seq) {
+            fill_message(message, seq);
+            if (!write_all(fds[1], message, kMessageSize)) {
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+
+    bool consumer_ok = true;
+    unsigned char message[kMessageSize];
+    for (size_t seq = 0; seq < messages && consumer_ok; ++seq) {
+        consumer_ok = read_all(fds[0], message, kMessageSize) && message_ok(message, seq);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    close(fds[0]);
+    ok = reap(producer) && consumer_ok;
+    return seconds;
+}
+
+void print_ipc_row(const char* label, size_t messages, double seconds, bool ok) {
+    std::cout << std::left << std::setw(24) << label << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << seconds * 1000.0 << std::setw(16) << std::setprecision(0)
+              << (seconds > 0.0 ? messages / seconds : 0.0) << "   " << (ok ? "ok" : "FAILED") << "\n";
+}
+
+#endif
+
+} // namespace
+
+int run_ipc_benchmark(int argc, char* argv[]) {
+    size_t messages = 1000000;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--messages" && i + 1 < argc) {
+            messages = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            print_ipc_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (messages == 0) {
+        print_ipc_usage(argv[0]);
+        return 1;
+    }
+
+#if defined(_WIN32)
+    std::cerr << "Error: the ipc benchmark needs fork() and is not available on Windows\n";
+    return 1;
+#else
+    bool pool_ok = false;
+    bool socket_ok = false;
+    const double pool_seconds = run_shared_pool(messages, pool_ok);
+    const double socket_seconds = run_socketpair(messages, socket_ok);
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Two-process message passing (" << messages << " x " << kMessageSize << " bytes)\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << std::left << std::setw(24) << "Transport" << std::right << std::setw(12) << "Time (ms)"
+              << std::setw(16) << "Messages/s" << "\n";
+    std::cout << std::string(72, '-') << "\n";
+    print_ipc_row("shared block pool", messages, pool_seconds, pool_ok);
+    print_ipc_row("socketpair", messages, socket_seconds, socket_ok);
+    if (pool_seconds > 0.0) {
+        std::cout << "speedup                 : " << std::setprecision(2) << socket_seconds / pool_seconds
+                  << "x\n";
+    }
+    std::cout << std::string(72, '=') << "\n";
+    return pool_ok && socket_ok ? 0 : 1;
+#endif
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Runs: allocator_test ipc [--messages N]
+// Forks a producer and a consumer that exchange fixed-size messages through a
+// SharedBlockPool (offsets over a shared ring) and through a socketpair.
+int run_ipc_benchmark(int argc, char* argv[]);
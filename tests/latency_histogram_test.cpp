@@ -0,0 +1,89 @@
+#include "LatencyHistogram.hpp"
+#include "test_runner.hpp"
+
+#include <cstdint>
+#include <thread>
+
+using cma::LatencyHistogram;
+using cma::LatencySummary;
+
+// ---------------------------------------------------------------------------
+// Bucketing
+// ---------------------------------------------------------------------------
+
+TEST(LatencyHistogram_SmallValuesAreExact) {
+    for (uint64_t value = 0; value < LatencyHistogram::SUB_BUCKETS; ++value) {
+        EXPECT_EQ(LatencyHistogram::bucket_index(value), value);
+        EXPECT_EQ(LatencyHistogram::bucket_upper_bound(LatencyHistogram::bucket_index(value)), value);
+    }
+}
+
+TEST(LatencyHistogram_BucketsAreContiguousAndBounded) {
+    // Each value falls in a bucket whose upper bound is within 1/SUB_BUCKETS of it.
+    const uint64_t samples[] = {16, 17, 31, 32, 33, 100, 1000, 4095, 4096, 123456789, UINT64_MAX};
+    for (const uint64_t value : samples) {
+        const size_t index = LatencyHistogram::bucket_index(value);
+        EXPECT_TRUE(index < LatencyHistogram::BUCKET_COUNT);
+        const uint64_t upper = LatencyHistogram::bucket_upper_bound(index);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / LatencyHistogram::SUB_BUCKETS);
+        EXPECT_EQ(LatencyHistogram::bucket_index(upper), index);
+        EXPECT_EQ(LatencyHistogram::bucket_index(upper + (upper == UINT64_MAX ? 0 : 1)),
+                  upper == UINT64_MAX ? index : index + 1);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Percentiles and merging
+// ---------------------------------------------------------------------------
+
+TEST(LatencyHistogram_PercentilesOfUniformSamples) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.value_at_quantile(0.5), 0U);
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value);
+    }
+    const LatencySummary summary = histogram.summarize();
+    EXPECT_EQ(summary.count, 1000U);
+    EXPECT_EQ(summary.max, 1000U);
+    EXPECT_GE(summary.p50, 500U);
+    EXPECT_LE(summary.p50, 500U + 500U / LatencyHistogram::SUB_BUCKETS);
+    EXPECT_GE(summary.p99, 990U);
+    EXPECT_LE(summary.p999, 1000U);
+    EXPECT_EQ(histogram.summarize(2.0).max, 2000U);
+}
+
+TEST(LatencyHistogram_MergeMatchesRecordingEverything) {
+    LatencyHistogram first;
+    LatencyHistogram second;
+    LatencyHistogram combined;
+    for (uint64_t value = 0; value < 5000; value += 7) {
+        (value % 2 == 0 ? first : second).record(value);
+        combined.record(value);
+    }
+    LatencyHistogram merged(first);
+    merged.merge(second);
+    EXPECT_EQ(merged.count(), combined.count());
+    EXPECT_EQ(merged.max(), combined.max());
+    for (const double quantile : {0.1, 0.5, 0.9, 0.99, 0.999}) {
+        EXPECT_EQ(merged.value_at_quantile(quantile), combined.value_at_quantile(quantile));
+    }
+}
+
+TEST(LatencyHistogram_MergeWhileWriterRecords) {
+    LatencyHistogram histogram;
+    std::thread writer([&]() {
+        for (uint64_t i = 0; i < 200000; ++i) {
+            histogram.record(i & 1023);
+        }
+    });
+    uint64_t last = 0;
+    for (int i = 0; i < 100; ++i) {
+        LatencyHistogram snapshot;
+        snapshot.merge(histogram);
+        EXPECT_GE(snapshot.count(), last);
+        last = snapshot.count();
+    }
+    writer.join();
+    EXPECT_EQ(histogram.count(), 200000U);
+}
@@ -0,0 +1,744 @@
+// LD_PRELOAD allocation recorder: builds libcma_recorder.so (Linux).
+//
+//   CMA_RECORD_FILE=app.%p.trace LD_PRELOAD=./libcma_recorder.so ./app
+//   ./allocator_test replay --trace app.<pid>.trace
+//
+// Interposes malloc, calloc, realloc, free, the memalign family and every
+// operator new/delete. The calling thread only writes a fixed-size raw event
+// (TSC timestamp, address, size) into its own SPSC ring. A background writer
+// thread drains the rings every millisecond (sooner when a ring is half full), merges them in timestamp order,
+// replaces addresses with stable object IDs (one per allocation, so a reused
+// address gets a new ID), and streams the varint/delta-coded binary format of
+// alloc_trace.hpp to the file.
+//
+// "%p" in CMA_RECORD_FILE is replaced by the process ID (default
+// "cma_trace.%p.bin"). A forked child stops recording. Events from threads
+// still running when the process exits, after the final drain, are lost.
+
+#include "LatencyHistogram.hpp"
+#include "alloc_trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kRingEvents = 32 * 1024;  // per thread, 1 MB
+constexpr long kDrainIntervalNs = 1'000'000;
+// Events younger than this stay buffered, so a thread that read the clock but
+// has not published yet cannot be overtaken by a later event.
+constexpr uint64_t kReorderWindowNs = 1'000'000;
+constexpr size_t kBootstrapBytes = 64 * 1024;
+
+struct RealFunctions {
+    void* (*malloc)(size_t) = nullptr;
+    void (*free)(void*) = nullptr;
+    void* (*calloc)(size_t, size_t) = nullptr;
+    void* (*realloc)(void*, size_t) = nullptr;
+    int (*posix_memalign)(void**, size_t, size_t) = nullptr;
+    void* (*aligned_alloc)(size_t, size_t) = nullptr;
+    void* (*memalign)(size_t, size_t) = nullptr;
+};
+
+RealFunctions g_resolved;
+// Points at g_resolved once every lookup is stored; null until then.
+std::atomic<const RealFunctions*> g_real{nullptr};
+
+// What the thread did, as captured on the hot path.
+struct RawEvent {
+    uint64_t ticks;
+    uint64_t address;
+    uint64_t size;
+    uint32_t thread;
+    uint32_t op;
+};
+
+enum RingState : int {
+    kRingActive = 0,
+    kRingRetired = 1,  // owner exited; the writer frees it once drained
+    kRingFree = 2,
+};
+
+// One per thread. The owner writes tail, the writer writes head.
+struct ThreadRing {
+    alignas(64) std::atomic<uint64_t> tail{0};
+    uint64_t cached_head = 0;
+    uint32_t thread = 0;
+    alignas(64) std::atomic<uint64_t> head{0};
+    std::atomic<int> state{kRingActive};
+    ThreadRing* next = nullptr;  // registry link; immutable once published
+    RawEvent events[kRingEvents];
+};
+
+std::atomic<bool> g_enabled{false};
+std::atomic<bool> g_stop{false};
+std::atomic<ThreadRing*> g_rings{nullptr};
+pthread_mutex_t g_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+std::atomic<uint32_t> g_next_thread{0};
+std::atomic<uint64_t> g_producer_waits{0};
+std::atomic<int> g_drain_requested{0};  // futex word the writer sleeps on
+pthread_key_t g_thread_key;
+pthread_t g_writer;
+int g_fd = -1;
+char g_path[4096];
+uint64_t g_start_ticks = 0;
+
+// initial-exec TLS: the default model for a shared library can allocate on
+// first access, which would re-enter malloc.
+__attribute__((tls_model("initial-exec"))) thread_local ThreadRing* t_ring = nullptr;
+__attribute__((tls_model("initial-exec"))) thread_local bool t_internal = false;
+__attribute__((tls_model("initial-exec"))) thread_local bool t_exited = false;
+
+// dlsym can allocate before the real functions are known; serve it from here.
+alignas(16) unsigned char g_bootstrap[kBootstrapBytes];
+std::atomic<size_t> g_bootstrap_used{0};
+
+bool from_bootstrap(const void* ptr) {
+    const auto* bytes = static_cast<const unsigned char*>(ptr);
+    return bytes >= g_bootstrap && bytes < g_bootstrap + kBootstrapBytes;
+}
+
+// @p alignment is a power of two.
+void* bootstrap_alloc(size_t size, size_t alignment = 16) {
+    alignment = std::max<size_t>(alignment, 16);
+    const uintptr_t base = reinterpret_cast<uintptr_t>(g_bootstrap);
+    size_t used = g_bootstrap_used.load(std::memory_order_relaxed);
+    size_t offset = 0;
+    do {
+        offset = static_cast<size_t>(((base + used + alignment - 1) & ~(alignment - 1)) - base);
+        if (offset > kBootstrapBytes || size > kBootstrapBytes - offset) {
+            return nullptr;
+        }
+    } while (!g_bootstrap_used.compare_exchange_weak(used, offset + ((size + 15) & ~size_t{15}),
+                                                     std::memory_order_relaxed));
+    return g_bootstrap + offset;
+}
+
+void resolve_real_functions() {
+    static std::atomic<bool> resolving{false};
+    if (g_real.load(std::memory_order_acquire) != nullptr || resolving.exchange(true)) {
+        return;
+    }
+    const bool was_internal = t_internal;
+    t_internal = true;
+    RealFunctions& real = g_resolved;
+    real.malloc = reinterpret_cast<void* (*)(size_t)>(dlsym(RTLD_NEXT, "malloc"));
+    real.calloc = reinterpret_cast<void* (*)(size_t, size_t)>(dlsym(RTLD_NEXT, "calloc"));
+    real.realloc = reinterpret_cast<void* (*)(void*, size_t)>(dlsym(RTLD_NEXT, "realloc"));
+    real.posix_memalign = reinterpret_cast<int (*)(void**, size_t, size_t)>(dlsym(RTLD_NEXT, "posix_memalign"));
+    real.aligned_alloc = reinterpret_cast<void* (*)(size_t, size_t)>(dlsym(RTLD_NEXT, "aligned_alloc"));
+    real.memalign = reinterpret_cast<void* (*)(size_t, size_t)>(dlsym(RTLD_NEXT, "memalign"));
+    real.free = reinterpret_cast<void (*)(void*)>(dlsym(RTLD_NEXT, "free"));
+    g_real.store(&real, std::memory_order_release);
+    t_internal = was_internal;
+}
+
+// The real functions, or nullptr while they are being looked up: by dlsym
+// itself on the resolving thread, or concurrently on another thread. Callers
+// then fall back to the bootstrap arena.
+const RealFunctions* real_functions() {
+    const RealFunctions* real = g_real.load(std::memory_order_acquire);
+    if (real == nullptr) {
+        resolve_real_functions();
+        real = g_real.load(std::memory_order_acquire);
+    }
+    return real;
+}
+
+bool is_power_of_two(size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+void on_thread_exit(void* ring) {
+    static_cast<ThreadRing*>(ring)->state.store(kRingRetired, std::memory_order_release);
+    t_ring = nullptr;
+    t_exited = true;
+}
+
+// Reuses a drained ring of an exited thread, or maps a new one.
+ThreadRing* register_thread() {
+    t_internal = true;
+    ThreadRing* ring = nullptr;
+    pthread_mutex_lock(&g_registry_lock);
+    for (ThreadRing* candidate = g_rings.load(std::memory_order_acquire); candidate != nullptr;
+         candidate = candidate->next) {
+        if (candidate->state.load(std::memory_order_acquire) == kRingFree) {
+            ring = candidate;
+            ring->tail.store(0, std::memory_order_relaxed);
+            ring->head.store(0, std::memory_order_relaxed);
+            ring->cached_head = 0;
+            ring->state.store(kRingActive, std::memory_order_release);
+            break;
+        }
+    }
+    if (ring == nullptr) {
+        void* memory = mmap(nullptr, sizeof(ThreadRing), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED) {
+            ring = new (memory) ThreadRing();
+            ring->next = g_rings.load(std::memory_order_relaxed);
+            g_rings.store(ring, std::memory_order_release);
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+    if (ring != nullptr) {
+        ring->thread = g_next_thread.fetch_add(1, std::memory_order_relaxed);
+        pthread_setspecific(g_thread_key, ring);
+    }
+    t_ring = ring;
+    t_internal = false;
+    return ring;
+}
+
+// Wakes the writer early. Only the first caller per drain pays for the syscall.
+void request_drain() {
+    if (g_drain_requested.load(std::memory_order_relaxed) == 0 &&
+        g_drain_requested.exchange(1, std::memory_order_acq_rel) == 0) {
+        syscall(SYS_futex, &g_drain_requested, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+}
+
+void record(alloc_trace::Op op, const void* address, size_t size, uint64_t ticks) {
+    if (!g_enabled.load(std::memory_order_relaxed) || t_internal || address == nullptr) {
+        return;
+    }
+    ThreadRing* ring = t_ring;
+    if (ring == nullptr) {
+        if (t_exited || (ring = register_thread()) == nullptr) {
+            return;
+        }
+    }
+    const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->cached_head >= kRingEvents / 2) {
+        ring->cached_head = ring->head.load(std::memory_order_acquire);
+        if (tail - ring->cached_head >= kRingEvents / 2) {
+            request_drain();
+        }
+        if (tail - ring->cached_head >= kRingEvents) {
+            g_producer_waits.fetch_add(1, std::memory_order_relaxed);
+            while (tail - ring->cached_head >= kRingEvents) {
+                request_drain();
+                sched_yield();
+                ring->cached_head = ring->head.load(std::memory_order_acquire);
+            }
+        }
+    }
+    ring->events[tail % kRingEvents] =
+        RawEvent{ticks, reinterpret_cast<uintptr_t>(address), size, ring->thread, static_cast<uint32_t>(op)};
+    ring->tail.store(tail + 1, std::memory_order_release);
+}
+
+// An allocation is stamped after it returns and a free before it starts, so
+// a free of address A always sorts before the allocation that reuses A.
+inline void record_alloc(const void* address, size_t size) {
+    record(alloc_trace::Op::Alloc, address, size, cma::read_cycle_counter());
+}
+
+inline void record_free(const void* address) {
+    record(alloc_trace::Op::Free, address, 0, cma::read_cycle_counter());
+}
+
+uint64_t monotonic_ns() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1'000'000'000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+void write_all(const unsigned char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = write(g_fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+// Live address -> object ID. Open addressing with linear probing and
+// backward-shift deletion; a node-based map costs several times more per event.
+class AddressTable {
+public:
+    // Removes @p address and returns its ID, or 0 if it is not live.
+    uint64_t take(uint64_t address) {
+        if (size_ == 0) {
+            return 0;
+        }
+        for (size_t i = slot(address);; i = (i + 1) & mask_) {
+            if (slots_[i].address == 0) {
+                return 0;
+            }
+            if (slots_[i].address == address) {
+                const uint64_t id = slots_[i].id;
+                erase_at(i);
+                return id;
+            }
+        }
+    }
+
+    void put(uint64_t address, uint64_t id) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            grow();
+        }
+        size_t i = slot(address);
+        while (slots_[i].address != 0 && slots_[i].address != address) {
+            i = (i + 1) & mask_;
+        }
+        size_ += slots_[i].address == 0;
+        slots_[i] = Slot{address, id};
+    }
+
+private:
+    struct Slot {
+        uint64_t address;
+        uint64_t id;
+    };
+
+    size_t slot(uint64_t address) const {
+        return static_cast<size_t>(((address >> 4) * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+    }
+
+    void erase_at(size_t hole) {
+        --size_;
+        for (size_t i = (hole + 1) & mask_; slots_[i].address != 0; i = (i + 1) & mask_) {
+            const size_t home = slot(slots_[i].address);
+            // Move back entries whose probe sequence passes through the hole.
+            if (((i - home) & mask_) >= ((i - hole) & mask_)) {
+                slots_[hole] = slots_[i];
+                hole = i;
+            }
+        }
+        slots_[hole] = Slot{0, 0};
+    }
+
+    void grow() {
+        std::vector<Slot> old(slots_.empty() ? 1024 : slots_.size() * 2, Slot{0, 0});
+        old.swap(slots_);
+        mask_ = slots_.size() - 1;
+        size_ = 0;
+        for (const Slot& entry : old) {
+            if (entry.address != 0) {
+                put(entry.address, entry.id);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+};
+
+// State owned by the writer thread.
+struct Writer {
+    double ns_per_tick = 1.0;
+    uint64_t reorder_ticks = 0;
+    std::vector<RawEvent> pending;  // sorted by ticks from index first
+    size_t first = 0;
+    AddressTable live_ids;
+    uint64_t next_id = 0;
+    uint64_t previous_ns = 0;
+    uint64_t events = 0;
+    uint64_t bytes = 0;
+    std::vector<unsigned char> out;
+
+    void collect() {
+        for (ThreadRing* ring = g_rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+            const int state = ring->state.load(std::memory_order_acquire);
+            if (state == kRingFree) {
+                continue;
+            }
+            const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+            const size_t merged = pending.size();
+            for (uint64_t i = ring->head.load(std::memory_order_relaxed); i < tail; ++i) {
+                pending.push_back(ring->events[i % kRingEvents]);
+            }
+            ring->head.store(tail, std::memory_order_release);
+            // pending stays sorted: each ring is already in order, so merge it in.
+            // On equal ticks the earlier ring's events stay first, preserving
+            // per-thread order.
+            std::inplace_merge(pending.begin() + static_cast<std::ptrdiff_t>(first),
+                               pending.begin() + static_cast<std::ptrdiff_t>(merged), pending.end(),
+                               [](const RawEvent& a, const RawEvent& b) { return a.ticks < b.ticks; });
+            // The owner's last event was published before it retired the ring.
+            if (state == kRingRetired && ring->tail.load(std::memory_order_acquire) == tail) {
+                ring->state.store(kRingFree, std::memory_order_release);
+            }
+        }
+    }
+
+    void emit(bool everything) {
+        const uint64_t now = cma::read_cycle_counter();
+        const uint64_t cutoff = everything ? UINT64_MAX : (now > reorder_ticks ? now - reorder_ticks : 0);
+        const size_t begin = first;
+        unsigned char record_bytes[alloc_trace::kMaxRecordBytes];
+        for (; first < pending.size() && pending[first].ticks <= cutoff; ++first) {
+            const RawEvent& raw = pending[first];
+            alloc_trace::Event event;
+            event.timestamp_ns = static_cast<uint64_t>(
+                static_cast<double>(raw.ticks > g_start_ticks ? raw.ticks - g_start_ticks : 0) * ns_per_tick);
+            event.thread = raw.thread;
+            event.op = static_cast<alloc_trace::Op>(raw.op);
+            if (event.op == alloc_trace::Op::Alloc) {
+                event.object = ++next_id;
+                event.size = raw.size;
+                live_ids.put(raw.address, event.object);
+            } else {
+                event.object = live_ids.take(raw.address);
+                if (event.object == 0) {
+                    event.object = ++next_id;  // allocated before recording began
+                }
+            }
+            const size_t length = alloc_trace::encode_event(event, previous_ns, record_bytes);
+            out.insert(out.end(), record_bytes, record_bytes + length);
+        }
+        events += first - begin;
+        if (first * 2 >= pending.size()) {
+            pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(first));
+            first = 0;
+        }
+        bytes += out.size();
+        write_all(out.data(), out.size());
+        out.clear();
+    }
+};
+
+void* writer_main(void*) {
+    t_internal = true;
+    Writer writer;
+
+    // Calibrate ticks against the monotonic clock before anything is written;
+    // rings absorb the events recorded meanwhile.
+    const uint64_t ticks0 = cma::read_cycle_counter();
+    const uint64_t ns0 = monotonic_ns();
+    const timespec calibration{0, 20'000'000};
+    nanosleep(&calibration, nullptr);
+    const uint64_t ticks1 = cma::read_cycle_counter();
+    const uint64_t ns1 = monotonic_ns();
+    writer.ns_per_tick = ticks1 > ticks0 ? static_cast<double>(ns1 - ns0) / static_cast<double>(ticks1 - ticks0) : 1.0;
+    writer.reorder_ticks = static_cast<uint64_t>(static_cast<double>(kReorderWindowNs) / writer.ns_per_tick);
+
+    unsigned char header[sizeof(alloc_trace::kMagic) + 10];
+    std::memcpy(header, alloc_trace::kMagic, sizeof(alloc_trace::kMagic));
+    const size_t header_length =
+        sizeof(alloc_trace::kMagic) + alloc_trace::encode_varint(alloc_trace::kVersion, header + 8);
+    write_all(header, header_length);
+    writer.bytes = header_length;
+
+    const timespec interval{0, kDrainIntervalNs};
+    while (!g_stop.load(std::memory_order_acquire)) {
+        syscall(SYS_futex, &g_drain_requested, FUTEX_WAIT_PRIVATE, 0, &interval, nullptr, 0);
+        g_drain_requested.store(0, std::memory_order_release);
+        writer.collect();
+        writer.emit(false);
+    }
+    writer.collect();
+    writer.emit(true);
+
+    char summary[512];
+    const int length = std::snprintf(summary, sizeof(summary),
+                                     "cma_recorder: %llu events from %u threads, %llu bytes (%.1f B/event), "
+                                     "%llu full-ring waits -> %s\n",
+                                     static_cast<unsigned long long>(writer.events),
+                                     g_next_thread.load(std::memory_order_relaxed),
+                                     static_cast<unsigned long long>(writer.bytes),
+                                     writer.events ? static_cast<double>(writer.bytes) / writer.events : 0.0,
+                                     static_cast<unsigned long long>(g_producer_waits.load()), g_path);
+    if (length > 0) {
+        const ssize_t ignored = write(STDERR_FILENO, summary, static_cast<size_t>(length));
+        (void)ignored;
+    }
+    return nullptr;
+}
+
+void stop_in_child() {
+    g_enabled.store(false, std::memory_order_relaxed);
+    g_fd = -1;
+}
+
+// "%p" -> pid.
+void format_path(const char* pattern) {
+    size_t out = 0;
+    for (const char* c = pattern; *c != '\0' && out + 24 < sizeof(g_path); ++c) {
+        if (c[0] == '%' && c[1] == 'p') {
+            out += static_cast<size_t>(std::snprintf(g_path + out, sizeof(g_path) - out, "%d", getpid()));
+            ++c;
+        } else {
+            g_path[out++] = *c;
+        }
+    }
+    g_path[out] = '\0';
+}
+
+__attribute__((constructor)) void recorder_start() {
+    resolve_real_functions();
+    t_internal = true;
+    const char* pattern = std::getenv("CMA_RECORD_FILE");
+    format_path(pattern != nullptr && *pattern != '\0' ? pattern : "cma_trace.%p.bin");
+    g_fd = open(g_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (g_fd >= 0 && pthread_key_create(&g_thread_key, on_thread_exit) == 0 &&
+        pthread_create(&g_writer, nullptr, writer_main, nullptr) == 0) {
+        pthread_atfork(nullptr, nullptr, stop_in_child);
+        g_start_ticks = cma::read_cycle_counter();
+        g_enabled.store(true, std::memory_order_release);
+    }
+    t_internal = false;
+}
+
+__attribute__((destructor)) void recorder_stop() {
+    if (!g_enabled.exchange(false)) {
+        return;
+    }
+    g_stop.store(true, std::memory_order_release);
+    request_drain();
+    pthread_join(g_writer, nullptr);
+    close(g_fd);
+}
+
+void* allocate_or_throw(size_t size) {
+    for (;;) {
+        void* block = malloc(size);
+        if (block != nullptr) {
+            return block;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* aligned_allocate_or_throw(size_t size, std::align_val_t alignment) {
+    for (;;) {
+        void* block = nullptr;
+        if (posix_memalign(&block, std::max(static_cast<size_t>(alignment), sizeof(void*)), size) == 0) {
+            return block;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+// C allocation functions
+// -----------------------------------------------------------------------------
+
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+    const RealFunctions* real = real_functions();
+    if (real == nullptr || real->malloc == nullptr) {
+        return bootstrap_alloc(size);
+    }
+    void* block = real->malloc(size);
+    record_alloc(block, size);
+    return block;
+}
+
+void free(void* block) noexcept {
+    if (block == nullptr || from_bootstrap(block)) {
+        return;
+    }
+    const RealFunctions* real = real_functions();
+    if (real == nullptr || real->free == nullptr) {
+        return;  // freed during symbol lookup: leak it
+    }
+    record_free(block);
+    real->free(block);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    const RealFunctions* real = real_functions();
+    if (real == nullptr || real->calloc == nullptr) {
+        // Bootstrap memory is static, hence already zeroed.
+        return size != 0 && count > SIZE_MAX / size ? nullptr : bootstrap_alloc(count * size);
+    }
+    void* block = real->calloc(count, size);
+    record_alloc(block, count * size);
+    return block;
+}
+
+void* realloc(void* block, size_t size) noexcept {
+    if (block != nullptr && from_bootstrap(block)) {
+        void* moved = malloc(size);
+        if (moved != nullptr) {
+            const size_t available = static_cast<size_t>(g_bootstrap + kBootstrapBytes - static_cast<unsigned char*>(block));
+            std::memcpy(moved, block, std::min(size, available));
+        }
+        return moved;
+    }
+    const RealFunctions* real = real_functions();
+    if (real == nullptr || real->realloc == nullptr) {
+        // During symbol lookup: copy into the bootstrap arena and leak the old block.
+        void* moved = bootstrap_alloc(size);
+        if (moved != nullptr && block != nullptr) {
+            std::memcpy(moved, block, std::min(size, malloc_usable_size(block)));
+        }
+        return moved;
+    }
+    if (block != nullptr) {
+        record_free(block);
+    }
+    void* moved = real->realloc(block, size);
+    if (moved != nullptr) {
+        record_alloc(moved, size);
+    } else if (block != nullptr && size != 0) {
+        // Failed: the old block is still live.
+        record_alloc(block, malloc_usable_size(block));
+    }
+    return moved;
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    const RealFunctions* real = real_functions();
+    if (real == nullptr || real->posix_memalign == nullptr) {
+        if (!is_power_of_two(alignment) || alignment % sizeof(void*) != 0) {
+            return EINVAL;
+        }
+        void* block = bootstrap_alloc(size, alignment);
+        if (block == nullptr) {
+            return ENOMEM;
+        }
+        *out = block;
+        return 0;
+    }
+    const int result = real->posix_memalign(out, alignment, size);
+    if (result == 0) {
+        record_alloc(*out, size);
+    }
+    return result;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    const RealFunctions* real = real_functions();
+    if (real == nullptr || real->aligned_alloc == nullptr) {
+        return is_power_of_two(alignment) ? bootstrap_alloc(size, alignment) : nullptr;
+    }
+    void* block = real->aligned_alloc(alignment, size);
+    record_alloc(block, size);
+    return block;
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    const RealFunctions* real = real_functions();
+    if (real == nullptr || real->memalign == nullptr) {
+        return is_power_of_two(alignment) ? bootstrap_alloc(size, alignment) : nullptr;
+    }
+    void* block = real->memalign(alignment, size);
+    record_alloc(block, size);
+    return block;
+}
+
+} // extern "C"
+
+// -----------------------------------------------------------------------------
+// C++ allocation functions (routed through the recorded malloc/free above)
+// -----------------------------------------------------------------------------
+
+void* operator new(size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return aligned_allocate_or_throw(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return aligned_allocate_or_throw(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    void* block = nullptr;
+    return posix_memalign(&block, std::max(static_cast<size_t>(alignment), sizeof(void*)), size) == 0 ? block
+                                                                                                       : nullptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block, std::align_val_t) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t, std::align_val_t) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block, size_t, std::align_val_t) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(block);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Runs: allocator_test persist [--mb N] [--path file]
+// Fills a file-backed PersistentBlockPool, then times clean and post-crash
+// restarts against rebuilding the same objects from scratch.
+int run_persist_benchmark(int argc, char* argv[]);
@@ -0,0 +1,214 @@
+#include "PersistentBlockPool.hpp"
+#include "test_runner.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Pool = cma::PersistentBlockPool<64>;
+using RecoveryMode = Pool::RecoveryMode;
+
+std::string temp_pool_path(const char* tag) {
+    const auto dir = std::filesystem::temp_directory_path();
+    return (dir / (std::string("cma_test_") + tag + ".pool")).string();
+}
+
+#if !defined(_WIN32)
+// Ends the session without the destructor, like a crash would.
+template <typename Fn>
+bool run_and_crash(const std::string& path, Fn fn) {
+    const pid_t child = fork();
+    if (child == 0) {
+        auto pool = Pool::open(path);
+        if (!pool) {
+            _exit(1);
+        }
+        fn(*pool);
+        _exit(0);
+    }
+    int status = -1;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+#endif
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Create / reopen
+// ---------------------------------------------------------------------------
+
+TEST(PersistentPool_CreateStartsEmpty) {
+    const std::string path = temp_pool_path("create");
+    auto pool = Pool::create(path, 4);
+    EXPECT_NOT_NULL(pool);
+    EXPECT_TRUE(pool->recovery().mode == RecoveryMode::Created);
+    EXPECT_EQ(pool->page_count(), 0U);
+    EXPECT_EQ(pool->live_blocks(), 0U);
+    pool.reset();
+    std::remove(path.c_str());
+}
+
+TEST(PersistentPool_CleanRestartKeepsBlocksAndRoots) {
+    const std::string path = temp_pool_path("clean");
+    std::vector<uint64_t> offsets;
+    {
+        auto pool = Pool::create(path, 8);
+        for (uint32_t i = 0; i < 2000; ++i) {
+            auto* block = static_cast<uint32_t*>(pool->allocate());
+            block[1] = i * 7;
+            offsets.push_back(pool->to_offset(block));
+        }
+        pool->root(0) = offsets[1234];
+    }
+
+    auto pool = Pool::open(path);
+    EXPECT_NOT_NULL(pool);
+    EXPECT_TRUE(pool->recovery().mode == RecoveryMode::CleanRestart);
+    EXPECT_EQ(pool->recovery().repaired_pages, 0U);
+    EXPECT_EQ(pool->live_blocks(), 2000U);
+    EXPECT_EQ(pool->recovery().pages_scanned, pool->page_count());
+    EXPECT_EQ(pool->root(0), offsets[1234]);
+    for (uint32_t i = 0; i < offsets.size(); ++i) {
+        EXPECT_EQ(static_cast<uint32_t*>(pool->from_offset(offsets[i]))[1], i * 7);
+    }
+    pool.reset();
+    std::remove(path.c_str());
+}
+
+TEST(PersistentPool_FreeListsSurviveRestart) {
+    const std::string path = temp_pool_path("freelist");
+    std::set<uint64_t> live;
+    std::set<uint64_t> freed;
+    {
+        auto pool = Pool::create(path, 4);
+        for (int i = 0; i < 500; ++i) {
+            live.insert(pool->to_offset(pool->allocate()));
+        }
+        for (auto it = live.begin(); it != live.end();) {
+            if (*it % 3 == 0) {
+                pool->deallocate(pool->from_offset(*it));
+                freed.insert(*it);
+                it = live.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    auto pool = Pool::open(path);
+    EXPECT_EQ(pool->live_blocks(), live.size());
+    for (size_t i = 0; i < freed.size(); ++i) {
+        const uint64_t offset = pool->to_offset(pool->allocate());
+        EXPECT_TRUE(freed.count(offset) == 1);
+        EXPECT_TRUE(live.count(offset) == 0);
+    }
+    pool.reset();
+    std::remove(path.c_str());
+}
+
+TEST(PersistentPool_OpenRejectsMissingOrMismatchedFile) {
+    const std::string path = temp_pool_path("mismatch");
+    std::remove(path.c_str());
+    EXPECT_NULL(Pool::open(path));
+
+    cma::PersistentBlockPool<32>::create(path, 1).reset();
+    EXPECT_NULL(Pool::open(path));
+    std::remove(path.c_str());
+}
+
+TEST(PersistentPool_ExhaustionAfterMaxPages) {
+    const std::string path = temp_pool_path("full");
+    auto pool = Pool::create(path, 1);
+    for (size_t i = 0; i < Pool::blocks_per_page(); ++i) {
+        EXPECT_NOT_NULL(pool->allocate());
+    }
+    EXPECT_NULL(pool->allocate());
+    EXPECT_EQ(pool->page_count(), 1U);
+    pool.reset();
+    std::remove(path.c_str());
+}
+
+TEST(PersistentPool_ForeignPointersAreIgnored) {
+    const std::string path = temp_pool_path("foreign");
+    auto pool = Pool::create(path, 1);
+    void* block = pool->allocate();
+    int local = 0;
+    pool->deallocate(&local);
+    pool->deallocate(static_cast<char*>(block) + 1);
+    EXPECT_EQ(pool->to_offset(&local), Pool::INVALID_OFFSET);
+    EXPECT_EQ(pool->live_blocks(), 1U);
+    pool.reset();
+    std::remove(path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Recovery after an unclean shutdown
+// ---------------------------------------------------------------------------
+
+#if !defined(_WIN32)
+TEST(PersistentPool_CrashTriggersValidatingRecovery) {
+    const std::string path = temp_pool_path("crash");
+    Pool::create(path, 4).reset();
+
+    EXPECT_TRUE(run_and_crash(path, [](Pool& pool) {
+        void* first = pool.allocate();
+        for (int i = 1; i < 3000; ++i) {
+            pool.allocate();
+        }
+        pool.deallocate(first);
+    }));
+
+    auto pool = Pool::open(path);
+    EXPECT_TRUE(pool->recovery().mode == RecoveryMode::Validated);
+    EXPECT_EQ(pool->recovery().repaired_pages, 0U);
+    EXPECT_EQ(pool->live_blocks(), 2999U);
+    pool.reset();
+
+    // The destructor above shut down cleanly again.
+    pool = Pool::open(path);
+    EXPECT_TRUE(pool->recovery().mode == RecoveryMode::CleanRestart);
+    pool.reset();
+    std::remove(path.c_str());
+}
+
+TEST(PersistentPool_ValidationCutsCorruptFreeList) {
+    const std::string path = temp_pool_path("corrupt");
+    Pool::create(path, 1).reset();
+
+    // Free blocks 0 and 1 (list: 1 -> 0), then point block 0 back at 1 to form a cycle.
+    EXPECT_TRUE(run_and_crash(path, [](Pool& pool) {
+        void* first = pool.allocate();
+        void* second = pool.allocate();
+        for (int i = 2; i < 11; ++i) {
+            pool.allocate();
+        }
+        pool.deallocate(first);
+        pool.deallocate(second);
+        *static_cast<uint32_t*>(first) = 1;
+    }));
+
+    auto pool = Pool::open(path);
+    EXPECT_TRUE(pool->recovery().mode == RecoveryMode::Validated);
+    EXPECT_EQ(pool->recovery().repaired_pages, 1U);
+    EXPECT_EQ(pool->live_blocks(), 9U);
+
+    std::set<void*> handed_out;
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(handed_out.insert(pool->allocate()).second);
+    }
+    pool.reset();
+    std::remove(path.c_str());
+}
+#endif
@@ -3,8 +3,17 @@
 
 #include <cstring>
 
+using cma::commit_region;
+using cma::decommit_region;
 using cma::map_page;
+using cma::peak_resident_bytes;
+using cma::process_memory;
+using cma::MappedRange;
+using cma::release_region;
+using cma::reserve_region;
+using cma::resident_bytes;
 using cma::unmap_page;
+using cma::unmap_pages;
 
 TEST(PlatformMemory_MapPage_MemoryIsWritable) {
     void* page = map_page(4096);
@@ -58,3 +67,70 @@ TEST(PlatformMemory_RemappedRegionIsWritableAfterPriorUnmap) {
     EXPECT_EQ(static_cast<unsigned char*>(second)[0], 0x5A);
     unmap_page(second, 4096);
 }
+
+TEST(PlatformMemory_ReservedRegionIsWritableOnceCommitted) {
+    const size_t region_size = 16 * 65536;
+    auto* region = static_cast<unsigned char*>(reserve_region(region_size));
+    EXPECT_NOT_NULL(region);
+
+    unsigned char* page = region + 3 * 65536;
+    EXPECT_TRUE(commit_region(page, 65536));
+    std::memset(page, 0x3C, 65536);
+    EXPECT_EQ(page[65535], 0x3C);
+
+    // Decommitting drops the contents; recommitting yields zeroed memory.
+    decommit_region(page, 65536);
+    EXPECT_TRUE(commit_region(page, 65536));
+    EXPECT_EQ(page[0], 0);
+
+    release_region(region, region_size);
+}
+
+TEST(PlatformMemory_ReleaseAndDecommitNullAreNoOps) {
+    decommit_region(nullptr, 4096);
+    release_region(nullptr, 4096);
+}
+
+TEST(PlatformMemory_UnmapPagesHandlesSeparateMappings) {
+    MappedRange ranges[4];
+    for (MappedRange& range : ranges) {
+        range.size = 65536;
+        range.base = map_page(range.size);
+        EXPECT_NOT_NULL(range.base);
+    }
+    const size_t calls = unmap_pages(ranges, 4);
+    EXPECT_GE(calls, 1U);
+    EXPECT_LE(calls, 4U);
+}
+
+#if !defined(_WIN32)
+TEST(PlatformMemory_UnmapPagesMergesAdjacentRanges) {
+    auto* base = static_cast<char*>(map_page(3 * 4096));
+    EXPECT_NOT_NULL(base);
+    // Out of order on purpose: the ranges are sorted before merging.
+    MappedRange ranges[3] = {{base + 8192, 4096}, {base, 4096}, {base + 4096, 4096}};
+    EXPECT_EQ(unmap_pages(ranges, 3), 1U);
+}
+#endif
+
+#if defined(__linux__)
+TEST(PlatformMemory_ResidentBytesTrackTouchedPages) {
+    constexpr size_t size = 16 * 1024 * 1024;
+    const size_t before = resident_bytes();
+    const size_t virtual_before = process_memory().virtual_bytes;
+    EXPECT_TRUE(before > 0);
+    auto* region = static_cast<char*>(map_page(size));
+    EXPECT_NOT_NULL(region);
+    for (size_t offset = 0; offset < size; offset += 4096) {
+        region[offset] = 1;
+    }
+    const size_t resident = resident_bytes();
+    EXPECT_GE(resident, before + size / 2);
+    // Read after the current RSS, which may still grow (TSan maps shadow pages).
+    EXPECT_GE(peak_resident_bytes(), resident);
+    const cma::ProcessMemory now = process_memory();
+    EXPECT_GE(now.resident_bytes, before + size / 2);
+    EXPECT_GE(now.virtual_bytes, virtual_before + size);
+    unmap_page(region, size);
+}
+#endif
@@ -0,0 +1,216 @@
+#include "SharedBlockPool.hpp"
+#include "test_runner.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Pool = cma::SharedBlockPool<64>;
+
+// Names must be unique per run so a crashed earlier run cannot collide.
+std::string unique_pool_name(const char* tag) {
+#if defined(_WIN32)
+    return std::string("cma_test_") + tag;
+#else
+    return std::string("/cma_test_") + tag + "_" + std::to_string(getpid());
+#endif
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Create / open
+// ---------------------------------------------------------------------------
+
+TEST(SharedPool_CreateAllocateAndFree) {
+    const std::string name = unique_pool_name("basic");
+    auto pool = Pool::create(name, 128);
+    EXPECT_NOT_NULL(pool);
+
+    void* block = pool->allocate();
+    EXPECT_NOT_NULL(block);
+    EXPECT_TRUE(pool->owns(block));
+    EXPECT_EQ(pool->live_blocks(), 1U);
+
+    pool->deallocate(block);
+    EXPECT_EQ(pool->live_blocks(), 0U);
+    EXPECT_EQ(pool->allocate(), block);
+
+    Pool::remove(name);
+}
+
+TEST(SharedPool_CreateFailsWhenNameExists) {
+    const std::string name = unique_pool_name("dup");
+    auto pool = Pool::create(name, 16);
+    EXPECT_NOT_NULL(pool);
+    EXPECT_NULL(Pool::create(name, 16));
+    Pool::remove(name);
+}
+
+TEST(SharedPool_OpenRejectsMissingOrMismatchedPool) {
+    const std::string name = unique_pool_name("mismatch");
+    EXPECT_NULL(Pool::open(name));
+
+    auto pool = cma::SharedBlockPool<32>::create(name, 16);
+    EXPECT_NOT_NULL(pool);
+    EXPECT_NULL(Pool::open(name));
+    Pool::remove(name);
+}
+
+TEST(SharedPool_ExhaustionReturnsNullUntilBlockFreed) {
+    const std::string name = unique_pool_name("full");
+    auto pool = Pool::create(name, 8);
+    std::vector<void*> blocks;
+    for (int i = 0; i < 8; ++i) {
+        blocks.push_back(pool->allocate());
+        EXPECT_NOT_NULL(blocks.back());
+    }
+    EXPECT_NULL(pool->allocate());
+
+    pool->deallocate(blocks[3]);
+    EXPECT_EQ(pool->allocate(), blocks[3]);
+
+    for (void* block : blocks) {
+        pool->deallocate(block);
+    }
+    EXPECT_EQ(pool->live_blocks(), 0U);
+    Pool::remove(name);
+}
+
+// ---------------------------------------------------------------------------
+// Offsets across mappings
+// ---------------------------------------------------------------------------
+
+TEST(SharedPool_OffsetsResolveInSecondMapping) {
+    const std::string name = unique_pool_name("offsets");
+    auto creator = Pool::create(name, 64);
+    auto attached = Pool::open(name);
+    EXPECT_NOT_NULL(attached);
+    EXPECT_EQ(attached->capacity_blocks(), 64U);
+
+    void* block = creator->allocate();
+    std::memcpy(block, "hello", 6);
+    const uint64_t offset = creator->to_offset(block);
+    EXPECT_NE(offset, Pool::INVALID_OFFSET);
+
+    // The second mapping sees the same bytes at its own address.
+    void* same = attached->from_offset(offset);
+    EXPECT_NOT_NULL(same);
+    EXPECT_NE(same, block);
+    EXPECT_EQ(std::strcmp(static_cast<char*>(same), "hello"), 0);
+
+    attached->deallocate(same);
+    EXPECT_EQ(creator->live_blocks(), 0U);
+    EXPECT_EQ(creator->allocate(), block);
+    Pool::remove(name);
+}
+
+TEST(SharedPool_RootSlotsAreShared) {
+    const std::string name = unique_pool_name("roots");
+    auto creator = Pool::create(name, 4);
+    auto attached = Pool::open(name);
+    creator->root(2).store(12345);
+    EXPECT_EQ(attached->root(2).load(), 12345U);
+    Pool::remove(name);
+}
+
+TEST(SharedPool_ForeignPointersAreIgnored) {
+    const std::string name = unique_pool_name("foreign");
+    auto pool = Pool::create(name, 4);
+    int local = 0;
+    pool->deallocate(&local);
+    pool->deallocate(nullptr);
+    EXPECT_EQ(pool->to_offset(&local), Pool::INVALID_OFFSET);
+    EXPECT_NULL(pool->from_offset(4 * 64));
+    EXPECT_EQ(pool->live_blocks(), 0U);
+    Pool::remove(name);
+}
+
+// ---------------------------------------------------------------------------
+// Concurrency
+// ---------------------------------------------------------------------------
+
+TEST(SharedPool_ThreadsThroughSeparateMappingsNeverShareBlocks) {
+    const std::string name = unique_pool_name("threads");
+    constexpr size_t kThreads = 4;
+    constexpr size_t kPerThread = 256;
+    auto creator = Pool::create(name, kThreads * kPerThread);
+
+    std::atomic<bool> corrupted{false};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            auto pool = Pool::open(name);
+            std::vector<uint64_t*> held;
+            for (int round = 0; round < 50; ++round) {
+                for (size_t i = 0; i < kPerThread; ++i) {
+                    auto* block = static_cast<uint64_t*>(pool->allocate());
+                    if (block == nullptr) {
+                        corrupted = true;
+                        return;
+                    }
+                    block[1] = t;
+                    held.push_back(block);
+                }
+                for (uint64_t* block : held) {
+                    if (block[1] != t) {
+                        corrupted = true;
+                    }
+                    pool->deallocate(block);
+                }
+                held.clear();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(corrupted.load());
+    EXPECT_EQ(creator->live_blocks(), 0U);
+    Pool::remove(name);
+}
+
+#if !defined(_WIN32)
+TEST(SharedPool_ChildProcessAllocatesParentFrees) {
+    const std::string name = unique_pool_name("fork");
+    auto pool = Pool::create(name, 64);
+
+    const pid_t child = fork();
+    if (child == 0) {
+        // Attach by name like an unrelated process would.
+        auto attached = Pool::open(name);
+        int status = attached ? 0 : 1;
+        for (int i = 0; attached && i < 10; ++i) {
+            auto* block = static_cast<uint32_t*>(attached->allocate());
+            block[1] = 1000U + i;
+            attached->root(0).fetch_add(1);
+        }
+        _exit(status);
+    }
+
+    int status = -1;
+    waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(pool->root(0).load(), 10U);
+    EXPECT_EQ(pool->live_blocks(), 10U);
+
+    for (int i = 0; i < 10; ++i) {
+        auto* block = static_cast<uint32_t*>(pool->from_offset(static_cast<uint64_t>(i) * 64));
+        EXPECT_EQ(block[1], 1000U + i);
+        pool->deallocate(block);
+    }
+    EXPECT_EQ(pool->live_blocks(), 0U);
+    Pool::remove(name);
+}
+#endif
@@ -0,0 +1,206 @@
+#pragma once
+
+// Multi-threaded allocator stress tests in the style of the classic suites:
+// Larson (server-like lifetimes, blocks freed by a later thread), Hoard's
+// cache-thrash and cache-scratch (allocator-induced false sharing) and
+// threadtest, and a sh6bench-style LIFO/FIFO mix. Every block has the one
+// size the hooks allocate, so the originals' random size ranges are dropped.
+// As in handoff_workloads.hpp the drivers are allocator-agnostic; a Hooks
+// object supplies:
+//
+//   void* allocate();
+//   void deallocate(void* block);
+//   void thread_done(unsigned long long checksum);
+//
+// Each driver runs about @p total allocations split over @p threads threads.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace stress {
+
+// Volatile word stores to a block, as the original benchmarks do, so the
+// writes reach the cache line instead of being folded away.
+constexpr size_t kWritesPerObject = 32;
+// Live blocks per Larson thread, and Larson thread generations per run.
+constexpr size_t kLarsonSlots = 1000;
+constexpr size_t kLarsonGenerations = 4;
+// Blocks each thread allocates before freeing them all (threadtest) and the
+// batch sh6bench-style rounds work on.
+constexpr size_t kThreadtestBatch = 1000;
+constexpr size_t kSh6Batch = 256;
+
+inline unsigned long long write_object(void* block, size_t writes) {
+    volatile unsigned char* bytes = static_cast<unsigned char*>(block);
+    for (size_t i = 0; i < writes; ++i) {
+        bytes[i % sizeof(uint64_t)] = static_cast<unsigned char>(bytes[i % sizeof(uint64_t)] + 1U);
+    }
+    return bytes[0];
+}
+
+inline uint64_t next_random(uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 33U;
+}
+
+template <typename Body>
+void run_threads(unsigned int threads, Body body) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned int t = 0; t < threads; ++t) {
+        workers.emplace_back(body, t);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// cache-thrash: each thread allocates a block, writes it, and frees it. An
+// allocator that hands neighbouring blocks to different threads makes them
+// write the same cache line (active false sharing).
+template <typename Hooks>
+void run_cache_thrash(size_t total, unsigned int threads, Hooks& hooks) {
+    const size_t per_thread = total / threads;
+    run_threads(threads, [&hooks, per_thread](unsigned int) {
+        unsigned long long checksum = 0;
+        for (size_t i = 0; i < per_thread; ++i) {
+            void* block = hooks.allocate();
+            checksum += write_object(block, kWritesPerObject);
+            hooks.deallocate(block);
+        }
+        hooks.thread_done(checksum);
+    });
+}
+
+// cache-scratch: one thread allocates a block per worker, back to back, and
+// each worker frees its block before running the cache-thrash loop. An
+// allocator that reuses the freed block keeps the workers on the lines the
+// first thread carved up (passive false sharing).
+template <typename Hooks>
+void run_cache_scratch(size_t total, unsigned int threads, Hooks& hooks) {
+    const size_t per_thread = total / threads;
+    std::vector<void*> seeds(threads);
+    for (void*& seed : seeds) {
+        seed = hooks.allocate();
+    }
+    run_threads(threads, [&hooks, &seeds, per_thread](unsigned int t) {
+        unsigned long long checksum = write_object(seeds[t], kWritesPerObject);
+        hooks.deallocate(seeds[t]);
+        for (size_t i = 1; i < per_thread; ++i) {
+            void* block = hooks.allocate();
+            checksum += write_object(block, kWritesPerObject);
+            hooks.deallocate(block);
+        }
+        hooks.thread_done(checksum);
+    });
+    hooks.thread_done(0);
+}
+
+// threadtest: rounds of allocating a batch of blocks, then freeing them all.
+template <typename Hooks>
+void run_threadtest(size_t total, unsigned int threads, Hooks& hooks) {
+    const size_t rounds = std::max<size_t>(total / (static_cast<size_t>(threads) * kThreadtestBatch), 1);
+    run_threads(threads, [&hooks, rounds](unsigned int) {
+        std::vector<void*> batch(kThreadtestBatch);
+        unsigned long long checksum = 0;
+        for (size_t round = 0; round < rounds; ++round) {
+            for (void*& block : batch) {
+                block = hooks.allocate();
+                checksum += write_object(block, 1);
+            }
+            for (void* block : batch) {
+                hooks.deallocate(block);
+            }
+        }
+        hooks.thread_done(checksum);
+    });
+}
+
+// Larson: each thread owns kLarsonSlots live blocks and replaces a random one
+// per step. After its share of steps it exits, and a new thread inherits the
+// slots, so most blocks are freed by a later thread than the one that
+// allocated them. The slots start filled by the calling thread.
+template <typename Hooks>
+void run_larson(size_t total, unsigned int threads, Hooks& hooks) {
+    const size_t steps = total / (static_cast<size_t>(threads) * kLarsonGenerations);
+    std::vector<std::vector<void*>> slots(threads, std::vector<void*>(kLarsonSlots));
+    for (std::vector<void*>& owned : slots) {
+        for (void*& block : owned) {
+            block = hooks.allocate();
+        }
+    }
+    for (size_t generation = 0; generation < kLarsonGenerations; ++generation) {
+        run_threads(threads, [&hooks, &slots, steps, generation](unsigned int t) {
+            std::vector<void*>& owned = slots[t];
+            uint64_t state = (generation + 1U) * 0x9E3779B97F4A7C15ULL + t;
+            unsigned long long checksum = 0;
+            for (size_t i = 0; i < steps; ++i) {
+                void*& block = owned[next_random(state) % kLarsonSlots];
+                hooks.deallocate(block);
+                block = hooks.allocate();
+                checksum += write_object(block, 1);
+            }
+            hooks.thread_done(checksum);
+        });
+    }
+    for (std::vector<void*>& owned : slots) {
+        for (void* block : owned) {
+            hooks.deallocate(block);
+        }
+    }
+    hooks.thread_done(0);
+}
+
+// sh6bench-style mix: fill a batch, free every other block newest first
+// (LIFO), refill the holes, then free the whole batch oldest first (FIFO).
+template <typename Hooks>
+void run_sh6bench(size_t total, unsigned int threads, Hooks& hooks) {
+    const size_t per_round = kSh6Batch + kSh6Batch / 2;
+    const size_t rounds = std::max<size_t>(total / (static_cast<size_t>(threads) * per_round), 1);
+    run_threads(threads, [&hooks, rounds](unsigned int) {
+        std::vector<void*> batch(kSh6Batch);
+        unsigned long long checksum = 0;
+        for (size_t round = 0; round < rounds; ++round) {
+            for (void*& block : batch) {
+                block = hooks.allocate();
+                checksum += write_object(block, 1);
+            }
+            for (size_t i = kSh6Batch - 1; i < kSh6Batch; i -= 2) {
+                hooks.deallocate(batch[i]);
+            }
+            for (size_t i = 1; i < kSh6Batch; i += 2) {
+                batch[i] = hooks.allocate();
+                checksum += write_object(batch[i], 1);
+            }
+            for (void* block : batch) {
+                hooks.deallocate(block);
+            }
+        }
+        hooks.thread_done(checksum);
+    });
+}
+
+// Blocks an allocation count actually maps to, since the drivers round to
+// whole rounds and steps.
+inline size_t cache_allocations(size_t total, unsigned int threads) {
+    return total / threads * threads;
+}
+
+inline size_t threadtest_allocations(size_t total, unsigned int threads) {
+    return std::max<size_t>(total / (static_cast<size_t>(threads) * kThreadtestBatch), 1) * threads *
+           kThreadtestBatch;
+}
+
+inline size_t larson_allocations(size_t total, unsigned int threads) {
+    return total / (static_cast<size_t>(threads) * kLarsonGenerations) * threads * kLarsonGenerations;
+}
+
+inline size_t sh6bench_allocations(size_t total, unsigned int threads) {
+    const size_t per_round = kSh6Batch + kSh6Batch / 2;
+    return std::max<size_t>(total / (static_cast<size_t>(threads) * per_round), 1) * threads * per_round;
+}
+
+} // namespace stress
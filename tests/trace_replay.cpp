@@ -0,0 +1,476 @@
+#include "trace_replay.hpp"
+
+#include "FixedBlockAllocator.hpp"
+#include "alloc_trace.hpp"
+#include "allocator_plugins.hpp"
+#include "bench_harness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr size_t kTouchStride = 4096;
+
+void print_replay_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name << " replay --trace file [--allocator name] [--convert out]\n"
+              << "       " << prog_name << " replay --generate file [--threads N] [--events N]\n\n"
+              << "Replays a binary or text alloc/free trace with one thread per traced thread,\n"
+              << "keeping each thread's order and making a free wait for its allocation when\n"
+              << "another thread made it. --allocator picks custom, system, a plugin name, or all\n"
+              << "(default). --convert writes the loaded trace back out (.txt for text).\n"
+              << "--generate writes a synthetic multi-threaded trace for trying the tool out.\n";
+}
+
+bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+double to_mb(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// Writes one byte per 4 KB page, as filling the object would.
+inline void touch_object(void* object, uint64_t size) {
+    auto* bytes = static_cast<unsigned char*>(object);
+    for (uint64_t offset = 0; offset < size; offset += kTouchStride) {
+        bytes[offset] = static_cast<unsigned char>(offset);
+    }
+    if (size != 0) {
+        bytes[size - 1] = 1;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Backends
+// ---------------------------------------------------------------------------
+
+/**
+ * FixedBlockAllocator used as a general-purpose allocator: one pool per
+ * power-of-two size class from 16 bytes to 4 KB. Larger requests go to
+ * std::malloc and are counted, since a 64 KB page holds too few of them.
+ */
+template <size_t... Sizes>
+class SizeClassPools {
+public:
+    static constexpr size_t kClassSizes[] = {Sizes...};
+    static constexpr size_t kClassCount = sizeof...(Sizes);
+
+    void* allocate(uint64_t size) {
+        const size_t size_class = class_of(size);
+        if (size_class == kClassCount) {
+            m_oversize_allocations.fetch_add(1, std::memory_order_relaxed);
+            m_oversize_bytes.fetch_add(size, std::memory_order_relaxed);
+            return std::malloc(size);
+        }
+        return allocate_in<0>(size_class);
+    }
+
+    void deallocate(void* block, uint64_t size) {
+        const size_t size_class = class_of(size);
+        if (size_class == kClassCount) {
+            m_oversize_bytes.fetch_sub(size, std::memory_order_relaxed);
+            std::free(block);
+            return;
+        }
+        deallocate_in<0>(size_class, block);
+    }
+
+    void thread_done() {
+        std::apply([](auto&... pools) { (pools.flush_local_thread_cache(), ...); }, m_pools);
+    }
+
+    // Pool pages plus live oversize bytes (which malloc maps at least).
+    size_t mapped_bytes() const {
+        size_t total = m_oversize_bytes.load(std::memory_order_relaxed);
+        std::apply([&total](const auto&... pools) { ((total += pools.stats().mapped_bytes), ...); }, m_pools);
+        return total;
+    }
+
+    bool mapped_known() const {
+        return true;
+    }
+
+    std::string note() const {
+        return std::to_string(m_oversize_allocations.load(std::memory_order_relaxed)) + " allocations over " +
+               std::to_string(kClassSizes[kClassCount - 1]) + " B sent to malloc";
+    }
+
+private:
+    static size_t class_of(uint64_t size) {
+        size_t size_class = 0;
+        while (size_class < kClassCount && kClassSizes[size_class] < size) {
+            ++size_class;
+        }
+        return size_class;
+    }
+
+    template <size_t I>
+    void* allocate_in(size_t size_class) {
+        if constexpr (I + 1 < kClassCount) {
+            if (size_class != I) {
+                return allocate_in<I + 1>(size_class);
+            }
+        }
+        return std::get<I>(m_pools).allocate();
+    }
+
+    template <size_t I>
+    void deallocate_in(size_t size_class, void* block) {
+        if constexpr (I + 1 < kClassCount) {
+            if (size_class != I) {
+                deallocate_in<I + 1>(size_class, block);
+                return;
+            }
+        }
+        std::get<I>(m_pools).deallocate(block);
+    }
+
+    std::tuple<cma::FixedBlockAllocator<Sizes>...> m_pools;
+    std::atomic<size_t> m_oversize_allocations{0};
+    std::atomic<size_t> m_oversize_bytes{0};
+};
+
+using CustomBackend = SizeClassPools<16, 32, 64, 128, 256, 512, 1024, 2048, 4096>;
+
+class MallocBackend {
+public:
+    explicit MallocBackend(const bench::MallocApi& api) : m_api(api) {}
+
+    void* allocate(uint64_t size) {
+        return m_api.malloc_fn(size);
+    }
+
+    void deallocate(void* block, uint64_t) {
+        m_api.free_fn(block);
+    }
+
+    void thread_done() {}
+
+    // glibc's own view (arena + mmapped chunks); unknown for plugins.
+    size_t mapped_bytes() const {
+        return bench::mapped_bytes(m_api);
+    }
+
+    bool mapped_known() const {
+        return bench::mapped_bytes_known(m_api);
+    }
+
+    std::string note() const {
+        return m_api.library.empty() ? std::string() : m_api.library;
+    }
+
+private:
+    const bench::MallocApi& m_api;
+};
+
+// ---------------------------------------------------------------------------
+// Replay
+// ---------------------------------------------------------------------------
+
+struct ReplayResult {
+    double seconds = 0.0;
+    bench::MemoryFootprint memory;  // mapped bytes are above what the backend had before the replay
+};
+
+template <typename Backend>
+ReplayResult replay(const alloc_trace::ReplayPlan& plan, Backend& backend) {
+    // slots[i] holds object i between its allocation and its free; a free
+    // waits here when another thread has not allocated the object yet.
+    std::unique_ptr<std::atomic<void*>[]> slots(new std::atomic<void*>[plan.sizes.size()]);
+    for (size_t i = 0; i < plan.sizes.size(); ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    std::vector<bool> freed(plan.sizes.size(), false);
+    for (const std::vector<alloc_trace::ReplayOp>& ops : plan.threads) {
+        for (const alloc_trace::ReplayOp& op : ops) {
+            if (op.free) {
+                freed[op.object] = true;
+            }
+        }
+    }
+
+    ReplayResult result;
+    // malloc's arena already holds the plan itself; the sampler counts only
+    // what the replay adds.
+    std::function<size_t()> mapped_bytes;
+    if (backend.mapped_known()) {
+        mapped_bytes = [&backend]() { return backend.mapped_bytes(); };
+    }
+    bench::MemorySampler sampler(mapped_bytes);
+
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> workers;
+    workers.reserve(plan.threads.size());
+    for (const std::vector<alloc_trace::ReplayOp>& ops : plan.threads) {
+        workers.emplace_back([&, &ops = ops]() {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (const alloc_trace::ReplayOp& op : ops) {
+                const uint64_t size = plan.sizes[op.object];
+                if (!op.free) {
+                    void* object = backend.allocate(size);
+                    touch_object(object, size);
+                    slots[op.object].store(object, std::memory_order_release);
+                    continue;
+                }
+                void* object = slots[op.object].load(std::memory_order_acquire);
+                while (object == nullptr) {
+                    std::this_thread::yield();
+                    object = slots[op.object].load(std::memory_order_acquire);
+                }
+                backend.deallocate(object, size);
+            }
+            backend.thread_done();
+        });
+    }
+
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.memory = sampler.stop();
+
+    // Objects the trace never frees are released untimed.
+    for (size_t i = 0; i < plan.sizes.size(); ++i) {
+        if (!freed[i]) {
+            backend.deallocate(slots[i].load(std::memory_order_relaxed), plan.sizes[i]);
+        }
+    }
+    backend.thread_done();
+    return result;
+}
+
+void print_header() {
+    std::cout << std::left << std::setw(10) << "allocator" << std::right << std::setw(10) << "time ms" << std::setw(10)
+              << "Mops/s" << std::setw(12) << "mapped MB" << std::setw(11) << "RSS0 MB" << std::setw(11)
+              << "peak RSS" << std::setw(11) << "RSS grow" << "  note\n";
+}
+
+template <typename Backend>
+void replay_and_print(const std::string& name, const alloc_trace::ReplayPlan& plan, Backend& backend) {
+    const ReplayResult result = replay(plan, backend);
+    const size_t ops = plan.allocations + plan.frees;
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << result.seconds * 1000.0 << std::setw(10)
+              << (result.seconds > 0.0 ? static_cast<double>(ops) / result.seconds / 1e6 : 0.0) << std::setw(12);
+    const bench::MemoryFootprint& memory = result.memory;
+    if (memory.mapped_known) {
+        std::cout << to_mb(memory.peak_mapped_bytes);
+    } else {
+        std::cout << "n/a";
+    }
+    std::cout << std::setw(11) << to_mb(memory.rss_before) << std::setw(11) << to_mb(memory.peak_rss)
+              << std::setw(11) << to_mb(memory.rss_growth()) << "  " << backend.note()
+              << (memory.peak_rss_reset ? "" : " (peak RSS not reset)") << "\n";
+}
+
+void replay_one(const std::string& name, const alloc_trace::ReplayPlan& plan) {
+    if (name == "custom") {
+        CustomBackend backend;
+        replay_and_print(name, plan, backend);
+        return;
+    }
+    if (name == "system") {
+        MallocBackend backend(bench::system_malloc());
+        replay_and_print(name, plan, backend);
+        return;
+    }
+    for (const bench::MallocApi& plugin : bench::allocator_plugins()) {
+        if (plugin.name == name) {
+            MallocBackend backend(plugin);
+            replay_and_print(name, plan, backend);
+            return;
+        }
+    }
+    std::cout << std::left << std::setw(10) << name << "  not available\n";
+}
+
+// Runs each allocator in its own child process so one allocator's retained
+// memory does not show up in the next one's RSS.
+void replay_isolated(const std::string& name, const alloc_trace::ReplayPlan& plan) {
+#if defined(_WIN32)
+    replay_one(name, plan);
+#else
+    std::cout.flush();
+    const pid_t child = fork();
+    if (child == 0) {
+        replay_one(name, plan);
+        std::cout.flush();
+        _exit(0);
+    }
+    if (child < 0) {
+        replay_one(name, plan);
+        return;
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cout << std::left << std::setw(10) << name << "  replay process failed\n";
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic traces
+// ---------------------------------------------------------------------------
+
+/**
+ * A service-like pattern: mostly small objects, a few large ones, each thread
+ * freeing its own objects except for ~15% handed to another thread, and ~1%
+ * of objects never freed.
+ */
+std::vector<alloc_trace::Event> generate_trace(unsigned int threads, size_t events) {
+    static constexpr uint64_t kSizes[] = {16, 24, 32, 48, 64, 96, 128, 192, 256, 512, 1024, 4096, 16384};
+    static constexpr unsigned int kWeights[] = {18, 14, 16, 10, 10, 6, 8, 4, 5, 4, 3, 1, 1};
+    std::mt19937_64 rng(42);
+    std::discrete_distribution<size_t> pick_size(std::begin(kWeights), std::end(kWeights));
+    std::uniform_int_distribution<unsigned int> pick_thread(0, threads - 1);
+    std::uniform_int_distribution<uint64_t> pick_gap(1, 200);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+    std::vector<std::vector<uint64_t>> live(threads);
+    std::vector<alloc_trace::Event> trace;
+    trace.reserve(events);
+    uint64_t now = 0;
+    uint64_t next_object = 1;
+    while (trace.size() < events) {
+        now += pick_gap(rng);
+        const unsigned int thread = pick_thread(rng);
+        // Grow to a working set, then hover around it.
+        const bool allocate = live[thread].size() < 64 || coin(rng) < 0.5;
+        if (allocate) {
+            const uint64_t object = next_object++;
+            trace.push_back(alloc_trace::Event{now, thread, alloc_trace::Op::Alloc, object, kSizes[pick_size(rng)]});
+            if (coin(rng) >= 0.01) {
+                const unsigned int owner = coin(rng) < 0.15 ? pick_thread(rng) : thread;
+                live[owner].push_back(object);
+            }
+            continue;
+        }
+        std::vector<uint64_t>& mine = live[thread];
+        const size_t index = static_cast<size_t>(rng() % mine.size());
+        trace.push_back(alloc_trace::Event{now, thread, alloc_trace::Op::Free, mine[index], 0});
+        mine[index] = mine.back();
+        mine.pop_back();
+    }
+    return trace;
+}
+
+bool write_trace(const std::string& path, const std::vector<alloc_trace::Event>& events, std::string& error) {
+    return ends_with(path, ".txt") ? alloc_trace::write_text_trace(path, events, error)
+                                   : alloc_trace::write_binary_trace(path, events, error);
+}
+
+} // namespace
+
+int run_trace_replay(int argc, char* argv[]) {
+    std::string trace_path;
+    std::string generate_path;
+    std::string convert_path;
+    std::string allocator = "all";
+    unsigned int threads = 4;
+    size_t events = 2'000'000;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--generate" && i + 1 < argc) {
+            generate_path = argv[++i];
+        } else if (arg == "--convert" && i + 1 < argc) {
+            convert_path = argv[++i];
+        } else if (arg == "--allocator" && i + 1 < argc) {
+            allocator = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--events" && i + 1 < argc) {
+            events = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            print_replay_usage(argv[0]);
+            return 1;
+        }
+    }
+    std::string error;
+
+    if (!generate_path.empty()) {
+        if (threads == 0 || events == 0) {
+            print_replay_usage(argv[0]);
+            return 1;
+        }
+        if (!write_trace(generate_path, generate_trace(threads, events), error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "wrote " << events << " events on " << threads << " threads to " << generate_path << "\n";
+        return 0;
+    }
+    if (trace_path.empty()) {
+        print_replay_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<alloc_trace::Event> trace;
+    if (!alloc_trace::read_trace(trace_path, trace, error)) {
+        std::cerr << "Error: " << trace_path << ": " << error << "\n";
+        return 1;
+    }
+    if (!convert_path.empty()) {
+        if (!write_trace(convert_path, trace, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "wrote " << trace.size() << " events to " << convert_path << "\n";
+    }
+    const alloc_trace::ReplayPlan plan = alloc_trace::build_replay_plan(trace);
+    trace.clear();
+    trace.shrink_to_fit();
+
+    std::cout << "\n" << std::string(72, '=') << "\n";
+    std::cout << "  Trace replay: " << trace_path << "\n";
+    std::cout << std::string(72, '=') << "\n";
+    std::cout << plan.threads.size() << " threads, " << plan.allocations << " allocs, " << plan.frees << " frees ("
+              << plan.cross_thread_frees << " cross-thread), " << plan.dropped_frees << " unmatched frees dropped, "
+              << plan.leaked << " never freed, peak live " << std::fixed << std::setprecision(1)
+              << to_mb(plan.peak_live_bytes) << " MB requested\n";
+    std::cout << std::string(72, '-') << "\n";
+    print_header();
+
+    std::vector<std::string> names;
+    if (allocator == "all") {
+        names = {"custom", "system"};
+        for (const bench::MallocApi& plugin : bench::allocator_plugins()) {
+            names.push_back(plugin.name);
+        }
+    } else {
+        names = {allocator};
+    }
+    for (const std::string& name : names) {
+        replay_isolated(name, plan);
+    }
+    std::cout << std::string(72, '=') << "\n";
+    return 0;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Runs: allocator_test replay --trace file [--allocator name]
+//       allocator_test replay --generate file [--threads N] [--events N]
+// Replays a recorded alloc/free trace (see alloc_trace.hpp) on one thread per
+// traced thread, against size-class pools of FixedBlockAllocator, system
+// malloc and any allocator plugins, and reports time, peak mapped bytes and
+// peak RSS for each.
+int run_trace_replay(int argc, char* argv[]);